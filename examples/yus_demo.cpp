@@ -3,206 +3,358 @@
  * @brief YuS流密码演示程序
  * @author Aurorp1g
  * @date 2025-11-07
- * 
+ *
  * YuS流密码的完整演示程序，展示从素数生成、密钥初始化到同态评估的完整流程。
- * 包含内存使用监控、进度显示和错误处理功能，支持Windows和Linux平台。
+ * 不等待输入，所有参数由命令行给出，便于脚本化的吞吐量测量：
+ * 进度和各阶段的耗时、常驻内存输出到stderr，结果以单个JSON对象输出到stdout。
+ * 同态评估的解密结果逐块与明文密钥流比较，不一致时以状态1退出。
+ *
+ * 用法：yus_example [选项]
+ *   --p P                  素数模数（默认按--p-bits生成满足p ≡ 2 mod 3、p ≡ 1 mod 2N的素数）
+ *   --p-bits B             生成素数的位数（默认17）
+ *   --level 80|128         安全级别（默认80）
+ *   --trunc M              截断位数（默认12）
+ *   --blocks B             块数（默认0：同态评估填满所有槽，仅明文时为1）
+ *   --scheme bgv|bfv|none  同态方案（默认bfv），none只运行明文密钥流
+ *   --n N                  环维数（默认0，自动选择；生成素数时按16384）
+ *   --packing row|column   槽打包方式（默认row，column仅BFV）
+ *   --threads T            明文OpenMP线程数和同态评估工作线程数（默认0，即硬件并发数）
+ *   --reps R               明文密钥流生成和同态评估的计时次数（默认1）
  */
 
 #include "yus/yus_core.h"
 #include "yus/fhe_wrapper.h"
+#include "yus/timing.h"
 #include "yus/utils.h"
+#include "cli_utils.h"
+#include <algorithm>
 #include <iostream>
-#include <chrono>
-#include <thread>
-#include <cstdlib>
-
-#ifdef _WIN32
-#include <windows.h>
-#include <psapi.h>
-#else
-#include <sys/resource.h>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
 #endif
 
+namespace {
+
+using yus::cli::json_string;
+using yus::cli::parse_number;
+
+/// 未指定环维数时生成素数所按的N（与原演示程序一致）
+constexpr uint32_t kDefaultPrimeDegree = 16384;
+
 /**
- * @brief 打印内存使用情况
- * @param stage 当前执行阶段标识
- * 
- * 监控程序在不同阶段的内存使用情况，支持Windows和Linux平台。
- * Windows平台显示工作集和页面文件使用量，Linux平台显示最大驻留集大小。
+ * @struct DemoOptions
+ * @brief 演示程序的命令行选项
  */
-void print_memory_usage(const std::string& stage) {
-#ifdef _WIN32
-    PROCESS_MEMORY_COUNTERS pmc;
-    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) {
-        std::cout << "[MEMORY] " << stage << " - Working Set: " 
-                  << pmc.WorkingSetSize / 1024 / 1024 << " MB, Pagefile: " 
-                  << pmc.PagefileUsage / 1024 / 1024 << " MB" << std::endl;
+struct DemoOptions {
+    mpz_class p = 0;                ///< 素数模数，为0时按p_bits生成
+    uint32_t p_bits = 17;           ///< 生成素数的位数
+    yus::SecurityLevel level = yus::SecurityLevel::SEC80; ///< 安全级别
+    uint32_t trunc_m = 12;          ///< 截断位数
+    uint32_t blocks = 0;            ///< 块数，0表示自动
+    bool fhe = true;                ///< 是否运行同态评估
+    yus::FHE_SCHEME scheme = yus::FHE_SCHEME::BFV; ///< 同态方案
+    uint32_t poly_modulus_degree = 0; ///< 环维数，0表示自动选择
+    yus::PackingMode packing = yus::PackingMode::ROW; ///< 槽打包方式
+    uint32_t threads = 0;           ///< 线程数，0表示硬件并发数
+    uint32_t reps = 1;              ///< 计时次数
+};
+
+/**
+ * @struct StageRecord
+ * @brief 单个阶段的耗时和内存
+ */
+struct StageRecord {
+    std::string stage;              ///< 阶段名
+    double ms;                      ///< 阶段耗时（毫秒）
+    uint64_t rss_bytes;             ///< 阶段结束时的常驻内存
+    uint64_t peak_rss_bytes;        ///< 阶段结束时的常驻内存峰值
+};
+
+/**
+ * @brief 记录一个阶段并把进度打印到stderr
+ * @param stages 阶段列表
+ * @param stage 阶段名
+ * @param ms 阶段耗时（毫秒）
+ */
+void record_stage(std::vector<StageRecord>& stages, const std::string& stage, double ms) {
+    stages.push_back({stage, ms, yus::current_rss_bytes(), yus::peak_rss_bytes()});
+    std::cerr << "[STAGE] " << stage << ": " << ms << " ms, RSS " << stages.back().rss_bytes / (1024 * 1024)
+              << " MiB, peak " << stages.back().peak_rss_bytes / (1024 * 1024) << " MiB" << std::endl;
+}
+
+/**
+ * @brief 输出计时统计的JSON对象
+ */
+std::string stats_json(const yus::SampleStats& stats) {
+    std::ostringstream json;
+    json << "{\"min\":" << stats.min() << ",\"median\":" << stats.median() << ",\"max\":" << stats.max()
+         << ",\"reps\":" << stats.count() << "}";
+    return json.str();
+}
+
+/**
+ * @brief 运行演示流程
+ * @param options 命令行选项
+ * @param stages 输出各阶段的耗时和内存
+ * @param json 追加结果字段
+ * @return 同态评估的解密结果与明文密钥流一致（或未运行同态评估）时返回true
+ * @throws std::invalid_argument 参数不可行时抛出异常
+ * @throws std::runtime_error 评估失败时抛出异常
+ */
+bool run_demo(DemoOptions options, std::vector<StageRecord>& stages, std::ostringstream& json) {
+    const uint32_t rounds = static_cast<uint32_t>(options.level);
+    const uint32_t security_bits = options.level == yus::SecurityLevel::SEC80 ? 80 : 128;
+    const uint32_t words = 36 - options.trunc_m;
+    yus::Timer timer;
+
+    // 阶段1: 生成素数（p ≡ 2 mod 3，且p ≡ 1 mod 2N以便同态批处理）
+    timer.start();
+    if (options.p == 0) {
+        options.p = yus::generate_batching_prime(
+            options.p_bits, options.poly_modulus_degree ? options.poly_modulus_degree : kDefaultPrimeDegree);
     }
-#else
-    struct rusage usage;
-    if (getrusage(RUSAGE_SELF, &usage) == 0) {
-        std::cout << "[MEMORY] " << stage << " - Max RSS: " 
-                  << usage.ru_maxrss / 1024 << " MB" << std::endl;
+    timer.stop();
+    record_stage(stages, "prime", timer.elapsed_ms());
+    const mpz_class& p = options.p;
+
+    // 阶段2: 主密钥、随机数和明文密码初始化（使用简单序列作为主密钥）
+    timer.start();
+    std::vector<mpz_class> master_key(36);
+    for (int i = 0; i < 36; ++i) {
+        master_key[i] = yus::mod(i + 1, p);
     }
-#endif
+    const std::vector<uint8_t> nonce{0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08};
+    yus::YuSCipher cipher(p, options.level, options.trunc_m);
+    cipher.init(master_key, nonce);
+    timer.stop();
+    record_stage(stages, "init", timer.elapsed_ms());
+
+    // 阶段3: FHE参数选择、密钥生成；确定块数
+    std::unique_ptr<yus::FHEWrapper> fhe;
+    yus::FHEParams params{};
+    uint32_t blocks = options.blocks ? options.blocks : 1;
+    if (options.fhe) {
+        timer.start();
+        params = yus::select_fhe_params(options.scheme, p, security_bits, rounds, 10, options.packing,
+                                        options.poly_modulus_degree);
+        params.num_threads = options.threads;
+        fhe = std::make_unique<yus::FHEWrapper>(options.scheme, params);
+        size_t capacity = fhe->slot_count();
+        if (options.packing == yus::PackingMode::COLUMN) {
+            fhe->generate_column_galois_keys();
+            capacity = fhe->column_block_capacity(options.level);
+        }
+        timer.stop();
+        record_stage(stages, "fhe_setup", timer.elapsed_ms());
+        if (options.blocks > capacity) {
+            throw std::invalid_argument("--blocks exceeds the " + std::to_string(capacity) +
+                                        " blocks of one evaluation");
+        }
+        blocks = options.blocks ? options.blocks : static_cast<uint32_t>(capacity);
+    }
+
+    // 阶段4: 明文密钥流生成，同时作为同态结果的参照
+    yus::SampleStats keystream_ms;
+    std::vector<mpz_class> keystream;
+    for (uint32_t r = 0; r < options.reps; ++r) {
+        timer.start();
+        keystream = cipher.generate_keystream(blocks);
+        timer.stop();
+        keystream_ms.add(timer.elapsed_ms());
+    }
+    record_stage(stages, "keystream", keystream_ms.median());
+
+    json << ",\"p\":\"" << p.get_str() << "\",\"level\":" << security_bits << ",\"rounds\":" << rounds
+         << ",\"trunc_m\":" << options.trunc_m << ",\"threads\":" << options.threads << ",\"reps\":" << options.reps
+         << ",\"blocks\":" << blocks << ",\"keystream_ms\":" << stats_json(keystream_ms)
+         << ",\"keystream_throughput_kibps\":"
+         << yus::throughput_kibps(p, static_cast<double>(blocks) * words, keystream_ms.median());
+    if (!fhe) {
+        return true;
+    }
+
+    // 阶段5: 加密主密钥（行式每个密文的所有槽为同一密钥元素，列式3个密文）
+    const bool column = options.packing == yus::PackingMode::COLUMN;
+    std::vector<yus::Ciphertext> cipher_key;
+    timer.start();
+    if (column) {
+        fhe->encrypt_key_columnwise(master_key, cipher_key);
+    } else {
+        fhe->encrypt_key(master_key, cipher_key);
+    }
+    timer.stop();
+    record_stage(stages, "encrypt_key", timer.elapsed_ms());
+
+    // 阶段6: 同态评估，一次评估覆盖blocks个块
+    yus::YuSEvalParams eval_params{nonce, options.level, options.trunc_m, 0, blocks, {}};
+    std::vector<yus::Ciphertext> cipher_ks;
+    yus::YuSEvalReport report;
+    yus::SampleStats eval_ms;
+    for (uint32_t r = 0; r < options.reps; ++r) {
+        eval_ms.add(column ? fhe->evaluate_yus_columnwise(cipher_key, eval_params, cipher_ks, report)
+                           : fhe->evaluate_yus(cipher_key, eval_params, cipher_ks));
+    }
+    record_stage(stages, "fhe_eval", eval_ms.median());
+    double final_noise = 0;
+    for (size_t i = 0; i < cipher_ks.size(); ++i) {
+        const double budget = fhe->noise_budget(cipher_ks[i]);
+        final_noise = i == 0 ? budget : std::min(final_noise, budget);
+    }
+
+    // 阶段7: 解密并与明文密钥流逐元素比较
+    timer.start();
+    std::vector<mpz_class> decrypted;
+    if (column) {
+        decrypted = fhe->decrypt_columnwise(cipher_ks, options.level, options.trunc_m, blocks);
+    } else {
+        // 行式：第i个密文的第b个槽为块b的第i个元素，转成按块顺序
+        const auto slots = fhe->decrypt(cipher_ks);
+        const size_t nslots = fhe->slot_count();
+        if (slots.size() == words * nslots) {
+            decrypted.resize(static_cast<size_t>(blocks) * words);
+            for (uint32_t b = 0; b < blocks; ++b) {
+                for (uint32_t i = 0; i < words; ++i) {
+                    decrypted[b * words + i] = slots[i * nslots + b];
+                }
+            }
+        }
+    }
+    timer.stop();
+    record_stage(stages, "decrypt", timer.elapsed_ms());
+
+    size_t mismatches = 0;
+    if (decrypted.size() != keystream.size()) {
+        mismatches = keystream.size();
+    } else {
+        for (size_t w = 0; w < keystream.size(); ++w) {
+            if (decrypted[w] != keystream[w]) {
+                ++mismatches;
+            }
+        }
+    }
+
+    json << ",\"scheme\":\"" << (options.scheme == yus::FHE_SCHEME::BGV ? "BGV" : "BFV")
+         << "\",\"packing\":\"" << (column ? "column" : "row") << "\",\"n\":" << params.poly_modulus_degree
+         << ",\"slots\":" << fhe->slot_count() << ",\"cipher_modulus_bits\":" << params.cipher_modulus_bits
+         << ",\"eval_ms\":" << stats_json(eval_ms)
+         << ",\"throughput_kibps\":" << fhe->get_throughput(blocks, options.trunc_m, eval_ms.median())
+         << ",\"final_noise_budget_bits\":" << final_noise << ",\"mismatched_words\":" << mismatches;
+    return mismatches == 0;
 }
 
+void usage() {
+    std::cerr << "Usage: yus_example [--p P | --p-bits B] [--level 80|128] [--trunc M] [--blocks B]\n"
+                 "                   [--scheme bgv|bfv|none] [--n N] [--packing row|column] [--threads T] [--reps R]"
+              << std::endl;
+}
+
+} // namespace
+
 /**
  * @brief 主函数 - YuS流密码演示程序入口
- * @return 程序退出代码（0表示成功，非0表示错误）
- * 
- * 演示程序的完整执行流程，分为7个主要阶段：
- * 1. 素数生成
- * 2. YuS密码初始化
- * 3. 主密钥生成
- * 4. 随机数设置
- * 5. YuS密码完整初始化
- * 6. 密钥流生成
- * 7. FHE同态操作
+ * @return 0表示成功；1表示评估失败或解密结果与明文密钥流不一致；2表示命令行参数错误
+ *
+ * 执行流程：素数生成、密码初始化、FHE参数选择与密钥生成、明文密钥流生成、
+ * 主密钥加密、同态评估、解密校验。每个阶段的耗时、常驻内存和峰值记入JSON的stages数组。
  */
-int main() {
-    std::cout << "=== Yus Cipher Demo with Debug Mode ===" << std::endl;
-    std::cout << "[DEBUG] Program started" << std::endl;
-    
+int main(int argc, char* argv[]) {
+    DemoOptions options;
     try {
-        // 阶段1: 生成素数
-        std::cout << "[STAGE 1] Generating prime p..." << std::endl;
-        print_memory_usage("Before prime generation");
-        
-        // 生成17位满足条件的素数（p ≡ 2 mod 3且p > 2^16）
-        mpz_class p = yus::generate_prime(17);
-        std::cout << "[SUCCESS] Generated prime p: " << p << std::endl;
-        print_memory_usage("After prime generation");
-        
-        // 等待用户确认继续
-        std::cout << "[DEBUG] Press Enter to continue to Stage 2...";
-        std::cin.get();
-
-        // 阶段2: 初始化YuS密码
-        std::cout << "[STAGE 2] Initializing YuS cipher..." << std::endl;
-        yus::YuSCipher yus(p, yus::SecurityLevel::SEC80, 12);  // 80位安全，截断12位
-        std::cout << "[SUCCESS] YuS cipher initialized" << std::endl;
-        print_memory_usage("After YuS initialization");
-
-        // 阶段3: 生成主密钥
-        std::cout << "[STAGE 3] Generating master key..." << std::endl;
-        std::vector<mpz_class> master_key(36);
-        for (int i = 0; i < 36; ++i) {
-            master_key[i] = yus::mod(i + 1, p);  // 使用简单序列作为主密钥
-            if (i % 10 == 0) {
-                std::cout << "[PROGRESS] Generated " << i << "/36 key elements" << std::endl;
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            if (i + 1 >= argc) {
+                usage();
+                return 2;
+            }
+            const std::string value = argv[++i];
+            if (arg == "--p") {
+                options.p = mpz_class(value);
+            } else if (arg == "--p-bits") {
+                options.p_bits = static_cast<uint32_t>(parse_number("--p-bits", value.c_str()));
+            } else if (arg == "--level") {
+                const unsigned long bits = parse_number("--level", value.c_str());
+                if (bits != 80 && bits != 128) {
+                    throw std::invalid_argument("--level must be 80 or 128");
+                }
+                options.level = bits == 80 ? yus::SecurityLevel::SEC80 : yus::SecurityLevel::SEC128;
+            } else if (arg == "--trunc") {
+                options.trunc_m = static_cast<uint32_t>(parse_number("--trunc", value.c_str()));
+            } else if (arg == "--blocks") {
+                options.blocks = static_cast<uint32_t>(parse_number("--blocks", value.c_str()));
+            } else if (arg == "--scheme") {
+                if (value == "bgv") {
+                    options.scheme = yus::FHE_SCHEME::BGV;
+                } else if (value == "bfv") {
+                    options.scheme = yus::FHE_SCHEME::BFV;
+                } else if (value == "none") {
+                    options.fhe = false;
+                } else {
+                    throw std::invalid_argument("--scheme must be bgv, bfv or none");
+                }
+            } else if (arg == "--n") {
+                options.poly_modulus_degree = static_cast<uint32_t>(parse_number("--n", value.c_str()));
+            } else if (arg == "--packing") {
+                if (value == "row") {
+                    options.packing = yus::PackingMode::ROW;
+                } else if (value == "column") {
+                    options.packing = yus::PackingMode::COLUMN;
+                } else {
+                    throw std::invalid_argument("--packing must be row or column");
+                }
+            } else if (arg == "--threads") {
+                options.threads = static_cast<uint32_t>(parse_number("--threads", value.c_str()));
+            } else if (arg == "--reps") {
+                options.reps = static_cast<uint32_t>(parse_number("--reps", value.c_str()));
+            } else {
+                usage();
+                return 2;
             }
         }
-        std::cout << "[SUCCESS] Master key generated" << std::endl;
-        print_memory_usage("After master key generation");
-
-        // 阶段4: 设置随机数
-        std::cout << "[STAGE 4] Setting nonce..." << std::endl;
-        std::vector<uint8_t> nonce = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08};
-        
-        // 阶段5: 初始化YuS密码
-        std::cout << "[STAGE 5] Initializing YuS with key and nonce..." << std::endl;
-        yus.init(master_key, nonce);
-        std::cout << "[SUCCESS] YuS initialized" << std::endl;
-        print_memory_usage("After YuS init");
-
-        std::cout << "[DEBUG] Press Enter to continue to Stage 6...";
-        std::cin.get();
-
-        // 阶段6: 生成密钥流
-        std::cout << "[STAGE 6] Generating keystream..." << std::endl;
-        auto keystream = yus.generate_keystream(1);  // 生成1个密钥流块
-        std::cout << "[SUCCESS] Generated keystream with " << keystream.size() << " elements" << std::endl;
-        // 显示前5个密钥流元素
-        for (size_t i = 0; i < keystream.size() && i < 5; ++i) {
-            std::cout << "  [" << i << "]: " << keystream[i] << std::endl;
+        if (options.trunc_m >= 36 || options.reps == 0) {
+            throw std::invalid_argument("Need trunc < 36 and reps > 0");
         }
-        if (keystream.size() > 5) {
-            std::cout << "  ... and " << (keystream.size() - 5) << " more elements" << std::endl;
+        if (options.fhe && options.packing == yus::PackingMode::COLUMN && options.scheme != yus::FHE_SCHEME::BFV) {
+            throw std::invalid_argument("--packing column requires --scheme bfv");
         }
-        print_memory_usage("After keystream generation");
-
-        std::cout << "[DEBUG] Press Enter to continue to FHE operations...";
-        std::cin.get();
-
-        // 阶段7: FHE同态操作
-        std::cout << "[STAGE 7] Starting FHE operations with optimized parameters..." << std::endl;
-        
-        // 配置FHE参数
-        yus::FHEParams fhe_params;
-        fhe_params.security_level = 128;           // 128位安全级别
-        fhe_params.poly_modulus_degree = 8192;    // 多项式模数次数
-        fhe_params.plain_modulus = p;             // 明文模数
-        fhe_params.cipher_modulus_bits = 300;     // 密文模数位数
-
-        std::cout << "[FHE PARAMS] Security: " << fhe_params.security_level 
-                  << ", Poly degree: " << fhe_params.poly_modulus_degree
-                  << ", Cipher bits: " << fhe_params.cipher_modulus_bits << std::endl;
-
-        // FHE包装器初始化
-        std::cout << "[FHE] Initializing FHE wrapper..." << std::endl;
-        yus::FHEWrapper fhe(yus::FHE_SCHEME::BFV, fhe_params);  // 使用BFV方案
-        std::cout << "[SUCCESS] FHE wrapper initialized" << std::endl;
-        print_memory_usage("After FHE wrapper init");
-
-        // 密钥生成
-        std::cout << "[FHE] Generating keys..." << std::endl;
-        fhe.generate_keys();
-        std::cout << "[SUCCESS] FHE keys generated" << std::endl;
-        print_memory_usage("After FHE key generation");
-
-        std::cout << "[DEBUG] Press Enter to continue to encryption...";
-        std::cin.get();
-
-        // 加密密钥流
-        std::cout << "[FHE] Encrypting keystream..." << std::endl;
-        std::vector<yus::FHEWrapper::CiphertextPtr> cipher_ks;
-        fhe.encrypt(keystream, cipher_ks);
-        std::cout << "[SUCCESS] Keystream encrypted (" << cipher_ks.size() << " ciphertexts)" << std::endl;
-        print_memory_usage("After keystream encryption");
-
-        // 加密主密钥（只加密前8个元素以节省内存）
-        std::cout << "[FHE] Encrypting master key (first 8 elements)..." << std::endl;
-        std::vector<mpz_class> key_part(master_key.begin(), master_key.begin() + 8);
-        std::vector<yus::FHEWrapper::CiphertextPtr> cipher_key;
-        fhe.encrypt(key_part, cipher_key);
-        std::cout << "[SUCCESS] Master key encrypted (" << cipher_key.size() << " ciphertexts)" << std::endl;
-        print_memory_usage("After master key encryption");
-
-        std::cout << "[DEBUG] Press Enter to continue to homomorphic evaluation...";
-        std::cin.get();
-
-        // 同态评估
-        std::cout << "[FHE] Starting homomorphic evaluation..." << std::endl;
-        double eval_time = fhe.evaluate_yus(cipher_key, cipher_ks);
-        double throughput = fhe.get_throughput(8 * mpz_sizeinbase(p.get_mpz_t(), 8), eval_time);
-        
-        std::cout << "[SUCCESS] FHE evaluation completed" << std::endl;
-        std::cout << "[RESULTS] Evaluation time: " << eval_time << " ms" << std::endl;
-        std::cout << "[RESULTS] Throughput: " << throughput << " KiB/s" << std::endl;
-        print_memory_usage("After FHE evaluation");
-
-        std::cout << "[DEBUG] Program completed successfully!" << std::endl;
-        std::cout << "Press Enter to exit...";
-        std::cin.get();
-
     } catch (const std::exception& e) {
-        // 异常处理：标准异常
-        std::cerr << "[FATAL ERROR] Exception caught: " << e.what() << std::endl;
-        std::cerr << "[DEBUG] Program will exit with error code 1" << std::endl;
-        print_memory_usage("At error");
-        std::cout << "Press Enter to exit...";
-        std::cin.get();
-        return 1;
-    } catch (...) {
-        // 异常处理：未知异常
-        std::cerr << "[FATAL ERROR] Unknown exception caught!" << std::endl;
-        std::cerr << "[DEBUG] Program will exit with error code 2" << std::endl;
-        print_memory_usage("At unknown error");
-        std::cout << "Press Enter to exit...";
-        std::cin.get();
+        std::cerr << "[yus_example] " << e.what() << std::endl;
+        usage();
         return 2;
     }
 
-    return 0;  // 程序成功执行
-}
\ No newline at end of file
+#ifdef _OPENMP
+    if (options.threads) {
+        omp_set_num_threads(static_cast<int>(options.threads));
+    }
+#endif
+
+    std::vector<StageRecord> stages;
+    std::ostringstream json;
+    int status = 0;
+    try {
+        if (!run_demo(options, stages, json)) {
+            std::cerr << "[yus_example] Decrypted keystream does not match the plaintext keystream" << std::endl;
+            status = 1;
+        }
+        json << ",\"verified\":" << (status == 0 ? "true" : "false");
+    } catch (const std::exception& e) {
+        std::cerr << "[yus_example] " << e.what() << std::endl;
+        json << ",\"error\":" << json_string(e.what());
+        status = 1;
+    }
+
+    std::cout << "{\"stages\":[";
+    for (size_t s = 0; s < stages.size(); ++s) {
+        std::cout << (s ? "," : "") << "{\"stage\":\"" << stages[s].stage << "\",\"ms\":" << stages[s].ms
+                  << ",\"rss_bytes\":" << stages[s].rss_bytes << ",\"peak_rss_bytes\":" << stages[s].peak_rss_bytes
+                  << "}";
+    }
+    std::cout << "]" << json.str() << "}" << std::endl;
+    return status;
+}
@@ -0,0 +1,70 @@
+/**
+ * @file alloc_tracker.h
+ * @brief YuS流密码堆分配统计头文件
+ * @author Aurorp1g
+ * @date 2025-11-07
+ *
+ * CMake选项YUS_ALLOC_TRACKING打开时，库替换全局operator new/delete，
+ * 并通过mp_set_memory_functions接管GMP的分配函数，统计分配次数和字节数，
+ * 用于证明热路径不分配堆内存，以及跟踪每个密钥流块、每轮同态评估的分配回归。
+ * 关闭时不替换任何分配函数，查询接口仍可调用并返回全零。
+ *
+ * 计数同时保存在全局（所有线程）和当前线程两份中；全局计数用relaxed原子累加，
+ * 线程计数不需要同步，适合在单线程的被测区间前后取差值。
+ */
+
+#ifndef YUS_ALLOC_TRACKER_H
+#define YUS_ALLOC_TRACKER_H
+
+#include <cstdint>
+
+namespace yus {
+
+/**
+ * @struct AllocCounts
+ * @brief 堆分配计数
+ *
+ * operator new和GMP的分配、重新分配各计一次分配；bytes为请求的字节数。
+ */
+struct AllocCounts {
+    uint64_t allocations = 0;   ///< 分配次数（含GMP重新分配）
+    uint64_t bytes = 0;         ///< 请求的字节数
+    uint64_t frees = 0;         ///< 释放次数
+
+    /**
+     * @brief 两次读数之差
+     */
+    AllocCounts operator-(const AllocCounts& other) const {
+        return AllocCounts{allocations - other.allocations, bytes - other.bytes, frees - other.frees};
+    }
+
+    /**
+     * @brief 累加另一段区间的计数
+     */
+    AllocCounts& operator+=(const AllocCounts& other) {
+        allocations += other.allocations;
+        bytes += other.bytes;
+        frees += other.frees;
+        return *this;
+    }
+};
+
+/**
+ * @brief 分配统计是否已编译进库
+ * @return 构建时打开YUS_ALLOC_TRACKING选项时返回true
+ */
+bool alloc_tracking_enabled();
+
+/**
+ * @brief 所有线程自进程启动以来的分配计数
+ */
+AllocCounts alloc_counts();
+
+/**
+ * @brief 当前线程自线程启动以来的分配计数
+ */
+AllocCounts thread_alloc_counts();
+
+} // namespace yus
+
+#endif // YUS_ALLOC_TRACKER_H
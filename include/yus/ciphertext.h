@@ -0,0 +1,206 @@
+/**
+ * @file ciphertext.h
+ * @brief YuS流密码类型化密文句柄与密文对象池头文件
+ * @author Aurorp1g
+ * @date 2025-11-07
+ *
+ * 定义同态评估使用的密文句柄和密文对象池。
+ * 句柄以侵入式引用计数共享池中的SEAL或HElib密文对象，最后一个句柄释放时对象回到池中，
+ * 再次分配时连同已分配的多项式缓冲区一起复用，评估热循环不再逐个创建密文对象。
+ */
+
+#ifndef YUS_CIPHERTEXT_H
+#define YUS_CIPHERTEXT_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <helib/helib.h>
+#include <seal/seal.h>
+
+namespace yus {
+
+/**
+ * @enum FHE_SCHEME
+ * @brief 同态加密方案枚举
+ *
+ * 定义支持的同态加密方案：
+ * - BGV: 使用HElib实现的BGV方案
+ * - BFV: 使用SEAL实现的BFV方案
+ */
+enum class FHE_SCHEME { BGV, BFV };
+
+class CiphertextPool;
+
+/**
+ * @class Ciphertext
+ * @brief 类型化密文句柄
+ *
+ * 复制句柄只增加引用计数，不复制密文。访问器检查后端类型，
+ * 取代原先对std::shared_ptr<void>的无检查static_cast。
+ * 引用计数是原子的，句柄可在线程间传递；同一密文对象的并发修改仍需调用方同步。
+ */
+class Ciphertext {
+public:
+    /**
+     * @brief 构造空句柄
+     */
+    Ciphertext() noexcept = default;
+
+    Ciphertext(const Ciphertext& other) noexcept;
+    Ciphertext(Ciphertext&& other) noexcept;
+    Ciphertext& operator=(const Ciphertext& other) noexcept;
+    Ciphertext& operator=(Ciphertext&& other) noexcept;
+
+    /**
+     * @brief 析构函数
+     *
+     * 释放引用，最后一个引用释放时密文对象回到所属的池。
+     */
+    ~Ciphertext();
+
+    /**
+     * @brief 句柄是否指向密文
+     */
+    explicit operator bool() const noexcept { return node_ != nullptr; }
+
+    /**
+     * @brief 是否为唯一引用
+     * @return 句柄非空且没有其他句柄共享该密文时返回true
+     *
+     * 原地覆盖密文前据此判断是否会影响其他持有者。
+     */
+    bool unique() const noexcept;
+
+    /**
+     * @brief 获取密文所属的方案
+     * @throws std::runtime_error 当句柄为空时抛出异常
+     */
+    FHE_SCHEME scheme() const;
+
+    /**
+     * @brief 访问SEAL密文
+     * @throws std::runtime_error 当句柄为空或不是BFV密文时抛出异常
+     */
+    seal::Ciphertext& seal();
+    const seal::Ciphertext& seal() const;
+
+    /**
+     * @brief 访问HElib密文
+     * @throws std::runtime_error 当句柄为空或不是BGV密文时抛出异常
+     */
+    helib::Ctxt& helib();
+    const helib::Ctxt& helib() const;
+
+    /**
+     * @brief 释放引用并置空句柄
+     */
+    void reset() noexcept;
+
+private:
+    friend class CiphertextPool;
+    struct Node;
+
+    explicit Ciphertext(Node* node) noexcept : node_(node) {}
+
+    Node* node_ = nullptr;   ///< 池中的密文对象，空句柄为nullptr
+};
+
+/**
+ * @class CiphertextPool
+ * @brief 密文对象池类
+ *
+ * 保存空闲的密文对象供重复使用。存活的密文持有池的共享引用，
+ * 因此句柄可以比创建它的FHEWrapper活得更久而不会访问已释放的池。
+ * 所有接口线程安全。
+ */
+class CiphertextPool : public std::enable_shared_from_this<CiphertextPool> {
+public:
+    /**
+     * @struct Stats
+     * @brief 对象池统计信息
+     */
+    struct Stats {
+        uint64_t acquires;      ///< 分配次数
+        uint64_t allocations;   ///< 新建密文对象的次数
+        size_t idle;            ///< 当前空闲对象数
+    };
+
+    /**
+     * @brief 创建对象池
+     * @param scheme 池中密文的方案
+     * @param seal_pools 各工作者的SEAL内存池，新建的BFV密文使用对应工作者的内存池；
+     *                   为空时使用SEAL全局内存池
+     * @return 对象池的共享引用
+     */
+    static std::shared_ptr<CiphertextPool> create(FHE_SCHEME scheme,
+                                                  std::vector<seal::MemoryPoolHandle> seal_pools = {});
+
+    /**
+     * @brief 析构函数，释放所有空闲对象
+     */
+    ~CiphertextPool();
+
+    CiphertextPool(const CiphertextPool&) = delete;
+    CiphertextPool& operator=(const CiphertextPool&) = delete;
+
+    /**
+     * @brief 设置新建HElib密文所用的公钥
+     * @param pubkey HElib公钥
+     *
+     * HElib密文绑定创建时的公钥，更换公钥时丢弃所有空闲对象，
+     * 仍在使用的旧公钥密文释放后也不再回到池中。
+     */
+    void set_helib_pubkey(const helib::PubKey* pubkey);
+
+    /**
+     * @brief 分配密文
+     * @param worker 工作者编号，决定新建BFV密文的内存池
+     * @return 唯一引用的密文句柄，内容未指定，调用方应先整体赋值
+     * @throws std::runtime_error 当BGV池未设置公钥时抛出异常
+     */
+    Ciphertext acquire(size_t worker = 0);
+
+    /**
+     * @brief 预留空闲对象
+     * @param count 空闲对象的目标数量
+     *
+     * 在评估开始前按电路的存活密文数量补足空闲对象，热循环中的分配只从空闲表取出。
+     */
+    void reserve(size_t count);
+
+    /**
+     * @brief 获取统计信息
+     */
+    Stats stats() const;
+
+private:
+    explicit CiphertextPool(FHE_SCHEME scheme, std::vector<seal::MemoryPoolHandle> seal_pools);
+
+    /**
+     * @brief 新建密文对象（调用方持有锁）
+     */
+    Ciphertext::Node* make_node(size_t worker);
+
+    /**
+     * @brief 回收引用计数归零的对象
+     */
+    void recycle(Ciphertext::Node* node) noexcept;
+
+    friend class Ciphertext;
+
+    FHE_SCHEME scheme_;                                ///< 池中密文的方案
+    std::vector<seal::MemoryPoolHandle> seal_pools_;   ///< 各工作者的SEAL内存池
+    const helib::PubKey* helib_pubkey_;                ///< 新建HElib密文所用的公钥
+    std::vector<Ciphertext::Node*> idle_;              ///< 空闲对象
+    uint64_t generation_;                              ///< 公钥代数，旧代对象回收时直接释放
+    uint64_t acquires_;                                ///< 分配次数
+    uint64_t allocations_;                             ///< 新建次数
+    mutable std::mutex mutex_;                         ///< 保护以上状态
+};
+
+} // namespace yus
+
+#endif // YUS_CIPHERTEXT_H
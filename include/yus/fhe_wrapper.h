@@ -13,23 +13,23 @@
 
 #include <cstdint>
 #include <vector>
+#include <string>
 #include <gmpxx.h>
 #include <memory>
+#include <chrono>
+#include <mutex>
+#include <iosfwd>
 #include <helib/helib.h>
 #include <seal/seal.h>
+#include "yus_core.h"
+#include "ciphertext.h"
+#include "linear_layer.h"
+#include "thread_pool.h"
+#include "trace.h"
+#include "alloc_tracker.h"
 
 namespace yus {
 
-/**
- * @enum FHE_SCHEME
- * @brief 同态加密方案枚举
- * 
- * 定义支持的同态加密方案：
- * - BGV: 使用HElib实现的BGV方案
- * - BFV: 使用SEAL实现的BFV方案
- */
-enum class FHE_SCHEME { BGV, BFV };
-
 /**
  * @struct FHEParams
  * @brief FHE参数配置结构体
@@ -38,9 +38,117 @@ enum class FHE_SCHEME { BGV, BFV };
  */
 struct FHEParams {
     uint32_t security_level;        ///< 安全级别（80或128位）
-    uint32_t poly_modulus_degree;   ///< 多项式模数次数
-    mpz_class plain_modulus;        ///< 明文模数，必须满足p ≡ 2 mod 3
-    uint32_t cipher_modulus_bits;   ///< 密文模数位数
+    uint32_t poly_modulus_degree;   ///< 多项式模数次数（环维数N）
+    mpz_class plain_modulus;        ///< 明文模数，必须满足p ≡ 2 mod 3；批处理还要求p ≡ 1 mod 2N
+    uint32_t cipher_modulus_bits;   ///< 密文模数位数（HElib模数链总位数）
+    uint32_t num_threads = 0;       ///< 同态评估工作线程数，0表示使用硬件并发数
+    uint32_t cyclotomic_index = 0;  ///< HElib分圆多项式指数m，0表示2·poly_modulus_degree
+    std::vector<int> coeff_modulus_bits; ///< SEAL模数链各素数位数（末项为特殊素数），为空时使用BFVDefault
+};
+
+/**
+ * @enum PackingMode
+ * @brief 同态评估的槽打包方式
+ */
+enum class PackingMode {
+    ROW,    ///< 行式打包：36个密文，每个槽一个块
+    COLUMN  ///< 列式打包：3个密文分别保存12个S盒的x0、x1、x2，线性层用槽旋转实现
+};
+
+/**
+ * @brief 按YuS电路深度自动选择FHE参数
+ * @param scheme 同态加密方案（BGV或BFV）
+ * @param plain_modulus YuS素数p，必须满足p ≡ 2 mod 3
+ * @param security_level 安全级别（80或128位）
+ * @param rounds YuS轮数，即电路的乘法深度
+ * @param noise_margin_bits 解密时保留的噪声余量（比特）
+ * @param packing 打包方式；列式打包的每个线性层含对角明文乘法，需要更大的模数
+ * @param poly_modulus_degree 指定环维数N，0表示自动选择
+ * @return 满足深度和安全要求的最小环维数（或指定的环维数）及其模数链
+ * @throws std::invalid_argument 当参数无效、BGV的p超出HElib的long范围（long为32位的平台），
+ *         或不存在满足条件的环维数时抛出异常
+ * 
+ * 从N=1024开始逐次加倍，只考虑p ≡ 1 mod 2N（槽为F_p）的环维数。
+ * 模数链按每轮一个素数划分，便于YuSEvalParams::mod_switch_schedule逐轮丢弃；
+ * 总位数（含特殊素数）不超过该安全级别下环维数允许的上限。
+ * 指定环维数时只检查该N，用于在技术文档表7.3/7.4的固定N下对比性能。
+ */
+FHEParams select_fhe_params(FHE_SCHEME scheme, const mpz_class& plain_modulus,
+                            uint32_t security_level, uint32_t rounds,
+                            uint32_t noise_margin_bits = 10,
+                            PackingMode packing = PackingMode::ROW,
+                            uint32_t poly_modulus_degree = 0);
+
+/**
+ * @struct SlotSegment
+ * @brief 一段连续槽对应的随机数和块范围
+ * 
+ * 多个请求合并为一次评估时，各段按顺序占用相邻的槽。
+ */
+struct SlotSegment {
+    std::vector<uint8_t> nonce;     ///< 该段的随机数
+    uint32_t first_block;           ///< 该段第一个槽对应的块索引
+    uint32_t block_count;           ///< 该段的块数量
+};
+
+/**
+ * @struct YuSEvalParams
+ * @brief 同态YuS评估参数
+ * 
+ * 采用行式打包：第i个密文保存所有块状态的第i个元素，槽j对应块first_block+j。
+ */
+struct YuSEvalParams {
+    std::vector<uint8_t> nonce;     ///< 随机数向量
+    SecurityLevel level;            ///< 安全级别，决定轮数（5或6轮）
+    uint32_t trunc_m;               ///< 截断位数，最终线性层跳过前trunc_m行
+    uint32_t first_block;           ///< 槽0对应的块索引
+    uint32_t block_count;           ///< 评估的块数量，0表示填满所有槽
+    std::vector<uint32_t> mod_switch_schedule; ///< 第r项为第r轮后（第0项为白化后）丢弃的模数个数，缺省不切换
+    bool noise_telemetry = false;   ///< 记录白化后、每轮后和最终层后的剩余噪声预算
+    double min_noise_budget = 0;    ///< 噪声预算低于该值（比特）时中止评估，0表示不检查
+    std::vector<SlotSegment> segments = {}; ///< 非空时按段分配槽（可跨随机数），忽略nonce、first_block和block_count
+    TraceRecorder* trace = nullptr; ///< 非空时记录每轮、每个S盒、每个线性层分块和每次重线性化的时间线
+};
+
+/**
+ * @struct NoiseStage
+ * @brief 同态评估单个阶段的噪声遥测
+ */
+struct NoiseStage {
+    std::string stage;              ///< 阶段名："whitening"、"round 1".."round r"、"final"
+    double noise_budget_bits;       ///< 该阶段所有密文中最小的剩余噪声预算（比特）
+    double modulus_bits;            ///< 该阶段密文模数的位数（模数切换后）
+    double elapsed_ms;              ///< 从评估开始到该阶段结束的时间（毫秒）
+};
+
+/**
+ * @struct AllocStage
+ * @brief 同态评估单个阶段的堆分配
+ */
+struct AllocStage {
+    std::string stage;              ///< 阶段名，与NoiseStage::stage相同
+    AllocCounts allocs;             ///< 上一阶段结束到该阶段结束之间所有线程的分配，不含噪声测量
+};
+
+/**
+ * @struct YuSEvalReport
+ * @brief 同态YuS评估报告
+ * 
+ * 与评估时间一同返回，供调整模数链大小和模数切换计划使用。
+ */
+struct YuSEvalReport {
+    double eval_time_ms = 0;        ///< 总评估时间（毫秒），包含噪声测量
+    std::vector<NoiseStage> stages; ///< 各阶段的噪声遥测，未开启时为空
+    std::vector<AllocStage> alloc_stages; ///< 各阶段的堆分配，仅YUS_ALLOC_TRACKING构建时记录
+};
+
+/**
+ * @struct SerializedSize
+ * @brief 序列化大小
+ */
+struct SerializedSize {
+    uint64_t raw_bytes = 0;         ///< 未压缩时的字节数
+    uint64_t stored_bytes = 0;      ///< 实际写出的字节数（压缩后）
 };
 
 /**
@@ -56,8 +164,23 @@ public:
      * @brief 构造函数
      * @param scheme 同态加密方案（BGV或BFV）
      * @param params FHE参数配置
+     * 
+     * 构建上下文并生成私钥、公钥和重线性化密钥，构造完成后即可使用，无需再调用generate_keys。
      */
     FHEWrapper(FHE_SCHEME scheme, const FHEParams& params);
+
+    /**
+     * @brief 从save()保存的目录加载上下文、参数和密钥
+     * @param key_dir 密钥目录
+     * @param eval_only 为true时只加载公钥和重线性化密钥（服务端评估模式），不读取私钥
+     * @param num_threads 同态评估工作线程数，0表示使用硬件并发数
+     * @throws std::runtime_error 当文件缺失或格式错误时抛出异常
+     * @throws std::invalid_argument 当保存的参数无效时抛出异常
+     * 
+     * 跳过密钥生成，服务重启和横向扩容时不再重复支付密钥生成的开销。
+     * 评估模式下decrypt和SEAL的噪声预算测量需要私钥，调用时抛出std::runtime_error。
+     */
+    explicit FHEWrapper(const std::string& key_dir, bool eval_only = false, uint32_t num_threads = 0);
     
     /**
      * @brief 析构函数
@@ -65,71 +188,408 @@ public:
     ~FHEWrapper();
 
     /**
-     * @brief 生成密钥对
+     * @brief 重新生成密钥对
      * 
-     * 生成同态加密的密钥对，包括公钥和私钥。
-     * 支持BGV和BFV两种方案的密钥生成。
+     * 生成新的私钥、公钥和重线性化密钥（已生成伽罗瓦密钥时一并重新生成），用于密钥轮换。
+     * 评估模式的实例生成密钥后成为完整实例。旧密钥下的密文不再可用。
      */
     void generate_keys();
 
     /**
-     * @brief 打包明文数据
-     * @param data 原始明文数据向量
-     * @return 打包后的明文数据向量
+     * @brief 保存上下文、参数和密钥
+     * @param key_dir 密钥目录，不存在时创建
+     * @throws std::runtime_error 当文件无法写入时抛出异常
      * 
-     * 对于BGV方案，将多个明文元素打包到单个密文槽中。
-     * 对于BFV方案，直接返回原始数据（支持批处理）。
+     * 写入params.txt、context、public.key，BFV还写入relin.key（生成过列式打包密钥时还有galois.key）；
+     * 持有私钥时写入secret.key（HElib的私钥文件同时包含公钥和密钥交换矩阵）。
+     * 目录中的私钥文件应按私钥的保密要求保管，只分发给评估方时可删除secret.key。
      */
-    std::vector<mpz_class> pack_plaintext(const std::vector<mpz_class>& data) const;
+    void save(const std::string& key_dir) const;
+
+    /**
+     * @brief 是否持有私钥
+     * @return 评估模式加载的实例返回false
+     */
+    bool has_secret_key() const;
+
+    /**
+     * @brief 获取FHE参数
+     */
+    const FHEParams& params() const;
 
     /**
-     * @brief 密文指针类型定义
+     * @brief 打包明文数据
+     * @param data 原始明文数据向量
+     * @return 模p约简并补零到slot_count()整数倍的明文向量
      * 
-     * 使用void指针封装不同加密库的密文类型，提供统一的接口。
+     * 与encrypt的槽布局一致，decrypt(encrypt(data))与其逐元素相等。
      */
-    using CiphertextPtr = std::shared_ptr<void>;
+    std::vector<mpz_class> pack_plaintext(const std::vector<mpz_class>& data) const;
 
     /**
      * @brief 加密明文数据
      * @param plain 明文数据向量
      * @param cipher 输出密文向量
      * 
-     * 使用配置的同态加密方案对明文数据进行加密。
-     * BGV方案逐个元素加密，BFV方案支持批处理加密。
+     * 两种方案均按槽打包：输入按slot_count()分块，每块一个密文，末块不足的槽填0。
+     * 各块在线程池上并行加密，元素先模p约简，不受平台long宽度限制。
      */
-    void encrypt(const std::vector<mpz_class>& plain, std::vector<CiphertextPtr>& cipher);
+    void encrypt(const std::vector<mpz_class>& plain, std::vector<Ciphertext>& cipher);
 
     /**
      * @brief 解密密文数据
      * @param cipher 密文向量
      * @return 解密后的明文数据向量
+     * @throws std::runtime_error 当未持有私钥（评估模式）时抛出异常
+     * 
+     * 返回每个密文的全部槽，按密文顺序拼接，长度为cipher.size()·slot_count()。
+     * 各密文在线程池上并行解密。
+     */
+    std::vector<mpz_class> decrypt(const std::vector<Ciphertext>& cipher) const;
+
+    /**
+     * @brief 获取每个密文的槽数量
+     * @return 槽数量，即单次同态评估可覆盖的最大块数
+     */
+    size_t slot_count() const;
+
+    /**
+     * @brief 获取新鲜密文可丢弃的模数个数
+     * @return 模数切换链上新鲜密文之下的层数（保留最后一个模数用于解密）
+     * 
+     * YuSEvalParams::mod_switch_schedule的总和不得超过该值。
+     */
+    size_t mod_switch_capacity() const;
+
+    /**
+     * @brief 加密YuS主密钥
+     * @param master_key 36个F_p元素的主密钥
+     * @param cipher_key 输出36个密文，第i个密文的所有槽均为k_i
+     * @throws std::invalid_argument 当主密钥大小不正确时抛出异常
+     */
+    void encrypt_key(const std::vector<mpz_class>& master_key, std::vector<Ciphertext>& cipher_key);
+
+    /**
+     * @brief 客户端以私钥对称加密YuS主密钥并序列化，用于一次性上传
+     * @param master_key 36个F_p元素的主密钥
+     * @param out 输出流
+     * @param compress 为true时用zstd压缩每个密文
+     * @return 未压缩和实际写出的字节数
+     * @throws std::invalid_argument 当主密钥大小不正确时抛出异常
+     * @throws std::runtime_error 当未持有私钥时抛出异常
      * 
-     * 使用对应的私钥对密文数据进行解密。
-     * BGV方案逐个元素解密，BFV方案支持批处理解密。
+     * 输出格式同save_ciphertexts，槽布局同encrypt_key。BFV使用SEAL带种子的对称加密，
+     * 每个密文只保存一个多项式和种子；HElib不支持带种子的加密，BGV密文大小不变。
      */
-    std::vector<mpz_class> decrypt(const std::vector<CiphertextPtr>& cipher) const;
+    SerializedSize encrypt_key_symmetric(const std::vector<mpz_class>& master_key, std::ostream& out,
+                                         bool compress = true) const;
+
+    /**
+     * @brief 客户端对称加密YuS主密钥并序列化到内存缓冲区
+     * @param master_key 36个F_p元素的主密钥
+     * @param buffer 输出缓冲区，原内容被替换
+     * @param compress 为true时用zstd压缩每个密文
+     * @return 未压缩和实际写出的字节数
+     */
+    SerializedSize encrypt_key_symmetric(const std::vector<mpz_class>& master_key, std::vector<uint8_t>& buffer,
+                                         bool compress = true) const;
+
+    /**
+     * @brief 服务端加载客户端上传的加密主密钥
+     * @param in 输入流（encrypt_key_symmetric或save_ciphertexts的输出）
+     * @param cipher_key 输出36个密文，可直接用于evaluate_yus
+     * @throws std::runtime_error 当数据格式错误、方案不匹配或密文数不为36时抛出异常
+     */
+    void load_key(std::istream& in, std::vector<Ciphertext>& cipher_key) const;
+
+    /**
+     * @brief 服务端从内存缓冲区加载加密主密钥
+     * @param data 缓冲区首地址
+     * @param size 缓冲区字节数
+     * @param cipher_key 输出36个密文
+     * @throws std::runtime_error 当数据格式错误、方案不匹配或密文数不为36时抛出异常
+     */
+    void load_key(const uint8_t* data, size_t size, std::vector<Ciphertext>& cipher_key) const;
+
+    /**
+     * @brief 服务端预计算加密密钥乘积
+     * @param cipher_key 加密的主密钥（encrypt_key的输出）
+     * @param key_products 输出24个密文：第2s个为E(k_{3s}·k_{3s+2})，第2s+1个为E(k_{3s}·k_{3s+1})
+     * @throws std::invalid_argument 当加密密钥大小不正确时抛出异常
+     * 
+     * 第一轮S盒输入对密钥是仿射的：x_i = CV_i + rc^0_i·k_i，因此
+     * x0·x2 = CV0·CV2 + CV0·rc2·k2 + CV2·rc0·k0 + rc0·rc2·k0k2。
+     * 每个密钥只需计算一次这24个乘积，之后每次评估的第一轮只需明文乘法。
+     */
+    void precompute_key_products(const std::vector<Ciphertext>& cipher_key,
+                                 std::vector<Ciphertext>& key_products) const;
+
+    /**
+     * @brief 客户端加密密钥乘积
+     * @param master_key 36个F_p元素的主密钥
+     * @param key_products 输出24个新鲜密文，布局同precompute_key_products
+     * @throws std::invalid_argument 当主密钥大小不正确时抛出异常
+     * 
+     * 持有明文密钥的一方可直接加密k_a·k_b，此时第一轮不消耗任何乘法深度。
+     */
+    void encrypt_key_products(const std::vector<mpz_class>& master_key, std::vector<Ciphertext>& key_products);
 
     /**
      * @brief 同态评估YuS流密码
-     * @param cipher_key 加密的密钥向量
-     * @param cipher_keystream 加密的密钥流向量
+     * @param cipher_key 加密的主密钥（encrypt_key的输出）
+     * @param eval_params 随机数、轮数、截断和块范围
+     * @param cipher_keystream 输出36-trunc_m个密文，第i个密文的槽j为块first_block+j的第i个密钥流元素
+     * @return 评估时间（毫秒）
+     * @throws std::invalid_argument 当密钥或评估参数不正确时抛出异常
+     * 
+     * 在密文状态下执行密钥白化、r轮RF = AK ∘ LP ∘ SL以及最终线性层和截断。
+     * 线性层复用LinearLayer的加法调度，最终线性层不计算被截断的行。
+     * 每轮12个S盒、线性层的分组部分和与行分组在持久线程池上并行评估。
+     * 按mod_switch_schedule在白化后和每轮后对状态密文做模数切换，
+     * 后续轮次和最终线性层在更小的密文上运行。
+     */
+    double evaluate_yus(const std::vector<Ciphertext>& cipher_key,
+                        const YuSEvalParams& eval_params,
+                        std::vector<Ciphertext>& cipher_keystream);
+
+    /**
+     * @brief 使用预计算密钥乘积同态评估YuS流密码
+     * @param cipher_key 加密的主密钥
+     * @param key_products 24个加密密钥乘积，为空时等同于不带乘积的版本
+     * @param eval_params 随机数、轮数、截断和块范围
+     * @param cipher_keystream 输出的加密密钥流
+     * @return 评估时间（毫秒）
+     * @throws std::invalid_argument 当密钥、密钥乘积或评估参数不正确时抛出异常
+     * 
+     * 第一轮的24次密文乘法被替换为密钥乘积与明文向量的乘法和加法。
+     */
+    double evaluate_yus(const std::vector<Ciphertext>& cipher_key,
+                        const std::vector<Ciphertext>& key_products,
+                        const YuSEvalParams& eval_params,
+                        std::vector<Ciphertext>& cipher_keystream);
+
+    /**
+     * @brief 同态评估YuS流密码并输出评估报告
+     * @param cipher_key 加密的主密钥
+     * @param key_products 24个加密密钥乘积，可为空
+     * @param eval_params 随机数、轮数、截断、块范围和遥测选项
+     * @param cipher_keystream 输出的加密密钥流
+     * @param report 输出的评估报告
+     * @return 评估时间（毫秒）
+     * @throws std::invalid_argument 当密钥、密钥乘积或评估参数不正确时抛出异常
+     * @throws std::runtime_error 当噪声预算低于min_noise_budget时抛出异常，report保留已记录的阶段
+     * 
+     * 开启noise_telemetry或设置min_noise_budget时，在白化后、每轮模数切换后和最终线性层后
+     * 测量所有密文的最小噪声预算。BFV的测量需要私钥。
+     */
+    double evaluate_yus(const std::vector<Ciphertext>& cipher_key,
+                        const std::vector<Ciphertext>& key_products,
+                        const YuSEvalParams& eval_params,
+                        std::vector<Ciphertext>& cipher_keystream,
+                        YuSEvalReport& report);
+
+    /**
+     * @brief 生成列式打包线性层所需的伽罗瓦密钥（仅BFV）
+     * @throws std::invalid_argument 当方案为BGV时抛出异常
+     * @throws std::runtime_error 当未持有私钥时抛出异常
+     * 
+     * 只生成行内左旋1、2、3、4、8步的密钥（小步1..3、大步4和8），
+     * 而不是全部log2(N)个2的幂次步长。生成后save()写入galois.key。
+     */
+    void generate_column_galois_keys();
+
+    /**
+     * @brief 是否持有列式打包所需的伽罗瓦密钥
+     */
+    bool has_column_galois_keys() const;
+
+    /**
+     * @brief 列式打包下单次评估可覆盖的最大块数
+     * @param level 安全级别，决定线性层数和每块占用的槽数
+     * @return 块数；BGV返回0
+     * 
+     * 每块占用一个长为12的倍数的槽区间，区间内按12周期重复该块的状态，
+     * 每个线性层使有效前缀缩短11个槽，最后仍需保留12个有效槽。
+     */
+    size_t column_block_capacity(SecurityLevel level) const;
+
+    /**
+     * @brief 按列式打包加密YuS主密钥（仅BFV）
+     * @param master_key 36个F_p元素的主密钥
+     * @param cipher_key 输出3个密文，第t个密文行内第q个槽为k_{3(q mod 12)+t}
+     * @throws std::invalid_argument 当主密钥大小不正确或方案为BGV时抛出异常
+     */
+    void encrypt_key_columnwise(const std::vector<mpz_class>& master_key, std::vector<Ciphertext>& cipher_key);
+
+    /**
+     * @brief 列式打包同态评估YuS流密码（仅BFV）
+     * @param cipher_key 列式加密的主密钥（encrypt_key_columnwise的输出）
+     * @param eval_params 随机数、轮数、块范围、模数切换和遥测选项
+     * @param cipher_keystream 输出3个密文，块j的元素3s+t位于第t个密文第j个槽区间的第s个槽
+     * @param report 输出的评估报告
      * @return 评估时间（毫秒）
+     * @throws std::invalid_argument 当方案为BGV、密钥大小不正确或块数超过column_block_capacity时抛出异常
+     * @throws std::runtime_error 当未生成伽罗瓦密钥或噪声预算低于min_noise_budget时抛出异常
+     * 
+     * 每轮的S盒层只需2次密文乘法（x0·x2和x0·x1，与块数无关），
+     * 线性层按12个循环对角线分解为小步-大步旋转：每层9次小步旋转、最多6次大步旋转和对角明文乘法。
+     * 适合只有几个块的低延迟请求；块数多时行式打包的吞吐量更高。
+     * 最终线性层计算全部36个元素，截断在解密或使用时进行。
+     */
+    double evaluate_yus_columnwise(const std::vector<Ciphertext>& cipher_key,
+                                   const YuSEvalParams& eval_params,
+                                   std::vector<Ciphertext>& cipher_keystream,
+                                   YuSEvalReport& report);
+
+    /**
+     * @brief 解密列式打包的密钥流
+     * @param cipher_keystream evaluate_yus_columnwise输出的3个密文
+     * @param level 评估使用的安全级别，决定槽区间大小
+     * @param trunc_m 截断位数
+     * @param block_count 块数量
+     * @return 按块顺序排列的密钥流，每块36-trunc_m个元素，与YuSCipher::generate_keystream一致
+     * @throws std::invalid_argument 当密文数量、截断位数或块数不正确时抛出异常
+     * @throws std::runtime_error 当未持有私钥时抛出异常
+     */
+    std::vector<mpz_class> decrypt_columnwise(const std::vector<Ciphertext>& cipher_keystream,
+                                              SecurityLevel level, uint32_t trunc_m, size_t block_count) const;
+
+    /**
+     * @brief 获取密文的剩余噪声预算
+     * @param ct 密文
+     * @return 剩余噪声预算（比特），小于等于0时解密不再正确
+     * @throws std::runtime_error 当SEAL实例未持有私钥时抛出异常
      * 
-     * 在密文状态下执行YuS流密码的同态评估，支持并行处理。
-     * 测量评估性能并返回执行时间。
+     * SEAL使用invariant_noise_budget（需要私钥），HElib使用capacity()估计。
      */
-    double evaluate_yus(const std::vector<CiphertextPtr>& cipher_key, 
-                        const std::vector<CiphertextPtr>& cipher_keystream);
+    double noise_budget(const Ciphertext& ct) const;
 
     /**
-     * @brief 计算吞吐量
-     * @param data_size 数据大小（字节）
+     * @brief 获取密文当前模数的位数
+     * @param ct 密文
+     * @return 模数位数，随模数切换减小
+     */
+    double modulus_bits(const Ciphertext& ct) const;
+
+    /**
+     * @brief 在线转密：从对称密文中剥离加密密钥流
+     * @param cipher_keystream 加密密钥流（evaluate_yus或KeystreamStore的输出），只读
+     * @param sym_ct 对称密文，按块顺序排列，每块cipher_keystream.size()个F_p元素
+     * @param block_count 块数量，不超过槽数量
+     * @param cipher_data 输出密文，第i个密文的槽j为块j的第i个明文元素
+     * @return 转密时间（毫秒）
+     * @throws std::invalid_argument 当密钥流为空或块数量超过槽数量时抛出异常
+     *
+     * YuS按c = m + z (mod p)加密，因此E(m) = c - E(z)：每个输出密文只需一次
+     * 取负和一次明文加法，不消耗乘法深度。密钥流可离线预计算，数据到达后只执行这一步。
+     */
+    double strip_keystream(const std::vector<Ciphertext>& cipher_keystream,
+                           const uint64_t* sym_ct, size_t block_count,
+                           std::vector<Ciphertext>& cipher_data) const;
+
+    /**
+     * @brief 获取密文在内存中占用的字节数
+     * @param ct 密文
+     * @return 多项式系数占用的字节数（部件数 × 环维数 × 当前模数个数 × 8）
+     */
+    size_t ciphertext_bytes(const Ciphertext& ct) const;
+
+    /**
+     * @brief 序列化密文向量到流
+     * @param cts 密文向量
+     * @param out 输出流（文件或内存）
+     * @param compress 为true时用zstd压缩每个密文
+     * @return 未压缩和实际写出的字节数
+     * @throws std::runtime_error 当写入失败时抛出异常
+     * 
+     * 格式为容器头（魔数、方案、密文数）加逐个密文的SEAL序列化帧。
+     * SEAL密文使用Ciphertext::save；HElib密文的二进制writeTo输出放入同样的帧，
+     * 因此两种方案共用SEAL内置的zstd压缩和帧头中的长度校验。
+     */
+    SerializedSize save_ciphertexts(const std::vector<Ciphertext>& cts, std::ostream& out,
+                                    bool compress = true) const;
+
+    /**
+     * @brief 序列化密文向量到内存缓冲区
+     * @param cts 密文向量
+     * @param buffer 输出缓冲区，原内容被替换
+     * @param compress 为true时用zstd压缩每个密文
+     * @return 未压缩和实际写出的字节数
+     */
+    SerializedSize save_ciphertexts(const std::vector<Ciphertext>& cts, std::vector<uint8_t>& buffer,
+                                    bool compress = true) const;
+
+    /**
+     * @brief 从流反序列化密文向量
+     * @param in 输入流
+     * @param cts 输出密文向量，密文从对象池分配
+     * @throws std::runtime_error 当数据格式错误、方案不匹配，或密文数、帧长超出剩余字节数
+     *         或该上下文的最大密文大小时抛出异常
+     */
+    void load_ciphertexts(std::istream& in, std::vector<Ciphertext>& cts) const;
+
+    /**
+     * @brief 从内存缓冲区反序列化密文向量
+     * @param data 缓冲区首地址
+     * @param size 缓冲区字节数
+     * @param cts 输出密文向量
+     * @throws std::runtime_error 当数据格式错误或方案不匹配时抛出异常
+     */
+    void load_ciphertexts(const uint8_t* data, size_t size, std::vector<Ciphertext>& cts) const;
+
+    /**
+     * @brief 序列化公钥
+     * @param out 输出流
+     * @param compress 为true时用zstd压缩
+     * @return 未压缩和实际写出的字节数
+     * 
+     * HElib的公钥包含重线性化所需的密钥交换矩阵。
+     */
+    SerializedSize save_public_key(std::ostream& out, bool compress = true) const;
+
+    /**
+     * @brief 序列化重线性化密钥（仅BFV）
+     * @param out 输出流
+     * @param compress 为true时用zstd压缩
+     * @return 未压缩和实际写出的字节数
+     * @throws std::invalid_argument 当方案为BGV时抛出异常（密钥交换矩阵随公钥保存）
+     */
+    SerializedSize save_relin_keys(std::ostream& out, bool compress = true) const;
+
+    /**
+     * @brief 加载公钥，替换当前公钥
+     * @param in 输入流
+     * @throws std::runtime_error 当数据格式错误时抛出异常
+     * 
+     * 已构造的SEAL加密器随之重建；HElib对象池丢弃旧公钥下的空闲密文。
+     */
+    void load_public_key(std::istream& in);
+
+    /**
+     * @brief 加载重线性化密钥（仅BFV），替换当前密钥
+     * @param in 输入流
+     * @throws std::invalid_argument 当方案为BGV时抛出异常
+     */
+    void load_relin_keys(std::istream& in);
+
+    /**
+     * @brief 获取密文对象池统计信息
+     * @return 分配次数、新建密文对象次数和空闲对象数
+     * 
+     * 评估热循环中的密文从对象池取出，预热后新建次数不再随评估次数增长。
+     */
+    CiphertextPool::Stats ciphertext_pool_stats() const;
+
+    /**
+     * @brief 计算密钥流吞吐量
+     * @param block_count 一次评估生成的块数（通常为slot_count()）
+     * @param trunc_m 截断位数，每块输出36-trunc_m个字
      * @param eval_time 评估时间（毫秒）
-     * @return 吞吐量（KB/s）
+     * @return 吞吐量（KiB/s）
      * 
-     * 根据数据大小和评估时间计算同态加密的吞吐量性能指标。
+     * block_count·(36-trunc_m)个字按throughput_kibps（utils.h）换算。
      */
-    double get_throughput(uint32_t data_size, double eval_time) const;
+    double get_throughput(uint32_t block_count, uint32_t trunc_m, double eval_time) const;
 
 private:
     FHE_SCHEME scheme_; ///< 同态加密方案（BGV或BFV）
@@ -145,24 +605,308 @@ private:
     std::unique_ptr<seal::SecretKey> seal_seckey_;         ///< SEAL私钥
     std::unique_ptr<seal::PublicKey> seal_pubkey_;         ///< SEAL公钥
     std::unique_ptr<seal::RelinKeys> seal_relin_keys_;     ///< SEAL重线性化密钥
-    std::unique_ptr<seal::Encryptor> seal_encryptor_;      ///< SEAL加密器
-    std::unique_ptr<seal::Decryptor> seal_decryptor_;      ///< SEAL解密器
-    std::unique_ptr<seal::Evaluator> seal_evaluator_;      ///< SEAL评估器
-    std::unique_ptr<seal::BatchEncoder> seal_batch_encoder_; ///< SEAL批处理编码器
+    std::unique_ptr<seal::GaloisKeys> seal_galois_keys_;   ///< SEAL伽罗瓦密钥（列式打包，可为空）
+
+    // SEAL操作器在首次使用时构造，只做评估或只做加密的进程不构造用不到的对象
+    mutable std::unique_ptr<seal::Encryptor> seal_encryptor_;        ///< SEAL加密器
+    mutable std::unique_ptr<seal::Decryptor> seal_decryptor_;        ///< SEAL解密器
+    mutable std::unique_ptr<seal::Evaluator> seal_evaluator_;        ///< SEAL评估器
+    mutable std::unique_ptr<seal::BatchEncoder> seal_batch_encoder_; ///< SEAL批处理编码器
+    mutable std::once_flag seal_encryptor_once_;                     ///< 加密器构造标志
+    mutable std::once_flag seal_decryptor_once_;                     ///< 解密器构造标志
+    mutable std::once_flag seal_evaluator_once_;                     ///< 评估器构造标志
+    mutable std::once_flag seal_batch_encoder_once_;                 ///< 批处理编码器构造标志
+    mutable std::vector<seal::Plaintext> column_diagonals_;          ///< 列式线性层的预旋转对角明文
+    mutable std::once_flag column_diagonals_once_;                   ///< 对角明文编码标志
+
+    LinearLayer linear_layer_;         ///< 线性层组件实例
+    AdditionSchedule linear_schedule_; ///< 完整36行的线性层加法调度
+
+    std::unique_ptr<ThreadPool> thread_pool_;        ///< 同态评估持久线程池
+    std::vector<seal::MemoryPoolHandle> seal_pools_; ///< 每个工作者独占的SEAL内存池
+    std::shared_ptr<CiphertextPool> ciphertext_pool_; ///< 密文对象池，声明在库对象之后以便先于上下文析构
 
     /**
-     * @brief 初始化HElib(BGV方案)
-     * 
-     * 配置HElib的BGV方案参数，生成密钥对并初始化加密上下文。
+     * @brief 初始化HElib(BGV方案)上下文
      */
     void init_helib();
 
     /**
-     * @brief 初始化SEAL(BFV方案)
-     * 
-     * 配置SEAL的BFV方案参数，生成密钥对、重线性化密钥，并初始化各种操作器。
+     * @brief 初始化SEAL(BFV方案)上下文
      */
     void init_seal();
+
+    /**
+     * @brief 按参数的安全级别构建SEAL上下文
+     * @param enc_params SEAL加密参数
+     */
+    void make_seal_context(const seal::EncryptionParameters& enc_params);
+
+    /**
+     * @brief 初始化线程池、每个工作者的SEAL内存池和密文对象池
+     * @param num_threads 工作线程数，0表示使用硬件并发数
+     */
+    void init_runtime(uint32_t num_threads);
+
+    /**
+     * @brief 生成HElib私钥和公钥（含密钥交换矩阵）
+     */
+    void generate_helib_keys();
+
+    /**
+     * @brief 生成SEAL私钥、公钥和重线性化密钥，已构造的加密器和解密器随之重建
+     */
+    void generate_seal_keys();
+
+    /**
+     * @brief 从目录加载HElib上下文和密钥
+     */
+    void load_helib(const std::string& key_dir, bool eval_only);
+
+    /**
+     * @brief 从目录加载SEAL上下文和密钥
+     */
+    void load_seal(const std::string& key_dir, bool eval_only);
+
+    /**
+     * @brief 获取SEAL加密器，首次调用时构造
+     */
+    const seal::Encryptor& seal_encryptor() const;
+
+    /**
+     * @brief 获取SEAL解密器，首次调用时构造
+     * @throws std::runtime_error 当未持有私钥时抛出异常
+     */
+    seal::Decryptor& seal_decryptor() const;
+
+    /**
+     * @brief 获取SEAL评估器，首次调用时构造
+     */
+    const seal::Evaluator& seal_evaluator() const;
+
+    /**
+     * @brief 获取SEAL批处理编码器，首次调用时构造
+     */
+    const seal::BatchEncoder& seal_batch_encoder() const;
+
+    /**
+     * @brief 加密槽向量
+     * @param slots 每个槽的明文值（已模p约简）
+     * @param worker 工作者编号
+     * @return 从密文对象池分配的新密文
+     */
+    Ciphertext encrypt_slots(const std::vector<uint64_t>& slots, size_t worker = 0);
+
+    /**
+     * @brief 获取工作者独占的SEAL内存池
+     * @param worker 工作者编号
+     * @return 该工作者的内存池句柄
+     */
+    const seal::MemoryPoolHandle& seal_pool(size_t worker) const;
+
+    /**
+     * @brief 单个密文序列化帧的最大字节数，用于在反序列化时拒绝帧头声明的超长帧
+     */
+    uint64_t max_ciphertext_frame_bytes() const;
+
+    /**
+     * @brief 复制密文，目标为空或与其他句柄共享时从对象池分配，否则复用其存储
+     */
+    void copy_ciphertext(Ciphertext& dst, const Ciphertext& src, size_t worker = 0) const;
+
+    /**
+     * @brief 密文原地加法：dst += src
+     */
+    void add_inplace(Ciphertext& dst, const Ciphertext& src) const;
+
+    /**
+     * @brief 密文原地减法：dst -= src
+     */
+    void sub_inplace(Ciphertext& dst, const Ciphertext& src) const;
+
+    /**
+     * @brief 密文原地取负：ct = -ct
+     */
+    void negate_inplace(Ciphertext& ct) const;
+
+    /**
+     * @brief 密文乘法并重线性化：dst = a * b
+     * 
+     * trace非空时记录重线性化（HElib为含重线性化的乘法）的时间跨度。
+     */
+    void multiply(const Ciphertext& a, const Ciphertext& b, Ciphertext& dst, size_t worker = 0,
+                  TraceRecorder* trace = nullptr) const;
+
+    /**
+     * @brief 密文所在的模数链层级
+     * @return SEAL为chain_index，HElib为剩余密文素数个数，均随模数切换减小
+     */
+    int64_t ciphertext_level(const Ciphertext& ct) const;
+
+    /**
+     * @brief 密文与明文槽向量原地相乘
+     */
+    void multiply_plain_inplace(Ciphertext& ct, const std::vector<uint64_t>& slots, size_t worker = 0) const;
+
+    /**
+     * @brief 密文与明文槽向量原地相加
+     */
+    void add_plain_inplace(Ciphertext& ct, const std::vector<uint64_t>& slots, size_t worker = 0) const;
+
+    /**
+     * @brief 密文模数切换：丢弃levels个模数
+     * @throws std::invalid_argument 当模数链不足时抛出异常
+     * 
+     * SEAL使用mod_switch_to_next_inplace，HElib通过modDownToSet丢弃最高的密文素数。
+     */
+    void mod_switch_down(Ciphertext& ct, uint32_t levels, size_t worker = 0) const;
+
+    /**
+     * @struct SlotBlock
+     * @brief 单个槽对应的轮密钥生成器（即随机数）和块索引
+     */
+    struct SlotBlock {
+        const RoundKeyGenerator* rk_gen;
+        uint32_t block;
+    };
+
+    /**
+     * @brief 生成一轮的行式打包轮常数
+     * @param slot_blocks 有效槽的随机数和块索引，其余槽填0
+     * @param round 轮索引
+     * @return 36个槽向量，第i个向量的槽j为slot_blocks[j]的rc_i
+     */
+    std::vector<std::vector<uint64_t>> round_constant_slots(
+        const std::vector<SlotBlock>& slot_blocks, uint32_t round) const;
+
+    /**
+     * @brief 由评估参数生成各有效槽（或列式打包下各槽区间）的随机数和块索引
+     * @param eval_params 评估参数
+     * @param capacity 最大块数
+     * @param rk_gens 输出的轮密钥生成器，每个随机数一个，生命周期须覆盖返回值
+     * @return 各块的随机数和块索引
+     * @throws std::invalid_argument 当块数超过capacity时抛出异常
+     */
+    std::vector<SlotBlock> make_slot_blocks(const YuSEvalParams& eval_params, size_t capacity,
+                                            std::vector<std::unique_ptr<RoundKeyGenerator>>& rk_gens) const;
+
+    /**
+     * @brief 列式打包下每块占用的槽数
+     * @param level 安全级别
+     */
+    size_t column_region_size(SecurityLevel level) const;
+
+    /**
+     * @brief 列式打包下第j块的槽区间起点
+     * @param j 块在本次评估中的序号
+     * @param region 每块占用的槽数
+     */
+    size_t column_slot(size_t j, size_t region) const;
+
+    /**
+     * @brief 把每块的36个值按列式打包展开为3个槽向量
+     * @param values 第j项为块j的36个值
+     * @param region 每块占用的槽数
+     * @return 3个槽向量，块j的槽区间内第q个槽为values[j][3(q mod 12)+t]，其余槽为0
+     */
+    std::vector<std::vector<uint64_t>> column_slots(const std::vector<std::vector<uint64_t>>& values,
+                                                    size_t region) const;
+
+    /**
+     * @brief 编码列式线性层的预旋转对角明文，首次调用时执行
+     * @return 按[(t'·3+t)·3+g]·4+b索引的108个明文，全零对角为空明文
+     */
+    const std::vector<seal::Plaintext>& column_diagonals() const;
+
+    /**
+     * @brief 列式打包的同态线性层
+     * @param state 3个输入密文
+     * @param temps 小步旋转、部分和与对角乘积的27个临时密文，跨层复用
+     * @param out 3个输出密文
+     * @param trace 时间线记录器，可为空
+     * @throws std::runtime_error 当某个输出没有非零对角线时抛出异常
+     * 
+     * 输出t'的槽q = Σ_t Σ_d diag_{t',t,d}[q]·in_t[q+d]，d = 4g+b（g∈{0,1,2}，b∈{0..3}）：
+     * out_{t'} = Σ_g rot_{4g}(Σ_{t,b} diag'_{t',t,g,b} ⊙ rot_b(in_t))，其中diag'为右旋4g后的对角线。
+     */
+    void eval_column_linear_layer(const std::vector<Ciphertext>& state, std::vector<Ciphertext>& temps,
+                                  std::vector<Ciphertext>& out, TraceRecorder* trace) const;
+
+    /**
+     * @brief 同态S盒层
+     * @param state 36个状态密文，原地更新
+     * @param products 24个乘积临时密文，跨轮复用
+     * @param trace 时间线记录器，可为空
+     * 
+     * 每个S盒计算x0*x2和x0*x1两次密文乘法：
+     * y1 = x1 + x0x2，y2 = x2 + x0x2 - x0x1，y0保持不变。
+     */
+    void eval_sbox_layer(std::vector<Ciphertext>& state, std::vector<Ciphertext>& products,
+                         TraceRecorder* trace) const;
+
+    /**
+     * @brief 使用密钥乘积的第一轮同态S盒层
+     * @param state 白化后的36个状态密文，原地更新
+     * @param cipher_key 与状态同层的加密主密钥
+     * @param key_products 与状态同层的24个加密密钥乘积
+     * @param cv 白化使用的计数器槽向量
+     * @param rc0 白化使用的第0轮轮常数槽向量
+     * @param products 24个乘积临时密文
+     * @param scratch 至少12个临时密文
+     * @param trace 时间线记录器，可为空
+     * 
+     * x_a·x_b = cv_a·cv_b + (cv_a·rc_b)·E(k_b) + (cv_b·rc_a)·E(k_a) + (rc_a·rc_b)·E(k_a·k_b)，
+     * 其中明文系数在槽上逐元素模p计算，不需要密文乘法和重线性化。
+     */
+    void eval_first_sbox_layer(std::vector<Ciphertext>& state, const std::vector<Ciphertext>& cipher_key,
+                               const std::vector<Ciphertext>& key_products,
+                               const std::vector<std::vector<uint64_t>>& cv,
+                               const std::vector<std::vector<uint64_t>>& rc0,
+                               std::vector<Ciphertext>& products,
+                               std::vector<Ciphertext>& scratch,
+                               TraceRecorder* trace) const;
+
+    /**
+     * @brief 同态线性层
+     * @param state 36个输入状态密文
+     * @param schedule 加法调度，决定计算哪些行
+     * @param temps 部分和临时密文，跨层复用
+     * @param out 输出密文，out[i]对应行schedule.first_row+i
+     * @param trace 时间线记录器，可为空
+     * @throws std::runtime_error 当调度中存在空行时抛出异常
+     * 
+     * 只使用原地加法，部分和与输出密文在多次调用间复用存储。
+     * 9个列分组的部分和互不依赖，先按分组并行构造，再按不相交的行分组并行累加。
+     */
+    void eval_linear_layer(const std::vector<Ciphertext>& state, const AdditionSchedule& schedule,
+                           std::vector<Ciphertext>& temps, std::vector<Ciphertext>& out,
+                           TraceRecorder* trace) const;
+
+    /**
+     * @brief 记录一个阶段的噪声遥测和堆分配
+     * @param stage 阶段名
+     * @param cts 该阶段的密文
+     * @param eval_params 遥测选项
+     * @param start 评估开始时间
+     * @param alloc_mark 上一阶段结束时的分配计数，返回前更新为噪声测量之后的计数
+     * @param report 评估报告
+     * @throws std::runtime_error 当噪声预算低于min_noise_budget时抛出异常
+     */
+    void record_noise_stage(const std::string& stage, const std::vector<Ciphertext>& cts,
+                            const YuSEvalParams& eval_params,
+                            std::chrono::steady_clock::time_point start,
+                            AllocCounts& alloc_mark, YuSEvalReport& report) const;
+
+    /**
+     * @brief 同态轮密钥加：state_i += E(k_i) ⊙ rc_i
+     * @param state 36个状态密文，原地更新
+     * @param cipher_key 加密的主密钥
+     * @param rc 行式打包的轮常数
+     * @param scratch 36个临时密文，跨轮复用
+     */
+    void eval_add_round_key(std::vector<Ciphertext>& state, const std::vector<Ciphertext>& cipher_key,
+                            const std::vector<std::vector<uint64_t>>& rc,
+                            std::vector<Ciphertext>& scratch) const;
 };
 
 } // namespace yus
@@ -0,0 +1,167 @@
+/**
+ * @file instrument.h
+ * @brief YuS流密码热路径插桩头文件
+ * @author Aurorp1g
+ * @date 2025-11-07
+ *
+ * 定义按阶段统计调用次数、耗时和字节数的轻量插桩。CMake选项YUS_INSTRUMENT
+ * 打开时定义YUS_INSTRUMENT宏，插桩点展开为计数代码；关闭时展开为空语句，
+ * 热路径上没有任何额外开销，查询接口仍可调用并返回全零。
+ *
+ * 计数器按线程保存，只由所属线程写入，写入不加锁也不使用原子读改写；
+ * 汇总时在锁内读取所有线程的计数器，已退出线程的计数并入累计值。
+ */
+
+#ifndef YUS_INSTRUMENT_H
+#define YUS_INSTRUMENT_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace yus {
+
+/**
+ * @enum Stage
+ * @brief 插桩统计的阶段
+ *
+ * 前四项同时由明文YuSCipher和同态评估记录：明文按块计数，同态按整次评估计数，
+ * 同态阶段的耗时是调用线程上的墙钟时间。FHE_*按单个密文操作计数，
+ * 耗时在各工作线程上累加，即CPU时间。
+ */
+enum class Stage : uint32_t {
+    WHITENING,          ///< 密钥白化（含第0轮的轮常数和轮密钥）
+    SBOX_LAYER,         ///< S盒层
+    LINEAR_LAYER,       ///< 线性层（含最终线性层）
+    ROUND_KEY,          ///< 第1..r轮的轮常数和轮密钥派生（同态评估还含轮密钥加）
+    XOF,                ///< SHAKE128挤出，bytes为输出字节数；耗时包含在调用它的阶段内
+    FHE_MULTIPLY,       ///< 密文乘法
+    FHE_RELINEARIZE,    ///< 重线性化；HElib在乘法内完成，只计次数
+    FHE_ROTATE,         ///< 槽旋转
+    FHE_MOD_SWITCH      ///< 模数切换（每个密文每次切换计一次）
+};
+
+/// 阶段个数
+constexpr size_t kStageCount = 9;
+
+/**
+ * @brief 获取阶段名
+ * @param stage 阶段
+ * @return 小写阶段名，例如"sbox_layer"
+ */
+const char* stage_name(Stage stage);
+
+/**
+ * @struct StageCounter
+ * @brief 单个阶段的计数
+ */
+struct StageCounter {
+    uint64_t calls = 0;     ///< 调用次数
+    uint64_t ns = 0;        ///< 累计耗时（纳秒）
+    uint64_t bytes = 0;     ///< 累计字节数（仅XOF）
+};
+
+/**
+ * @struct InstrumentSnapshot
+ * @brief 所有线程计数的汇总快照
+ */
+struct InstrumentSnapshot {
+    std::array<StageCounter, kStageCount> stages{}; ///< 按Stage顺序排列的计数
+
+    /**
+     * @brief 获取某个阶段的计数
+     */
+    const StageCounter& operator[](Stage stage) const;
+
+    /**
+     * @brief 序列化为JSON对象
+     * @return 形如{"whitening":{"calls":..,"ns":..,"bytes":..},...}的字符串
+     */
+    std::string to_json() const;
+
+    /**
+     * @brief 以表格形式输出调用次数、总耗时、平均耗时和字节数
+     * @param out 输出流
+     */
+    void print(std::ostream& out) const;
+};
+
+/**
+ * @brief 插桩是否已编译进库
+ * @return 构建时打开YUS_INSTRUMENT选项时返回true
+ */
+bool instrument_enabled();
+
+/**
+ * @brief 汇总所有线程自上次instrument_reset()以来的计数
+ * @return 计数快照；插桩未编译时全为0
+ *
+ * 与正在写入的线程并发调用是安全的，读到的计数可能略微滞后。
+ */
+InstrumentSnapshot instrument_snapshot();
+
+/**
+ * @brief 把所有线程的计数清零
+ *
+ * 记录当前汇总值作为基线，之后的快照减去基线，不需要其他线程配合。
+ */
+void instrument_reset();
+
+namespace detail {
+
+/**
+ * @brief 向当前线程的计数器累加一次记录
+ * @param stage 阶段
+ * @param ns 耗时（纳秒）
+ * @param bytes 字节数
+ */
+void instrument_record(Stage stage, uint64_t ns, uint64_t bytes);
+
+/**
+ * @brief 读取插桩使用的单调时钟（纳秒）
+ */
+uint64_t instrument_now();
+
+/**
+ * @class StageScope
+ * @brief 作用域计时：析构时记录一次调用、经过的时间和字节数
+ */
+class StageScope {
+public:
+    explicit StageScope(Stage stage, uint64_t bytes = 0)
+        : stage_(stage), bytes_(bytes), start_(instrument_now()) {}
+    ~StageScope() { instrument_record(stage_, instrument_now() - start_, bytes_); }
+    StageScope(const StageScope&) = delete;
+    StageScope& operator=(const StageScope&) = delete;
+
+private:
+    Stage stage_;       ///< 阶段
+    uint64_t bytes_;    ///< 字节数
+    uint64_t start_;    ///< 开始时间（纳秒）
+};
+
+} // namespace detail
+
+} // namespace yus
+
+#define YUS_INSTRUMENT_CONCAT_(a, b) a##b
+#define YUS_INSTRUMENT_CONCAT(a, b) YUS_INSTRUMENT_CONCAT_(a, b)
+
+#if defined(YUS_INSTRUMENT)
+/// 统计当前作用域：一次调用及其耗时
+#define YUS_INSTRUMENT_SCOPE(stage) \
+    ::yus::detail::StageScope YUS_INSTRUMENT_CONCAT(yus_instrument_scope_, __LINE__)(stage)
+/// 统计当前作用域并累加字节数
+#define YUS_INSTRUMENT_SCOPE_BYTES(stage, bytes) \
+    ::yus::detail::StageScope YUS_INSTRUMENT_CONCAT(yus_instrument_scope_, __LINE__)((stage), (bytes))
+/// 只计一次调用，不计时
+#define YUS_INSTRUMENT_COUNT(stage) ::yus::detail::instrument_record((stage), 0, 0)
+#else
+#define YUS_INSTRUMENT_SCOPE(stage) ((void)0)
+#define YUS_INSTRUMENT_SCOPE_BYTES(stage, bytes) ((void)0)
+#define YUS_INSTRUMENT_COUNT(stage) ((void)0)
+#endif
+
+#endif // YUS_INSTRUMENT_H
@@ -0,0 +1,153 @@
+/**
+ * @file keystream_store.h
+ * @brief YuS流密码加密密钥流缓存头文件
+ * @author Aurorp1g
+ * @date 2025-11-07
+ *
+ * 定义离线/在线分离转密所用的加密密钥流缓存。
+ * 同态密钥流只依赖加密密钥和随机数，服务端可在空闲时为已公布的随机数预先评估，
+ * 客户端数据到达后只需一次减法即可完成转密。
+ */
+
+#ifndef YUS_KEYSTREAM_STORE_H
+#define YUS_KEYSTREAM_STORE_H
+
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <list>
+#include <map>
+#include <tuple>
+#include <mutex>
+#include "fhe_wrapper.h"
+
+namespace yus {
+
+/**
+ * @class KeystreamStore
+ * @brief 加密密钥流缓存类
+ *
+ * 以(密钥标识, 随机数, 安全级别, 截断, 首块)为索引保存行式打包的加密密钥流，
+ * 支持条目数和字节数两种容量限制，超出时按最近最少使用顺序淘汰。
+ * 所有接口线程安全，离线预计算与在线查询可以并发进行。
+ */
+class KeystreamStore {
+public:
+    /**
+     * @struct Stats
+     * @brief 缓存统计信息
+     */
+    struct Stats {
+        uint64_t hits;       ///< 命中次数
+        uint64_t misses;     ///< 未命中次数
+        uint64_t evictions;  ///< 因容量限制淘汰的条目数
+    };
+
+    /**
+     * @brief 构造函数
+     * @param max_entries 最大条目数，0表示不限制
+     * @param max_bytes 最大密文字节数，0表示不限制
+     */
+    KeystreamStore(size_t max_entries, size_t max_bytes);
+
+    /**
+     * @brief 离线预计算并缓存加密密钥流
+     * @param fhe 同态加密封装实例
+     * @param key_id 加密密钥标识
+     * @param cipher_key 加密的主密钥
+     * @param key_products 24个加密密钥乘积，可为空
+     * @param eval_params 随机数、轮数、截断和块范围
+     * @return 评估时间（毫秒）
+     *
+     * 评估在调用线程上进行，不持有缓存锁，期间在线查询不受阻塞。
+     */
+    double precompute(FHEWrapper& fhe, const std::string& key_id,
+                      const std::vector<Ciphertext>& cipher_key,
+                      const std::vector<Ciphertext>& key_products,
+                      const YuSEvalParams& eval_params);
+
+    /**
+     * @brief 插入加密密钥流
+     * @param key_id 加密密钥标识
+     * @param eval_params 生成该密钥流所用的评估参数
+     * @param cipher_keystream 36-trunc_m个行式打包密文
+     * @param bytes 密文占用的字节数
+     * @return 插入成功返回true；单个条目超过字节容量或按段合并评估时返回false
+     *
+     * 相同索引的旧条目被替换，超出容量时淘汰最近最少使用的条目。
+     */
+    bool insert(const std::string& key_id, const YuSEvalParams& eval_params,
+                std::vector<Ciphertext> cipher_keystream, size_t bytes);
+
+    /**
+     * @brief 查询加密密钥流
+     * @param key_id 加密密钥标识
+     * @param eval_params 需要的随机数、轮数、截断和块范围
+     * @param cipher_keystream 命中时输出缓存的密文（共享引用，调用方不得原地修改）
+     * @return 命中返回true
+     *
+     * 要求首块相同且缓存条目覆盖的块数不少于请求的块数；按段合并的请求总是未命中。
+     */
+    bool lookup(const std::string& key_id, const YuSEvalParams& eval_params,
+                std::vector<Ciphertext>& cipher_keystream);
+
+    /**
+     * @brief 删除某个随机数下的全部条目
+     * @param key_id 加密密钥标识
+     * @param nonce 随机数
+     * @return 删除的条目数
+     */
+    size_t erase(const std::string& key_id, const std::vector<uint8_t>& nonce);
+
+    /**
+     * @brief 获取条目数
+     */
+    size_t size() const;
+
+    /**
+     * @brief 获取缓存密文的总字节数
+     */
+    size_t bytes() const;
+
+    /**
+     * @brief 获取统计信息
+     */
+    Stats stats() const;
+
+private:
+    /// 索引：(密钥标识, 随机数, 安全级别, 截断, 首块)
+    using Key = std::tuple<std::string, std::vector<uint8_t>, uint32_t, uint32_t, uint32_t>;
+
+    /**
+     * @struct Entry
+     * @brief 缓存条目
+     */
+    struct Entry {
+        Key key;                                          ///< 条目索引
+        uint32_t block_count;                             ///< 覆盖的块数
+        std::vector<Ciphertext> keystream; ///< 加密密钥流
+        size_t bytes;                                     ///< 密文字节数
+    };
+
+    size_t max_entries_;                 ///< 最大条目数
+    size_t max_bytes_;                   ///< 最大字节数
+    size_t bytes_;                       ///< 当前字节数
+    Stats stats_;                        ///< 统计信息
+    std::list<Entry> lru_;               ///< 条目链表，表头为最近使用
+    std::map<Key, std::list<Entry>::iterator> index_; ///< 索引到链表节点
+    mutable std::mutex mutex_;           ///< 保护以上状态
+
+    /**
+     * @brief 构造条目索引
+     */
+    static Key make_key(const std::string& key_id, const YuSEvalParams& eval_params);
+
+    /**
+     * @brief 淘汰条目直到满足容量限制（调用方持有锁）
+     */
+    void evict();
+};
+
+} // namespace yus
+
+#endif // YUS_KEYSTREAM_STORE_H
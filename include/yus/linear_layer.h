@@ -17,6 +17,37 @@
 
 namespace yus {
 
+/**
+ * @struct AdditionSchedule
+ * @brief 线性层加法调度
+ * 
+ * 将36x36二进制矩阵乘法展开为纯加法序列，明文线性层与同态线性层共用同一调度。
+ * 寄存器0..35对应输入状态，36及以上为四俄罗斯人分组部分和的临时寄存器。
+ */
+struct AdditionSchedule {
+    /**
+     * @struct Step
+     * @brief 单步加法：reg[dst] = reg[lhs] + reg[rhs]
+     */
+    struct Step {
+        uint32_t dst; ///< 目标临时寄存器
+        uint32_t lhs; ///< 左操作数寄存器
+        uint32_t rhs; ///< 右操作数寄存器
+        uint32_t group; ///< 所属列分组，不同分组的步骤之间没有依赖
+    };
+
+    uint32_t first_row = 0;                   ///< 首个输出行，截断时跳过前first_row行
+    uint32_t num_registers = 36;              ///< 寄存器总数（输入+临时）
+    std::vector<Step> partial_sums;           ///< 分组部分和构造步骤，按依赖顺序排列
+    std::vector<std::vector<uint32_t>> rows;  ///< rows[i]为输出行first_row+i需要累加的寄存器
+
+    /**
+     * @brief 统计调度所需的加法次数
+     * @return 部分和构造与行累加的加法总数
+     */
+    uint32_t addition_count() const;
+};
+
 /**
  * @class LinearLayer
  * @brief YuS流密码线性层组件类
@@ -44,6 +75,22 @@ public:
      */
     std::vector<mpz_class> apply(const std::vector<mpz_class>& state, const mpz_class& p) const;
 
+    /**
+     * @brief 生成加法调度
+     * @param first_row 首个需要计算的输出行，默认0表示全部36行
+     * @return 只覆盖行first_row..35的加法调度
+     * @throws std::invalid_argument 当first_row大于36时抛出异常
+     * 
+     * 只构造被所需行引用的分组部分和，最终线性层可跳过被截断丢弃的行。
+     */
+    AdditionSchedule addition_schedule(uint32_t first_row = 0) const;
+
+    /**
+     * @brief 获取36x36二进制矩阵
+     * @return 线性层矩阵的只读引用
+     */
+    const std::vector<std::vector<uint8_t>>& matrix() const;
+
     /**
      * @brief 获取线性分支数
      * @return 线性分支数
@@ -68,11 +115,12 @@ private:
     /**
      * @brief 预计算四俄罗斯人算法表
      * 
-     * 使用四俄罗斯人算法优化矩阵乘法，将36列分成9组，每组4列。
+     * 使用四俄罗斯人算法优化矩阵乘法，将36列分成9组，每组4列，
+     * 生成覆盖全部36行的加法调度。
      */
     void precompute_four_russians();
     
-    std::vector<std::vector<mpz_class>> four_russians_table_; ///< 四俄罗斯人算法预计算表
+    AdditionSchedule schedule_; ///< 全部36行的四俄罗斯人加法调度
 };
 
 } // namespace yus
@@ -0,0 +1,114 @@
+/**
+ * @file perf_counters.h
+ * @brief YuS流密码硬件性能计数器头文件
+ * @author Aurorp1g
+ * @date 2025-11-07
+ *
+ * 通过Linux perf_event_open读取硬件计数器：周期、指令、L1数据缓存未命中、
+ * 末级缓存未命中和分支预测失败，另可按原始事件编码添加型号相关的事件
+ * （例如AVX频率许可事件）。只统计用户态，perf_event_paranoid为2时仍可打开。
+ *
+ * 计数范围是构造PerfCounters的线程，以及该线程在构造之后创建的线程（perf的inherit），
+ * 因此要统计OpenMP并行区，必须在第一个并行区创建线程组之前构造；之前已存在的线程不计入。
+ *
+ * 容器、虚拟机或非Linux平台上计数器可能无法打开，此时available()返回false，
+ * error()给出原因，start()/stop()什么都不做，调用方照常计时即可。
+ */
+
+#ifndef YUS_PERF_COUNTERS_H
+#define YUS_PERF_COUNTERS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace yus {
+
+/**
+ * @struct PerfCounter
+ * @brief 单个硬件计数器
+ */
+struct PerfCounter {
+    std::string name;           ///< 计数器名，例如"cycles"、"llc_misses"
+    int fd = -1;                ///< perf事件文件描述符，-1表示不可用
+    double value = 0;           ///< 最近一次start()/stop()区间的计数（已按复用比例缩放）
+};
+
+/**
+ * @class PerfCounters
+ * @brief 一组统计当前线程及其之后创建的线程的硬件计数器
+ *
+ * 各事件独立打开，某个事件不受支持不影响其他事件。计数器数量超过硬件寄存器时
+ * 内核轮流调度，读数按enabled/running时间比例缩放。
+ */
+class PerfCounters {
+public:
+    /**
+     * @brief 构造函数，打开cycles、instructions、l1d_misses、llc_misses和branch_misses
+     *
+     * 打开失败不抛出异常，只把对应计数器标记为不可用。
+     */
+    PerfCounters();
+
+    /**
+     * @brief 析构函数，关闭所有事件
+     */
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    /**
+     * @brief 添加原始硬件事件
+     * @param name 计数器名
+     * @param config PERF_TYPE_RAW的事件编码，例如Skylake-SP上
+     *               CORE_POWER.LVL1_TURBO_LICENSE为0x1828
+     * @return 打开成功时返回true
+     */
+    bool add_raw(const std::string& name, uint64_t config);
+
+    /**
+     * @brief 是否至少有一个计数器可用
+     */
+    bool available() const;
+
+    /**
+     * @brief 第一个打开失败的事件及原因，全部可用时为空
+     */
+    const std::string& error() const { return error_; }
+
+    /**
+     * @brief 清零并开始计数
+     */
+    void start();
+
+    /**
+     * @brief 停止计数并读取各计数器
+     */
+    void stop();
+
+    /**
+     * @brief 所有计数器（含不可用的）
+     */
+    const std::vector<PerfCounter>& counters() const { return counters_; }
+
+    /**
+     * @brief 按名称获取最近一次区间的计数
+     * @param name 计数器名
+     * @return 计数；计数器不存在或不可用时返回-1
+     */
+    double value(const std::string& name) const;
+
+private:
+    /**
+     * @brief 打开一个事件并追加到计数器列表
+     */
+    bool open(const std::string& name, uint32_t type, uint64_t config);
+
+    std::vector<PerfCounter> counters_; ///< 计数器
+    std::string error_;                 ///< 第一个打开失败的原因
+};
+
+} // namespace yus
+
+#endif // YUS_PERF_COUNTERS_H
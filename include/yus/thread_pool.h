@@ -0,0 +1,105 @@
+/**
+ * @file thread_pool.h
+ * @brief YuS流密码持久线程池头文件
+ * @author Aurorp1g
+ * @date 2025-11-07
+ *
+ * 定义同态评估使用的持久线程池接口。
+ * 工作线程在构造时创建并常驻，每次并行任务只需唤醒而无需重新创建线程。
+ */
+
+#ifndef YUS_THREAD_POOL_H
+#define YUS_THREAD_POOL_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <exception>
+
+namespace yus {
+
+/**
+ * @class ThreadPool
+ * @brief 持久线程池类
+ *
+ * 提供阻塞式的parallel_for接口，调用线程作为0号工作者参与计算。
+ * 每个任务回调都会收到工作者编号，调用方可据此索引每线程独占的资源
+ * （例如SEAL内存池），避免共享资源上的锁竞争。
+ */
+class ThreadPool {
+public:
+    /**
+     * @brief 构造函数
+     * @param num_threads 工作者数量（含调用线程），0表示使用硬件并发数
+     */
+    explicit ThreadPool(size_t num_threads = 0);
+
+    /**
+     * @brief 析构函数
+     *
+     * 通知所有工作线程退出并等待其结束。
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief 获取工作者数量
+     * @return 工作者数量（含调用线程）
+     */
+    size_t size() const;
+
+    /**
+     * @brief 并行执行count个相互独立的任务
+     * @param count 任务数量
+     * @param fn 任务回调，参数为任务索引和工作者编号（小于size()）
+     * @throws 重新抛出任务中抛出的第一个异常
+     *
+     * 任务通过原子计数器动态分配，函数在全部任务完成后返回。
+     * 在本线程池的任务内部再次调用时直接在当前线程串行执行，避免死锁；
+     * 其他线程（包括另一个线程池的工作线程）总是以0号工作者身份提交，编号不会越过本线程池的size()。
+     */
+    void parallel_for(size_t count, const std::function<void(size_t, size_t)>& fn);
+
+    /**
+     * @brief 获取当前线程的工作者编号
+     * @return 正在执行线程池任务时返回在该线程池中的编号，其余线程返回0
+     */
+    static size_t current_worker();
+
+private:
+    std::vector<std::thread> threads_;              ///< 常驻工作线程（编号1..size()-1）
+    std::mutex submit_mutex_;                       ///< 串行化来自不同调用线程的提交
+    std::mutex mutex_;                              ///< 保护任务状态
+    std::condition_variable work_cv_;               ///< 唤醒工作线程
+    std::condition_variable done_cv_;               ///< 通知调用线程任务完成
+    const std::function<void(size_t, size_t)>* task_; ///< 当前任务回调
+    size_t task_count_;                             ///< 当前任务数量
+    std::atomic<size_t> next_index_;                ///< 下一个待分配的任务索引
+    size_t active_;                                 ///< 仍在执行当前任务的工作线程数
+    uint64_t generation_;                           ///< 任务代数，用于唤醒判定
+    bool stop_;                                     ///< 退出标志
+    std::exception_ptr error_;                      ///< 第一个任务异常
+
+    /**
+     * @brief 工作线程主循环
+     * @param worker 工作者编号
+     */
+    void worker_loop(size_t worker);
+
+    /**
+     * @brief 领取并执行当前任务的剩余索引
+     * @param worker 工作者编号
+     */
+    void run_tasks(size_t worker);
+};
+
+} // namespace yus
+
+#endif // YUS_THREAD_POOL_H
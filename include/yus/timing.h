@@ -0,0 +1,199 @@
+/**
+ * @file timing.h
+ * @brief YuS流密码计时组件头文件
+ * @author Aurorp1g
+ * @date 2025-11-07
+ *
+ * 定义纳秒级稳定时钟和时间戳计数器（TSC）计时器，以及收集样本并给出
+ * 最小值、中位数、p99和标准差的统计累加器。明文引擎、FHE封装和基准程序共用。
+ */
+
+#ifndef YUS_TIMING_H
+#define YUS_TIMING_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace yus {
+
+/**
+ * @enum TimerClock
+ * @brief 计时器使用的时钟
+ */
+enum class TimerClock {
+    STEADY, ///< std::chrono::steady_clock，纳秒
+    TSC     ///< 串行化的rdtsc/rdtscp，周期；仅x86可用
+};
+
+/**
+ * @brief 读取稳定时钟
+ * @return 任意起点的纳秒数，单调不减
+ */
+uint64_t steady_ns();
+
+/**
+ * @brief 当前平台是否提供不变的时间戳计数器
+ * @return x86且CPU声明constant_tsc/invariant TSC时返回true
+ */
+bool tsc_available();
+
+/**
+ * @brief 在计时区间起点读取TSC
+ * @return 时间戳计数器的值；不可用时返回steady_ns()
+ *
+ * lfence; rdtsc; lfence：之前的指令执行完才读取，之后的指令不会提前到读取之前。
+ */
+uint64_t tsc_begin();
+
+/**
+ * @brief 在计时区间终点读取TSC
+ * @return 时间戳计数器的值；不可用时返回steady_ns()
+ *
+ * rdtscp; lfence：区间内的指令执行完才读取，之后的指令不会提前到读取之前。
+ */
+uint64_t tsc_end();
+
+/**
+ * @brief 获取TSC频率
+ * @return 每纳秒的TSC周期数（GHz）；不可用时返回0
+ *
+ * 首次调用时对照稳定时钟校准约50毫秒，之后返回缓存值，线程安全。
+ * TSC按标称频率计数，与睿频或降频后的核心频率不同，CPB按TSC周期计算。
+ */
+double tsc_ghz();
+
+/**
+ * @class Timer
+ * @brief 性能计时器类
+ *
+ * 稳定时钟模式以纳秒计时；TSC模式以周期计时，适合亚微秒的单个S盒层等阶段。
+ * 平台不支持TSC时TSC模式退化为稳定时钟，clock()返回实际使用的时钟。
+ */
+class Timer {
+public:
+    /**
+     * @brief 构造函数
+     * @param clock 计时使用的时钟，默认稳定时钟
+     */
+    explicit Timer(TimerClock clock = TimerClock::STEADY);
+
+    /**
+     * @brief 开始计时
+     */
+    void start();
+
+    /**
+     * @brief 停止计时
+     */
+    void stop();
+
+    /**
+     * @brief 实际使用的时钟
+     */
+    TimerClock clock() const;
+
+    /**
+     * @brief 获取经过的原始计数
+     * @return 稳定时钟模式为纳秒，TSC模式为周期
+     */
+    uint64_t elapsed_ticks() const;
+
+    /**
+     * @brief 获取经过的时间（纳秒）
+     *
+     * TSC模式按tsc_ghz()换算。
+     */
+    double elapsed_ns() const;
+
+    /**
+     * @brief 获取经过的时间（毫秒）
+     */
+    double elapsed_ms() const;
+
+    /**
+     * @brief 获取经过的TSC周期数
+     * @return TSC模式直接返回计数；稳定时钟模式按tsc_ghz()换算，TSC不可用时返回0
+     */
+    double elapsed_cycles() const;
+
+private:
+    TimerClock clock_;     ///< 实际使用的时钟
+    uint64_t start_ticks_; ///< 起始计数
+    uint64_t stop_ticks_;  ///< 结束计数
+};
+
+/**
+ * @class SampleStats
+ * @brief 计时样本统计累加器
+ *
+ * 保存全部样本，查询分位数时排序一次并缓存排序结果。
+ * 不是线程安全的；多线程采样时每个线程一个累加器，最后merge。
+ */
+class SampleStats {
+public:
+    /**
+     * @brief 加入一个样本
+     */
+    void add(double sample);
+
+    /**
+     * @brief 合并另一个累加器的样本
+     */
+    void merge(const SampleStats& other);
+
+    /**
+     * @brief 清空样本
+     */
+    void clear();
+
+    /**
+     * @brief 样本数
+     */
+    size_t count() const;
+
+    /**
+     * @brief 最小值，无样本时返回0
+     */
+    double min() const;
+
+    /**
+     * @brief 最大值，无样本时返回0
+     */
+    double max() const;
+
+    /**
+     * @brief 算术平均值，无样本时返回0
+     */
+    double mean() const;
+
+    /**
+     * @brief 中位数，无样本时返回0
+     */
+    double median() const;
+
+    /**
+     * @brief 分位数（最近秩法）
+     * @param q 分位，取值[0, 1]，例如0.99
+     * @return 分位数，无样本时返回0
+     */
+    double percentile(double q) const;
+
+    /**
+     * @brief 样本标准差（除以n-1），少于2个样本时返回0
+     */
+    double stddev() const;
+
+private:
+    mutable std::vector<double> samples_; ///< 全部样本
+    mutable bool sorted_ = true;          ///< samples_是否已排序
+
+    /**
+     * @brief 按需排序样本
+     */
+    const std::vector<double>& sorted() const;
+};
+
+} // namespace yus
+
+#endif // YUS_TIMING_H
@@ -0,0 +1,141 @@
+/**
+ * @file trace.h
+ * @brief YuS流密码评估时间线记录头文件
+ * @author Aurorp1g
+ * @date 2025-11-07
+ *
+ * 定义记录同态评估时间线的TraceRecorder，输出Chrome trace-event JSON，
+ * 可直接在chrome://tracing或Perfetto（ui.perfetto.dev）中打开，
+ * 按工作线程查看每轮、每个S盒、每个线性层分块和每次重线性化的时间跨度。
+ */
+
+#ifndef YUS_TRACE_H
+#define YUS_TRACE_H
+
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace yus {
+
+/**
+ * @struct TraceEvent
+ * @brief 一个完整的时间跨度（Chrome trace中ph为"X"的事件）
+ */
+struct TraceEvent {
+    std::string name;           ///< 事件名，例如"round"、"sbox"、"relinearize"
+    std::string category;       ///< 分类，例如"round"、"sbox_layer"、"linear_layer"、"fhe"
+    uint32_t tid;               ///< 线程编号：线程池的工作者编号，0为调用线程
+    uint64_t start_ns;          ///< 相对记录器创建时刻的开始时间（纳秒）
+    uint64_t duration_ns;       ///< 持续时间（纳秒）
+    int64_t index;              ///< 轮号、S盒编号或分块编号，-1表示无
+    int64_t level;              ///< 密文所在的模数链层级，-1表示无
+};
+
+/**
+ * @class TraceRecorder
+ * @brief 线程安全的时间线记录器
+ *
+ * 一次评估的事件数在数千以内，各工作者在锁内追加事件即可；
+ * 未设置记录器时评估代码只做一次空指针判断。
+ */
+class TraceRecorder {
+public:
+    /**
+     * @brief 构造函数，以当前时刻为时间原点
+     */
+    TraceRecorder();
+
+    /**
+     * @brief 记录一个时间跨度
+     * @param name 事件名
+     * @param category 分类
+     * @param tid 线程编号
+     * @param start_ns steady_ns()读取的开始时间
+     * @param end_ns steady_ns()读取的结束时间
+     * @param index 轮号、S盒编号或分块编号，-1表示无
+     * @param level 密文层级，-1表示无
+     */
+    void record(const char* name, const char* category, uint32_t tid, uint64_t start_ns, uint64_t end_ns,
+                int64_t index = -1, int64_t level = -1);
+
+    /**
+     * @brief 已记录的事件副本
+     */
+    std::vector<TraceEvent> events() const;
+
+    /**
+     * @brief 已记录的事件数
+     */
+    size_t size() const;
+
+    /**
+     * @brief 清空事件，时间原点不变
+     */
+    void clear();
+
+    /**
+     * @brief 输出Chrome trace-event JSON
+     * @param out 输出流
+     *
+     * 时间以微秒为单位；每个出现过的线程编号附带一条thread_name元数据事件，
+     * 0号显示为"caller"，其余显示为"worker k"。index和level写入args。
+     */
+    void write_json(std::ostream& out) const;
+
+    /**
+     * @brief 把Chrome trace-event JSON写入文件
+     * @param path 文件路径
+     * @throws std::runtime_error 当文件无法写入时抛出异常
+     */
+    void save(const std::string& path) const;
+
+private:
+    uint64_t origin_ns_;                ///< 时间原点
+    mutable std::mutex mutex_;          ///< 保护events_
+    std::vector<TraceEvent> events_;    ///< 已记录的事件
+};
+
+/**
+ * @class TraceSpan
+ * @brief 作用域时间跨度：析构时向记录器追加一个事件
+ *
+ * recorder为空时不读取时钟，也不分配内存。
+ */
+class TraceSpan {
+public:
+    /**
+     * @brief 构造函数，记录开始时间
+     * @param recorder 记录器，可为空
+     * @param name 事件名（须为静态字符串）
+     * @param category 分类（须为静态字符串）
+     * @param tid 线程编号
+     * @param index 轮号、S盒编号或分块编号，-1表示无
+     * @param level 密文层级，-1表示无
+     */
+    TraceSpan(TraceRecorder* recorder, const char* name, const char* category, uint32_t tid,
+              int64_t index = -1, int64_t level = -1);
+
+    /**
+     * @brief 析构函数，记录结束时间并追加事件
+     */
+    ~TraceSpan();
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    TraceRecorder* recorder_;   ///< 记录器
+    const char* name_;          ///< 事件名
+    const char* category_;      ///< 分类
+    uint32_t tid_;              ///< 线程编号
+    int64_t index_;             ///< 编号
+    int64_t level_;             ///< 密文层级
+    uint64_t start_ns_;         ///< 开始时间
+};
+
+} // namespace yus
+
+#endif // YUS_TRACE_H
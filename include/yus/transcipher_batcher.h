@@ -0,0 +1,205 @@
+/**
+ * @file transcipher_batcher.h
+ * @brief YuS流密码转密请求合批器头文件
+ * @author Aurorp1g
+ * @date 2025-11-07
+ *
+ * 定义转密服务的请求队列。单个客户端请求通常只有几个块，而一次同态评估覆盖slot_count()个块；
+ * 合批器把同一加密密钥下的请求（可跨随机数）按槽顺序拼接为一批，
+ * 批满或最早的请求到达截止时间时评估，并记录每个请求的排队和服务时间。
+ */
+
+#ifndef YUS_TRANSCIPHER_BATCHER_H
+#define YUS_TRANSCIPHER_BATCHER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "fhe_wrapper.h"
+
+namespace yus {
+
+/**
+ * @struct TranscipherRequest
+ * @brief 转密请求
+ *
+ * 对称密文按块依次排列，每块36-trunc_m个F_p字，末块不足时按0补齐。
+ */
+struct TranscipherRequest {
+    std::string key_id;               ///< 加密密钥标识
+    std::vector<uint8_t> nonce;       ///< 客户端加密所用的随机数
+    uint32_t first_block = 0;         ///< sym_ct[0]所在块的索引
+    std::vector<uint64_t> sym_ct;     ///< 对称密文
+};
+
+/**
+ * @struct TranscipherReply
+ * @brief 转密应答
+ *
+ * 同一批的请求共享整批的密文，本请求的第b块位于各密文的槽first_slot+b。
+ */
+struct TranscipherReply {
+    std::vector<Ciphertext> cipher_data;  ///< 整批的36-trunc_m个行式打包密文
+    size_t first_slot = 0;                ///< 本请求第一个块所在的槽
+    size_t blocks = 0;                    ///< 本请求的块数
+    size_t batch_blocks = 0;              ///< 同批的有效块数
+    double queue_ms = 0;                  ///< 从入队到开始评估的时间（毫秒）
+    double service_ms = 0;                ///< 整批评估和减法的时间（毫秒）
+    double latency_ms = 0;                ///< 从入队到应答的时间（毫秒）
+};
+
+/**
+ * @class TranscipherBatcher
+ * @brief 转密请求合批器类
+ *
+ * 后台线程按加密密钥维护请求队列。队列中的块数达到slot_count()时立即评估满批，
+ * 否则在最早的请求等待满deadline后评估不满的一批。
+ * 所有队列的待处理块数超过上限时拒绝新请求（背压），由调用方决定重试或告知客户端。
+ * 所有接口线程安全；FHE实例的评估只在后台线程上进行。
+ */
+class TranscipherBatcher {
+public:
+    /**
+     * @struct Options
+     * @brief 合批选项
+     */
+    struct Options {
+        std::chrono::milliseconds deadline{50};   ///< 请求最长排队时间
+        size_t max_queued_blocks = 0;             ///< 待处理块数上限，0表示4·slot_count()
+        std::vector<uint32_t> mod_switch_schedule; ///< 评估使用的模数切换计划
+    };
+
+    /**
+     * @struct Stats
+     * @brief 合批统计信息
+     */
+    struct Stats {
+        uint64_t requests = 0;        ///< 已应答的请求数
+        uint64_t rejected = 0;        ///< 因背压拒绝的请求数
+        uint64_t failed = 0;          ///< 评估失败的请求数
+        uint64_t batches = 0;         ///< 评估的批次数
+        uint64_t full_batches = 0;    ///< 填满所有槽的批次数
+        uint64_t filled_slots = 0;    ///< 各批有效块数之和
+        uint64_t total_slots = 0;     ///< 各批槽数之和
+        double latency_sum_ms = 0;    ///< 请求延迟之和（毫秒）
+        double latency_max_ms = 0;    ///< 最大请求延迟（毫秒）
+        size_t queued_blocks = 0;     ///< 当前待处理块数
+    };
+
+    /**
+     * @brief 构造函数，启动后台线程
+     * @param fhe 同态加密封装实例，生命周期须长于本对象
+     * @param level 安全级别
+     * @param trunc_m 截断位数
+     * @param options 合批选项
+     * @throws std::invalid_argument 当截断位数不正确时抛出异常
+     */
+    TranscipherBatcher(FHEWrapper& fhe, SecurityLevel level, uint32_t trunc_m, Options options);
+
+    /**
+     * @brief 析构函数，评估剩余请求后停止后台线程
+     */
+    ~TranscipherBatcher();
+
+    TranscipherBatcher(const TranscipherBatcher&) = delete;
+    TranscipherBatcher& operator=(const TranscipherBatcher&) = delete;
+
+    /**
+     * @brief 注册加密密钥
+     * @param key_id 加密密钥标识
+     * @param cipher_key 加密的主密钥（36个密文）
+     * @param key_products 24个加密密钥乘积，可为空
+     * @throws std::invalid_argument 当密钥或密钥乘积大小不正确时抛出异常
+     *
+     * 替换同一标识的旧密钥，已入队的请求在评估时使用新密钥。
+     */
+    void add_key(const std::string& key_id, std::vector<Ciphertext> cipher_key,
+                 std::vector<Ciphertext> key_products = {});
+
+    /**
+     * @brief 提交转密请求
+     * @param request 转密请求
+     * @param reply 输出应答的future；评估失败时future抛出评估异常
+     * @return 入队返回true；待处理块数超过上限时返回false
+     * @throws std::invalid_argument 当密钥未注册、数据为空、块数超过slot_count()或合批器已停止时抛出异常
+     */
+    bool submit(TranscipherRequest request, std::future<TranscipherReply>& reply);
+
+    /**
+     * @brief 评估剩余请求并停止后台线程，之后的提交抛出异常
+     */
+    void stop();
+
+    /**
+     * @brief 每块的数据字数（36-trunc_m）
+     */
+    size_t words_per_block() const;
+
+    /**
+     * @brief 获取统计信息
+     */
+    Stats stats() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @struct Pending
+     * @brief 排队中的请求
+     */
+    struct Pending {
+        TranscipherRequest request;              ///< 请求
+        size_t blocks;                           ///< 块数
+        Clock::time_point enqueued;              ///< 入队时间
+        std::promise<TranscipherReply> promise;  ///< 应答
+    };
+
+    /**
+     * @struct KeyQueue
+     * @brief 单个加密密钥的密钥和请求队列
+     */
+    struct KeyQueue {
+        std::vector<Ciphertext> cipher_key;      ///< 加密的主密钥
+        std::vector<Ciphertext> key_products;    ///< 加密密钥乘积
+        std::deque<Pending> pending;             ///< 排队中的请求
+        size_t blocks = 0;                       ///< 排队中的块数
+    };
+
+    FHEWrapper& fhe_;                            ///< 同态加密封装实例
+    SecurityLevel level_;                        ///< 安全级别
+    uint32_t trunc_m_;                           ///< 截断位数
+    Options options_;                            ///< 合批选项
+    size_t slots_;                               ///< 每批的槽数
+    std::map<std::string, KeyQueue> queues_;     ///< 各加密密钥的队列
+    Stats stats_;                                ///< 统计信息
+    bool stopping_;                              ///< 停止标志
+    mutable std::mutex mutex_;                   ///< 保护以上状态
+    std::condition_variable cv_;                 ///< 唤醒后台线程
+    std::thread worker_;                         ///< 后台线程
+
+    /**
+     * @brief 后台线程主循环
+     */
+    void run();
+
+    /**
+     * @brief 评估一批请求并应答
+     * @param batch 本批请求
+     * @param cipher_key 加密的主密钥
+     * @param key_products 加密密钥乘积
+     */
+    void evaluate_batch(std::vector<Pending>& batch, const std::vector<Ciphertext>& cipher_key,
+                        const std::vector<Ciphertext>& key_products);
+};
+
+} // namespace yus
+
+#endif // YUS_TRANSCIPHER_BATCHER_H
@@ -0,0 +1,132 @@
+/**
+ * @file transcipherer.h
+ * @brief YuS流密码转密接口头文件
+ * @author Aurorp1g
+ * @date 2025-11-07
+ *
+ * 定义服务端的端到端转密接口：输入客户端的YuS对称密文，输出数据的FHE密文。
+ * 服务端持有加密主密钥E(k)，按随机数和块范围同态评估密钥流，
+ * 再从按相同槽布局编码的对称密文中减去密钥流。
+ */
+
+#ifndef YUS_TRANSCIPHERER_H
+#define YUS_TRANSCIPHERER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "fhe_wrapper.h"
+#include "keystream_store.h"
+
+namespace yus {
+
+/**
+ * @struct TranscipherResult
+ * @brief 转密结果
+ *
+ * 每批最多slot_count()个块，产生36-trunc_m个行式打包密文：
+ * 第b批的第i个密文位于cipher_data[b·(36-trunc_m)+i]，其槽j为块first_block+b·slot_count()+j的第i个数据字。
+ */
+struct TranscipherResult {
+    std::vector<Ciphertext> cipher_data;  ///< 数据的FHE密文，按批次依次排列
+    size_t words = 0;                     ///< 转密的数据字数
+    size_t blocks = 0;                    ///< 覆盖的块数，末块不足时补零
+    size_t batches = 0;                   ///< 批次数
+    size_t keystream_hits = 0;            ///< 从密钥流缓存取得的批次数
+    double keystream_ms = 0;              ///< 同态评估密钥流的时间（毫秒）
+    double strip_ms = 0;                  ///< 减去密钥流的时间（毫秒）
+    double total_ms = 0;                  ///< 总时间（毫秒）
+    double throughput_kibps = 0;          ///< 客户端数据吞吐量（KiB/s）
+};
+
+/**
+ * @class Transcipherer
+ * @brief YuS转密类
+ *
+ * 绑定一个FHE实例和一个客户端的加密主密钥。客户端按YuSCipher的密钥流加密，
+ * 每块36-trunc_m个F_p字：c = m + z mod p，按块依次排列。
+ * 设置密钥流缓存后，已离线预计算的批次只需一次减法。
+ * 吞吐量按throughput_kibps（utils.h）计算。
+ */
+class Transcipherer {
+public:
+    /**
+     * @brief 构造函数
+     * @param fhe 同态加密封装实例，生命周期须长于本对象
+     * @param cipher_key 加密的主密钥（36个密文）
+     * @param level 安全级别
+     * @param trunc_m 截断位数
+     * @throws std::invalid_argument 当加密密钥大小或截断位数不正确时抛出异常
+     */
+    Transcipherer(FHEWrapper& fhe, std::vector<Ciphertext> cipher_key,
+                  SecurityLevel level, uint32_t trunc_m = 12);
+
+    /**
+     * @brief 设置加密密钥乘积
+     * @param key_products 24个加密密钥乘积（precompute_key_products或encrypt_key_products的输出），为空时不使用
+     * @throws std::invalid_argument 当密钥乘积大小不正确时抛出异常
+     */
+    void set_key_products(std::vector<Ciphertext> key_products);
+
+    /**
+     * @brief 设置密钥流缓存
+     * @param store 密钥流缓存，为nullptr时每批都在线评估；生命周期须长于本对象
+     * @param key_id 该加密密钥在缓存中的标识
+     *
+     * 转密只查询缓存，不插入：同一随机数和块范围的密钥流只用于一次转密。
+     */
+    void set_keystream_store(KeystreamStore* store, const std::string& key_id);
+
+    /**
+     * @brief 设置在线评估使用的模数切换计划
+     * @param schedule 见YuSEvalParams::mod_switch_schedule
+     */
+    void set_mod_switch_schedule(std::vector<uint32_t> schedule);
+
+    /**
+     * @brief 转密
+     * @param nonce 客户端加密所用的随机数
+     * @param first_block sym_ct[0]所在块的索引
+     * @param sym_ct 对称密文，n个F_p字，第j块第i个字位于sym_ct[j·(36-trunc_m)+i]
+     * @param n 数据字数，末块不足36-trunc_m个字时按0补齐
+     * @return 数据的FHE密文和计时
+     * @throws std::invalid_argument 当数据为空或块索引溢出时抛出异常
+     *
+     * 数据按slot_count()块分批；每批评估（或从缓存取得）行式打包的加密密钥流，
+     * 再以FHEWrapper::strip_keystream计算E(m) = c - E(z)。
+     */
+    TranscipherResult transcipher(const std::vector<uint8_t>& nonce, uint32_t first_block,
+                                  const uint64_t* sym_ct, size_t n);
+
+    /**
+     * @brief 每块的数据字数（36-trunc_m）
+     */
+    size_t words_per_block() const;
+
+    /**
+     * @brief 一批可转密的数据字数（slot_count()·(36-trunc_m)）
+     */
+    size_t words_per_batch() const;
+
+    /**
+     * @brief 计算数据字对应的客户端数据字节数
+     * @param words 数据字数
+     * @return 字节数，按field_word_bytes（utils.h）计数
+     */
+    double data_bytes(size_t words) const;
+
+private:
+    FHEWrapper& fhe_;                              ///< 同态加密封装实例
+    std::vector<Ciphertext> cipher_key_;           ///< 加密的主密钥
+    std::vector<Ciphertext> key_products_;         ///< 加密密钥乘积，可为空
+    SecurityLevel level_;                          ///< 安全级别
+    uint32_t trunc_m_;                             ///< 截断位数
+    std::vector<uint32_t> mod_switch_schedule_;    ///< 模数切换计划
+    KeystreamStore* store_;                        ///< 密钥流缓存，可为nullptr
+    std::string key_id_;                           ///< 缓存中的密钥标识
+};
+
+} // namespace yus
+
+#endif // YUS_TRANSCIPHERER_H
@@ -36,6 +36,18 @@ bool is_p_2mod3(const mpz_class& p);
  */
 mpz_class generate_prime(uint32_t bits = 17);
 
+/**
+ * @brief 生成支持批处理的明文素数
+ * @param bits 素数位数
+ * @param poly_modulus_degree 环维数N（2的幂）
+ * @return 满足 p ≡ 2 mod 3 且 p ≡ 1 mod 2N 的bits位素数
+ * @throws std::invalid_argument 当bits位内不存在满足条件的素数时抛出异常
+ * 
+ * 2的幂分圆环上只有 p ≡ 1 mod 2N 时每个槽才是F_p，BFV批处理编码也要求该条件。
+ * 例如65537满足N不超过32768的所有情形。
+ */
+mpz_class generate_batching_prime(uint32_t bits, uint32_t poly_modulus_degree);
+
 /**
  * @brief 将大整数转换为字节数组
  * @param num 待转换的大整数
@@ -67,47 +79,57 @@ mpz_class bytes_to_mpz(const std::vector<uint8_t>& bytes);
 mpz_class mod(const mpz_class& a, const mpz_class& p);
 
 /**
- * @class Timer
- * @brief 性能计时器类
+ * @brief 64位模乘
+ * @param a 乘数，须小于p
+ * @param b 乘数，须小于p
+ * @param p 模数
+ * @return a * b mod p
+ * 
+ * 使用128位中间结果，适用于槽向量上的逐元素运算，避免mpz_class的堆分配。
+ */
+uint64_t mul_mod(uint64_t a, uint64_t b, uint64_t p);
+
+/**
+ * @brief F_p字对应的数据字节数
+ * @param p 素数模数
+ * @param words 字数
+ * @return 字节数
+ * 
+ * 按技术文档第7节计数：每个字计⌈log2 p⌉比特。密钥流、转密数据的吞吐量和CPB统一按此换算。
+ */
+double field_word_bytes(const mpz_class& p, double words);
+
+/**
+ * @brief 按field_word_bytes计数的吞吐量
+ * @param p 素数模数
+ * @param words 在elapsed_ms内生成或处理的字数
+ * @param elapsed_ms 耗时（毫秒）
+ * @return 吞吐量（KiB/s），耗时不为正时返回0
+ */
+double throughput_kibps(const mpz_class& p, double words, double elapsed_ms);
+
+/**
+ * @brief 获取进程当前的常驻内存
+ * @return 字节数，平台不支持时返回0
+ */
+uint64_t current_rss_bytes();
+
+/**
+ * @brief 获取进程常驻内存的峰值
+ * @return 字节数，平台不支持时返回0
+ * 
+ * Linux读取/proc/self/status的VmHWM，可由reset_peak_rss()重置；
+ * 其他平台为进程启动以来的峰值。
+ */
+uint64_t peak_rss_bytes();
+
+/**
+ * @brief 把常驻内存峰值重置为当前值
+ * @return 重置成功返回true；平台不支持时返回false，峰值仍从进程启动算起
  * 
- * 提供高精度的性能计时功能，用于测量算法执行时间。
- * 使用C++高精度时钟。
+ * 同一进程依次运行多组基准配置时，每组开始前重置，峰值只反映该组。
  */
-class Timer {
-public:
-    /**
-     * @brief 构造函数
-     * 
-     * 初始化计时器，设置起始和结束时间戳为0。
-     */
-    Timer();
-
-    /**
-     * @brief 开始计时
-     * 
-     * 记录当前时间作为起始时间戳，使用高精度时钟。
-     */
-    void start();
-
-    /**
-     * @brief 停止计时
-     * 
-     * 记录当前时间作为结束时间戳，使用高精度时钟。
-     */
-    void stop();
-
-    /**
-     * @brief 获取经过的时间（毫秒）
-     * @return 经过的时间（毫秒）
-     * 
-     * 计算从开始计时到停止计时的时间间隔，转换为毫秒单位。
-     */
-    double elapsed_ms() const;
-
-private:
-    uint64_t start_ticks_; ///< 起始时间戳（微秒）
-    uint64_t stop_ticks_;  ///< 结束时间戳（微秒）
-};
+bool reset_peak_rss();
 
 } // namespace yus
 
@@ -0,0 +1,224 @@
+/**
+ * @file alloc_tracker.cpp
+ * @brief YuS流密码堆分配统计实现
+ * @author Aurorp1g
+ * @date 2025-11-07
+ *
+ * 定义YUS_ALLOC_TRACKING时替换全局operator new/delete（含数组、nothrow和对齐版本），
+ * 并在静态初始化时安装GMP的分配函数。替换函数直接调用malloc/free，
+ * 与GMP默认的分配函数兼容，安装之前分配的GMP内存可以由新函数释放。
+ */
+
+#include "yus/alloc_tracker.h"
+
+#if defined(YUS_ALLOC_TRACKING)
+#include <gmp.h>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#endif
+
+namespace yus {
+
+#if defined(YUS_ALLOC_TRACKING)
+
+namespace {
+
+std::atomic<uint64_t> g_allocations{0};
+std::atomic<uint64_t> g_bytes{0};
+std::atomic<uint64_t> g_frees{0};
+
+/// 线程计数为平凡类型，线程启动时即可使用，不依赖构造顺序
+thread_local AllocCounts t_counts;
+
+void count_allocation(size_t bytes) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    ++t_counts.allocations;
+    t_counts.bytes += bytes;
+}
+
+void count_free() {
+    g_frees.fetch_add(1, std::memory_order_relaxed);
+    ++t_counts.frees;
+}
+
+void* checked_malloc(size_t size) {
+    count_allocation(size);
+    return std::malloc(size ? size : 1);
+}
+
+void* checked_aligned_malloc(size_t size, size_t alignment) {
+    count_allocation(size);
+#if defined(_WIN32)
+    return _aligned_malloc(size ? size : 1, alignment);
+#else
+    void* ptr = nullptr;
+    if (alignment < sizeof(void*)) {
+        alignment = sizeof(void*);
+    }
+    return posix_memalign(&ptr, alignment, size ? size : 1) == 0 ? ptr : nullptr;
+#endif
+}
+
+void tracked_free(void* ptr) {
+    if (ptr) {
+        count_free();
+        std::free(ptr);
+    }
+}
+
+void tracked_aligned_free(void* ptr) {
+    if (ptr) {
+        count_free();
+#if defined(_WIN32)
+        _aligned_free(ptr);
+#else
+        std::free(ptr);
+#endif
+    }
+}
+
+void* gmp_alloc(size_t size) {
+    void* ptr = checked_malloc(size);
+    if (!ptr) {
+        std::abort();
+    }
+    return ptr;
+}
+
+void* gmp_realloc(void* ptr, size_t, size_t new_size) {
+    count_allocation(new_size);
+    void* result = std::realloc(ptr, new_size);
+    if (!result) {
+        std::abort();
+    }
+    return result;
+}
+
+void gmp_free(void* ptr, size_t) {
+    tracked_free(ptr);
+}
+
+/**
+ * @brief 静态初始化时安装GMP分配函数
+ */
+struct GmpHooks {
+    GmpHooks() { mp_set_memory_functions(gmp_alloc, gmp_realloc, gmp_free); }
+} g_gmp_hooks;
+
+} // namespace
+
+#endif
+
+/**
+ * @brief 分配统计是否已编译进库
+ */
+bool alloc_tracking_enabled() {
+#if defined(YUS_ALLOC_TRACKING)
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief 所有线程的分配计数，未编译时为0
+ */
+AllocCounts alloc_counts() {
+#if defined(YUS_ALLOC_TRACKING)
+    return AllocCounts{g_allocations.load(std::memory_order_relaxed), g_bytes.load(std::memory_order_relaxed),
+                       g_frees.load(std::memory_order_relaxed)};
+#else
+    return AllocCounts{};
+#endif
+}
+
+/**
+ * @brief 当前线程的分配计数，未编译时为0
+ */
+AllocCounts thread_alloc_counts() {
+#if defined(YUS_ALLOC_TRACKING)
+    return t_counts;
+#else
+    return AllocCounts{};
+#endif
+}
+
+} // namespace yus
+
+#if defined(YUS_ALLOC_TRACKING)
+
+void* operator new(std::size_t size) {
+    void* ptr = yus::checked_malloc(size);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* operator new[](std::size_t size) {
+    return ::operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return yus::checked_malloc(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return yus::checked_malloc(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    void* ptr = yus::checked_aligned_malloc(size, static_cast<std::size_t>(alignment));
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return ::operator new(size, alignment);
+}
+
+void operator delete(void* ptr) noexcept {
+    yus::tracked_free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    yus::tracked_free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    yus::tracked_free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    yus::tracked_free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+    yus::tracked_free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+    yus::tracked_free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+    yus::tracked_aligned_free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept {
+    yus::tracked_aligned_free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept {
+    yus::tracked_aligned_free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept {
+    yus::tracked_aligned_free(ptr);
+}
+
+#endif
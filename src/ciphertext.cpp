@@ -0,0 +1,279 @@
+/**
+ * @file ciphertext.cpp
+ * @brief YuS流密码类型化密文句柄与密文对象池实现
+ * @author Aurorp1g
+ * @date 2025-11-07
+ *
+ * 实现密文句柄的引用计数和密文对象的分配、回收与预留。
+ */
+
+#include "yus/ciphertext.h"
+#include <atomic>
+#include <stdexcept>
+#include <utility>
+
+namespace yus {
+
+/**
+ * @struct Ciphertext::Node
+ * @brief 池中的密文对象
+ *
+ * 一个池只保存一种方案的密文，另一后端的成员保持空状态。
+ * SEAL密文可默认构造；HElib密文必须绑定公钥构造，因此按需创建并随对象一起复用。
+ */
+struct Ciphertext::Node {
+    std::atomic<uint32_t> refs{0};              ///< 引用计数
+    FHE_SCHEME scheme;                          ///< 密文所属的方案
+    uint64_t generation;                        ///< 创建时的公钥代数
+    std::shared_ptr<CiphertextPool> pool;       ///< 存活期间持有所属池，空闲时为空
+    seal::Ciphertext seal_ct;                   ///< SEAL密文
+    std::unique_ptr<helib::Ctxt> helib_ct;      ///< HElib密文
+
+    Node(FHE_SCHEME s, uint64_t gen, const seal::MemoryPoolHandle& memory_pool)
+        : scheme(s), generation(gen), seal_ct(memory_pool) {}
+};
+
+/**
+ * @brief 复制句柄，增加引用计数
+ */
+Ciphertext::Ciphertext(const Ciphertext& other) noexcept : node_(other.node_) {
+    if (node_) {
+        node_->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief 移动句柄，引用计数不变
+ */
+Ciphertext::Ciphertext(Ciphertext&& other) noexcept : node_(other.node_) {
+    other.node_ = nullptr;
+}
+
+/**
+ * @brief 复制赋值
+ */
+Ciphertext& Ciphertext::operator=(const Ciphertext& other) noexcept {
+    if (node_ != other.node_) {
+        Ciphertext copy(other);
+        std::swap(node_, copy.node_);
+    }
+    return *this;
+}
+
+/**
+ * @brief 移动赋值
+ */
+Ciphertext& Ciphertext::operator=(Ciphertext&& other) noexcept {
+    if (this != &other) {
+        reset();
+        node_ = other.node_;
+        other.node_ = nullptr;
+    }
+    return *this;
+}
+
+/**
+ * @brief 析构函数
+ */
+Ciphertext::~Ciphertext() {
+    reset();
+}
+
+/**
+ * @brief 释放引用并置空句柄
+ *
+ * 最后一个引用释放时把对象交还所属池。先取出池的共享引用再回收，
+ * 即使这是池的最后一个引用，池也在回收完成后才析构。
+ */
+void Ciphertext::reset() noexcept {
+    if (!node_) {
+        return;
+    }
+    Node* node = node_;
+    node_ = nullptr;
+    if (node->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        std::shared_ptr<CiphertextPool> pool = std::move(node->pool);
+        pool->recycle(node);
+    }
+}
+
+/**
+ * @brief 是否为唯一引用
+ */
+bool Ciphertext::unique() const noexcept {
+    return node_ && node_->refs.load(std::memory_order_acquire) == 1;
+}
+
+/**
+ * @brief 获取密文所属的方案
+ * @throws std::runtime_error 当句柄为空时抛出异常
+ */
+FHE_SCHEME Ciphertext::scheme() const {
+    if (!node_) {
+        throw std::runtime_error("Ciphertext handle is empty");
+    }
+    return node_->scheme;
+}
+
+/**
+ * @brief 访问SEAL密文
+ * @throws std::runtime_error 当句柄为空或不是BFV密文时抛出异常
+ */
+seal::Ciphertext& Ciphertext::seal() {
+    if (scheme() != FHE_SCHEME::BFV) {
+        throw std::runtime_error("Ciphertext is not a SEAL (BFV) ciphertext");
+    }
+    return node_->seal_ct;
+}
+
+const seal::Ciphertext& Ciphertext::seal() const {
+    if (scheme() != FHE_SCHEME::BFV) {
+        throw std::runtime_error("Ciphertext is not a SEAL (BFV) ciphertext");
+    }
+    return node_->seal_ct;
+}
+
+/**
+ * @brief 访问HElib密文
+ * @throws std::runtime_error 当句柄为空或不是BGV密文时抛出异常
+ */
+helib::Ctxt& Ciphertext::helib() {
+    if (scheme() != FHE_SCHEME::BGV) {
+        throw std::runtime_error("Ciphertext is not a HElib (BGV) ciphertext");
+    }
+    return *node_->helib_ct;
+}
+
+const helib::Ctxt& Ciphertext::helib() const {
+    if (scheme() != FHE_SCHEME::BGV) {
+        throw std::runtime_error("Ciphertext is not a HElib (BGV) ciphertext");
+    }
+    return *node_->helib_ct;
+}
+
+/**
+ * @brief 创建对象池
+ * @param scheme 池中密文的方案
+ * @param seal_pools 各工作者的SEAL内存池
+ * @return 对象池的共享引用
+ */
+std::shared_ptr<CiphertextPool> CiphertextPool::create(FHE_SCHEME scheme,
+                                                       std::vector<seal::MemoryPoolHandle> seal_pools) {
+    return std::shared_ptr<CiphertextPool>(new CiphertextPool(scheme, std::move(seal_pools)));
+}
+
+/**
+ * @brief CiphertextPool构造函数
+ */
+CiphertextPool::CiphertextPool(FHE_SCHEME scheme, std::vector<seal::MemoryPoolHandle> seal_pools)
+    : scheme_(scheme), seal_pools_(std::move(seal_pools)), helib_pubkey_(nullptr),
+      generation_(0), acquires_(0), allocations_(0) {}
+
+/**
+ * @brief CiphertextPool析构函数
+ *
+ * 存活的密文持有池的引用，析构时池中只剩空闲对象。
+ */
+CiphertextPool::~CiphertextPool() {
+    for (Ciphertext::Node* node : idle_) {
+        delete node;
+    }
+}
+
+/**
+ * @brief 设置新建HElib密文所用的公钥
+ * @param pubkey HElib公钥
+ */
+void CiphertextPool::set_helib_pubkey(const helib::PubKey* pubkey) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    helib_pubkey_ = pubkey;
+    ++generation_;
+    for (Ciphertext::Node* node : idle_) {
+        delete node;
+    }
+    idle_.clear();
+}
+
+/**
+ * @brief 新建密文对象（调用方持有锁）
+ * @param worker 工作者编号
+ * @return 新对象
+ * @throws std::runtime_error 当BGV池未设置公钥时抛出异常
+ */
+Ciphertext::Node* CiphertextPool::make_node(size_t worker) {
+    if (scheme_ == FHE_SCHEME::BGV && !helib_pubkey_) {
+        throw std::runtime_error("Ciphertext pool has no HElib public key");
+    }
+    const seal::MemoryPoolHandle& memory_pool =
+        seal_pools_.empty() ? seal::MemoryManager::GetPool() : seal_pools_[worker % seal_pools_.size()];
+    auto node = std::make_unique<Ciphertext::Node>(scheme_, generation_, memory_pool);
+    if (scheme_ == FHE_SCHEME::BGV) {
+        node->helib_ct = std::make_unique<helib::Ctxt>(*helib_pubkey_);
+    }
+    ++allocations_;
+    return node.release();
+}
+
+/**
+ * @brief 分配密文
+ * @param worker 工作者编号
+ * @return 唯一引用的密文句柄
+ */
+Ciphertext CiphertextPool::acquire(size_t worker) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    Ciphertext::Node* node;
+    if (idle_.empty()) {
+        node = make_node(worker);
+    } else {
+        node = idle_.back();
+        idle_.pop_back();
+    }
+    ++acquires_;
+    lock.unlock();
+
+    node->pool = shared_from_this();
+    node->refs.store(1, std::memory_order_relaxed);
+    return Ciphertext(node);
+}
+
+/**
+ * @brief 预留空闲对象
+ * @param count 空闲对象的目标数量
+ */
+void CiphertextPool::reserve(size_t count) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    idle_.reserve(count);
+    while (idle_.size() < count) {
+        idle_.push_back(make_node(idle_.size()));
+    }
+}
+
+/**
+ * @brief 获取统计信息
+ * @return 分配次数、新建次数和空闲对象数
+ */
+CiphertextPool::Stats CiphertextPool::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return Stats{acquires_, allocations_, idle_.size()};
+}
+
+/**
+ * @brief 回收引用计数归零的对象
+ * @param node 待回收的对象
+ *
+ * 旧公钥下创建的HElib密文不能与新密文互相赋值，直接释放。
+ */
+void CiphertextPool::recycle(Ciphertext::Node* node) noexcept {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (node->generation != generation_) {
+        delete node;
+        return;
+    }
+    try {
+        idle_.push_back(node);
+    } catch (...) {
+        delete node;
+    }
+}
+
+} // namespace yus
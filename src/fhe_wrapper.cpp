@@ -10,41 +10,538 @@
 
 #include "yus/fhe_wrapper.h"
 #include "yus/utils.h"
+#include "yus/timing.h"
+#include "yus/instrument.h"
+#include "yus/alloc_tracker.h"
 #include <helib/helib.h>
 #include <seal/seal.h>
 #include <stdexcept>
 #include <chrono>
 #include <cmath>
-#include <omp.h>
+#include <algorithm>
+#include <string>
+#include <limits>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <functional>
+#include <cstring>
 
 namespace yus {
 
+namespace {
+
 /**
- * @brief FHEWrapper构造函数
- * @param scheme 同态加密方案（BGV或BFV）
- * @param params FHE参数配置
- * @throws std::invalid_argument 当参数不满足条件时抛出异常
+ * @brief 环维数N在给定安全级别下允许的最大模数位数（含特殊素数）
+ * @param log_n log2(N)
+ * @param security_level 安全级别（80或128位）
+ * @return 最大模数位数
  * 
- * 初始化FHE封装实例，验证安全级别和明文模数条件，并根据方案初始化相应的加密库。
+ * 128位取自同态加密标准的三元私钥表（与SEAL的CoeffModulus::MaxBitCount一致）；
+ * 80位按模数位数与安全级别近似成反比，由128位表乘以1.6得到。
  */
-FHEWrapper::FHEWrapper(FHE_SCHEME scheme, const FHEParams& params)
-    : scheme_(scheme), params_(params) {
-    
-    // 验证安全级别
+int max_coeff_modulus_bits(uint32_t log_n, uint32_t security_level) {
+    static const int bits_128[] = {27, 54, 109, 218, 438, 881};   // N = 1024 .. 32768
+    const int bits = bits_128[log_n - 10];
+    return security_level == 128 ? bits : bits * 8 / 5;
+}
+
+// 噪声模型（比特）：新鲜密文噪声约log2(N)+5；每轮的乘法、重线性化和轮密钥加
+// 约消耗log2(p)+log2(N)+9；每个线性层输出最多18项相加，约5比特
+constexpr uint32_t kFreshNoiseBits = 5;
+constexpr uint32_t kRoundNoiseBits = 9;
+constexpr uint32_t kLinearNoiseBits = 5;
+constexpr uint32_t kMaxPrimeBits = 60;
+// 列式打包的每个线性层（含最终层）做对角明文乘法，约消耗log2(p)+log2(N)比特，
+// 再加36项求和与旋转密钥交换约6比特
+constexpr uint32_t kDiagonalNoiseBits = 6;
+
+// 列式线性层按12个循环对角线分解：d = 4g + b，小步b∈{0..3}，大步g∈{0,1,2}
+constexpr int kColumnBabySteps = 4;
+constexpr int kColumnGiantSteps = 3;
+
+/**
+ * @brief 列式线性层需要的行内左旋步长：小步1..3和大步4、8
+ */
+std::vector<int> column_rotation_steps() {
+    std::vector<int> steps;
+    for (int b = 1; b < kColumnBabySteps; ++b) {
+        steps.push_back(b);
+    }
+    for (int g = 1; g < kColumnGiantSteps; ++g) {
+        steps.push_back(g * kColumnBabySteps);
+    }
+    return steps;
+}
+
+/**
+ * @brief 检查模数切换计划
+ * @param schedule 模数切换计划
+ * @param rounds 轮数
+ * @param capacity 可丢弃的模数个数
+ * @return 计划丢弃的模数总数
+ * @throws std::invalid_argument 当计划阶段数或总数超出范围时抛出异常
+ */
+size_t check_mod_switch_schedule(const std::vector<uint32_t>& schedule, uint32_t rounds, size_t capacity) {
+    if (schedule.size() > rounds + 1) {
+        throw std::invalid_argument("Modulus switching schedule has more stages than rounds");
+    }
+    size_t total_drop = 0;
+    for (uint32_t levels : schedule) {
+        total_drop += levels;
+    }
+    if (total_drop > capacity) {
+        throw std::invalid_argument("Modulus switching schedule exceeds the modulus chain");
+    }
+    return total_drop;
+}
+
+/**
+ * @brief mpz_class转换为uint64_t
+ * 
+ * Windows上unsigned long只有32位，get_ui()会截断33位以上的素数域元素。
+ */
+uint64_t to_u64(const mpz_class& v) {
+    uint64_t out = 0;
+    mpz_export(&out, nullptr, -1, sizeof(out), 0, 0, v.get_mpz_t());
+    return out;
+}
+
+/**
+ * @brief 转换为HElib的明文模数
+ * @param p 素数模数
+ * @return p
+ * @throws std::invalid_argument 当p超出long范围时抛出异常
+ * 
+ * HElib以long保存p，MinGW和MSVC上long只有32位，p=4298506241等33位素数无法表示。
+ */
+long helib_plain_modulus(const mpz_class& p) {
+    if (mpz_sizeinbase(p.get_mpz_t(), 2) > static_cast<size_t>(std::numeric_limits<long>::digits)) {
+        throw std::invalid_argument("Plain modulus " + p.get_str() + " does not fit in HElib's " +
+                                    std::to_string(std::numeric_limits<long>::digits + 1) + "-bit long");
+    }
+    return static_cast<long>(to_u64(p));
+}
+
+/**
+ * @brief uint64_t转换为mpz_class
+ */
+mpz_class from_u64(uint64_t v) {
+    mpz_class out;
+    mpz_import(out.get_mpz_t(), 1, -1, sizeof(v), 0, 0, &v);
+    return out;
+}
+
+/**
+ * @brief 构造BGV槽明文
+ * @param context HElib上下文
+ * @param slots 槽值，不足的槽为0
+ * @return 槽明文
+ * 
+ * 超出long范围的值经NTL::ZZ赋值，避免在long为32位的平台上截断。
+ */
+helib::Ptxt<helib::BGV> make_bgv_ptxt(const helib::Context& context, const std::vector<uint64_t>& slots) {
+    helib::Ptxt<helib::BGV> ptxt(context);
+    for (size_t j = 0; j < slots.size(); ++j) {
+        if (slots[j] <= static_cast<uint64_t>(std::numeric_limits<long>::max())) {
+            ptxt[j] = static_cast<long>(slots[j]);
+        } else {
+            unsigned char bytes[sizeof(uint64_t)];
+            for (size_t k = 0; k < sizeof(uint64_t); ++k) {
+                bytes[k] = static_cast<unsigned char>(slots[j] >> (8 * k));
+            }
+            NTL::ZZX value;
+            NTL::conv(value, NTL::ZZFromBytes(bytes, sizeof(bytes)));
+            ptxt[j] = value;
+        }
+    }
+    return ptxt;
+}
+
+/**
+ * @brief 读取BGV槽值
+ * @param ptxt 解密得到的槽明文
+ * @param j 槽索引
+ * @return 槽值（槽多项式的常数项）
+ */
+uint64_t bgv_slot(const helib::Ptxt<helib::BGV>& ptxt, size_t j) {
+    unsigned char bytes[sizeof(uint64_t)] = {0};
+    NTL::BytesFromZZ(bytes, NTL::coeff(ptxt[j].getData(), 0), sizeof(bytes));
+    uint64_t v = 0;
+    for (size_t k = 0; k < sizeof(uint64_t); ++k) {
+        v |= static_cast<uint64_t>(bytes[k]) << (8 * k);
+    }
+    return v;
+}
+
+// 密钥目录中的文件名
+constexpr const char* kParamsFile = "params.txt";
+constexpr const char* kContextFile = "context";
+constexpr const char* kSecretKeyFile = "secret.key";
+constexpr const char* kPublicKeyFile = "public.key";
+constexpr const char* kRelinKeysFile = "relin.key";
+constexpr const char* kGaloisKeysFile = "galois.key";
+
+/**
+ * @brief 验证FHE参数的安全级别和明文模数条件
+ * @throws std::invalid_argument 当参数不满足条件时抛出异常
+ */
+void check_params(const FHEParams& params) {
     if (params.security_level != 80 && params.security_level != 128) {
         throw std::invalid_argument("Security level must be 80 or 128");
     }
-    // 验证明文模数条件
     if (!is_p_2mod3(params.plain_modulus)) {
         throw std::invalid_argument("Plain modulus must satisfy p ≡ 2 mod 3");
     }
+}
+
+/**
+ * @brief 打开密钥目录中的文件用于读取
+ * @throws std::runtime_error 当文件无法打开时抛出异常
+ */
+std::ifstream open_input(const std::string& dir, const char* name) {
+    const std::filesystem::path path = std::filesystem::path(dir) / name;
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Cannot open " + path.string() + " for reading");
+    }
+    return in;
+}
+
+/**
+ * @brief 打开密钥目录中的文件用于写入
+ * @throws std::runtime_error 当文件无法打开时抛出异常
+ */
+std::ofstream open_output(const std::string& dir, const char* name) {
+    const std::filesystem::path path = std::filesystem::path(dir) / name;
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Cannot open " + path.string() + " for writing");
+    }
+    return out;
+}
+
+/**
+ * @brief 关闭输出文件并检查写入是否成功
+ * @throws std::runtime_error 当写入失败时抛出异常
+ */
+void close_output(std::ofstream& out, const std::string& dir, const char* name) {
+    out.close();
+    if (!out) {
+        throw std::runtime_error("Failed to write " + (std::filesystem::path(dir) / name).string());
+    }
+}
+
+/**
+ * @brief 以“键 值”文本行写出方案和FHE参数
+ * 
+ * num_threads是运行时选项，不写入参数文件。
+ */
+void write_params(std::ostream& out, FHE_SCHEME scheme, const FHEParams& params) {
+    out << "scheme " << (scheme == FHE_SCHEME::BGV ? "BGV" : "BFV") << "\n"
+        << "security_level " << params.security_level << "\n"
+        << "poly_modulus_degree " << params.poly_modulus_degree << "\n"
+        << "plain_modulus " << params.plain_modulus.get_str() << "\n"
+        << "cipher_modulus_bits " << params.cipher_modulus_bits << "\n"
+        << "cyclotomic_index " << params.cyclotomic_index << "\n"
+        << "coeff_modulus_bits";
+    for (int bits : params.coeff_modulus_bits) {
+        out << " " << bits;
+    }
+    out << "\n";
+}
+
+/**
+ * @brief 读取write_params写出的方案和FHE参数
+ * @throws std::runtime_error 当缺少必需字段或字段格式错误时抛出异常
+ */
+void read_params(std::istream& in, FHE_SCHEME& scheme, FHEParams& params) {
+    in.exceptions(std::ios::badbit);
+    params = FHEParams{};
+    bool has_scheme = false;
+    bool has_modulus = false;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string key;
+        if (!(fields >> key)) {
+            continue;
+        }
+        if (key == "scheme") {
+            std::string name;
+            fields >> name;
+            if (name != "BGV" && name != "BFV") {
+                throw std::runtime_error("Unknown FHE scheme in parameter file: " + name);
+            }
+            scheme = name == "BGV" ? FHE_SCHEME::BGV : FHE_SCHEME::BFV;
+            has_scheme = true;
+        } else if (key == "security_level") {
+            fields >> params.security_level;
+        } else if (key == "poly_modulus_degree") {
+            fields >> params.poly_modulus_degree;
+        } else if (key == "plain_modulus") {
+            std::string value;
+            fields >> value;
+            has_modulus = params.plain_modulus.set_str(value, 10) == 0;
+        } else if (key == "cipher_modulus_bits") {
+            fields >> params.cipher_modulus_bits;
+        } else if (key == "cyclotomic_index") {
+            fields >> params.cyclotomic_index;
+        } else if (key == "coeff_modulus_bits") {
+            int bits;
+            while (fields >> bits) {
+                params.coeff_modulus_bits.push_back(bits);
+            }
+            fields.clear();
+        }
+        if (fields.fail()) {
+            throw std::runtime_error("Malformed parameter line: " + line);
+        }
+    }
+    if (!has_scheme || !has_modulus || params.poly_modulus_degree == 0) {
+        throw std::runtime_error("Parameter file is missing scheme, plain_modulus or poly_modulus_degree");
+    }
+}
+
+// 密文容器头：魔数、格式版本、方案、密文数
+constexpr char kCiphertextMagic[4] = {'Y', 'U', 'S', 'C'};
+constexpr uint8_t kCiphertextFormat = 1;
+constexpr uint64_t kContainerHeaderBytes = 4 + 1 + 1 + 8;
+// 反序列化时单个密文帧的上限：最多3个多项式，另加元数据和压缩膨胀的余量
+constexpr uint64_t kMaxCiphertextParts = 3;
+constexpr uint64_t kFrameSlackBytes = 64 * 1024;
+
+/**
+ * @brief 选择压缩模式
+ * @param compress 是否压缩
+ * @return zstd；SEAL未启用zstd时退回其默认压缩模式
+ */
+seal::compr_mode_type compr_mode(bool compress) {
+    if (!compress) {
+        return seal::compr_mode_type::none;
+    }
+    if (seal::Serialization::IsSupportedComprMode(seal::compr_mode_type::zstd)) {
+        return seal::compr_mode_type::zstd;
+    }
+    return seal::Serialization::compr_mode_default;
+}
+
+/**
+ * @brief 把任意二进制输出放入SEAL序列化帧
+ * @param write_members 写出原始字节的回调（如HElib的writeTo）
+ * @param out 输出流
+ * @param compress 是否压缩
+ * @return 未压缩和实际写出的字节数（含帧头）
+ * 
+ * SEAL要求预先给出未压缩大小，因此先写入内存再整体成帧。
+ */
+SerializedSize save_framed(const std::function<void(std::ostream&)>& write_members,
+                           std::ostream& out, bool compress) {
+    std::ostringstream raw(std::ios::binary);
+    write_members(raw);
+    const std::string bytes = raw.str();
+    const auto raw_size = static_cast<std::streamoff>(bytes.size() + seal::Serialization::seal_header_size);
+    const auto stored = seal::Serialization::Save(
+        [&](std::ostream& s) { s.write(bytes.data(), static_cast<std::streamsize>(bytes.size())); },
+        raw_size, out, compr_mode(compress), false);
+    return SerializedSize{static_cast<uint64_t>(raw_size), static_cast<uint64_t>(stored)};
+}
+
+/**
+ * @brief 从SEAL序列化帧读取save_framed写出的数据
+ * @param read_members 读取原始字节的回调（如HElib的readFrom）
+ * @param in 输入流
+ */
+void load_framed(const std::function<void(std::istream&)>& read_members, std::istream& in) {
+    seal::Serialization::Load([&](std::istream& s, seal::SEALVersion) { read_members(s); }, in, false);
+}
+
+/**
+ * @brief 从内存中的SEAL序列化帧读取save_framed写出的数据
+ */
+void load_framed(const std::function<void(std::istream&)>& read_members, const std::string& frame) {
+    seal::Serialization::Load([&](std::istream& s, seal::SEALVersion) { read_members(s); },
+                              reinterpret_cast<const seal::seal_byte*>(frame.data()), frame.size(), false);
+}
+
+/**
+ * @brief 小端写出uint64_t
+ */
+void write_u64(std::ostream& out, uint64_t v) {
+    char bytes[8];
+    for (int k = 0; k < 8; ++k) {
+        bytes[k] = static_cast<char>(v >> (8 * k));
+    }
+    out.write(bytes, 8);
+}
+
+/**
+ * @brief 小端读取uint64_t
+ */
+uint64_t read_u64(std::istream& in) {
+    unsigned char bytes[8] = {0};
+    in.read(reinterpret_cast<char*>(bytes), 8);
+    uint64_t v = 0;
+    for (int k = 0; k < 8; ++k) {
+        v |= static_cast<uint64_t>(bytes[k]) << (8 * k);
+    }
+    return v;
+}
+
+/**
+ * @brief 写出密文容器
+ * @param out 输出流
+ * @param scheme 密文所属的方案
+ * @param frames 逐个密文的序列化帧
+ * @param raw_bytes 逐个密文的未压缩字节数
+ * @return 未压缩和实际写出的字节数（含容器头）
+ * @throws std::runtime_error 当写入失败时抛出异常
+ */
+SerializedSize write_container(std::ostream& out, FHE_SCHEME scheme, const std::vector<std::string>& frames,
+                               const std::vector<uint64_t>& raw_bytes) {
+    out.write(kCiphertextMagic, sizeof(kCiphertextMagic));
+    out.put(static_cast<char>(kCiphertextFormat));
+    out.put(static_cast<char>(scheme));
+    write_u64(out, frames.size());
+
+    SerializedSize size{kContainerHeaderBytes, kContainerHeaderBytes};
+    for (size_t i = 0; i < frames.size(); ++i) {
+        out.write(frames[i].data(), static_cast<std::streamsize>(frames[i].size()));
+        size.raw_bytes += raw_bytes[i];
+        size.stored_bytes += frames[i].size();
+    }
+    if (!out) {
+        throw std::runtime_error("Failed to write serialized ciphertexts");
+    }
+    return size;
+}
+
+} // namespace
+
+/**
+ * @brief 按YuS电路深度自动选择FHE参数
+ * @param scheme 同态加密方案
+ * @param plain_modulus YuS素数p
+ * @param security_level 安全级别
+ * @param rounds YuS轮数
+ * @param noise_margin_bits 噪声余量
+ * @param packing 打包方式
+ * @param poly_modulus_degree 指定环维数，0表示自动选择
+ * @return 选出的FHE参数
+ * @throws std::invalid_argument 当参数无效或不存在满足条件的环维数时抛出异常
+ * 
+ * 所需模数位数 = log2(p) + 新鲜噪声 + rounds·每轮噪声 + 最终线性层 + 余量，
+ * 列式打包再加上rounds+1个线性层的对角明文乘法。
+ * SEAL把数据模数均分为rounds+1个素数（每个不超过60位），再加一个同样大小的特殊素数；
+ * HElib的特殊素数由ContextBuilder按列数c=2自动生成，约为数据模数的一半。
+ */
+FHEParams select_fhe_params(FHE_SCHEME scheme, const mpz_class& plain_modulus,
+                            uint32_t security_level, uint32_t rounds,
+                            uint32_t noise_margin_bits, PackingMode packing,
+                            uint32_t poly_modulus_degree) {
+    if (security_level != 80 && security_level != 128) {
+        throw std::invalid_argument("Security level must be 80 or 128");
+    }
+    if (!is_p_2mod3(plain_modulus) || mpz_probab_prime_p(plain_modulus.get_mpz_t(), 25) == 0) {
+        throw std::invalid_argument("Plain modulus must be a prime with p ≡ 2 mod 3");
+    }
+    if (rounds == 0) {
+        throw std::invalid_argument("Round count must be positive");
+    }
+    if (scheme == FHE_SCHEME::BGV) {
+        helib_plain_modulus(plain_modulus);
+    }
+    const uint32_t p_bits = static_cast<uint32_t>(mpz_sizeinbase(plain_modulus.get_mpz_t(), 2));
+
+    for (uint32_t log_n = 10; log_n <= 15; ++log_n) {
+        const uint32_t n = 1u << log_n;
+        if (poly_modulus_degree != 0 && n != poly_modulus_degree) {
+            continue;
+        }
+        if (plain_modulus % (2 * n) != 1) {
+            continue;
+        }
+
+        uint32_t data_bits = p_bits + (log_n + kFreshNoiseBits) +
+                             rounds * (p_bits + log_n + kRoundNoiseBits) +
+                             kLinearNoiseBits + noise_margin_bits;
+        if (packing == PackingMode::COLUMN) {
+            data_bits += (rounds + 1) * (p_bits + log_n + kDiagonalNoiseBits);
+        }
+        const uint32_t num_primes = std::max(rounds + 1, (data_bits + kMaxPrimeBits - 1) / kMaxPrimeBits);
+        const uint32_t prime_bits = (data_bits + num_primes - 1) / num_primes;
+
+        const uint32_t total_bits = (scheme == FHE_SCHEME::BFV)
+                                        ? (num_primes + 1) * prime_bits
+                                        : data_bits + (data_bits + 1) / 2;
+        if (static_cast<int>(total_bits) > max_coeff_modulus_bits(log_n, security_level)) {
+            continue;
+        }
+
+        FHEParams params;
+        params.security_level = security_level;
+        params.poly_modulus_degree = n;
+        params.plain_modulus = plain_modulus;
+        params.cipher_modulus_bits = num_primes * prime_bits;
+        params.cyclotomic_index = 2 * n;
+        params.coeff_modulus_bits.assign(num_primes + 1, static_cast<int>(prime_bits));
+        return params;
+    }
+    if (poly_modulus_degree != 0) {
+        throw std::invalid_argument("Ring dimension " + std::to_string(poly_modulus_degree) + " does not support " +
+                                    std::to_string(rounds) + " rounds at " + std::to_string(security_level) +
+                                    "-bit security with batching modulo p");
+    }
+    throw std::invalid_argument("No ring dimension up to 32768 supports " + std::to_string(rounds) +
+                                " rounds at " + std::to_string(security_level) +
+                                "-bit security with batching modulo p");
+}
+
+/**
+ * @brief FHEWrapper构造函数
+ * @param scheme 同态加密方案（BGV或BFV）
+ * @param params FHE参数配置
+ * @throws std::invalid_argument 当参数不满足条件时抛出异常
+ * 
+ * 初始化FHE封装实例，验证安全级别和明文模数条件，根据方案初始化相应的加密库并生成密钥。
+ */
+FHEWrapper::FHEWrapper(FHE_SCHEME scheme, const FHEParams& params)
+    : scheme_(scheme), params_(params),
+      linear_layer_(), linear_schedule_(linear_layer_.addition_schedule()) {
+    check_params(params);
 
     // 根据方案初始化相应的加密库
     if (scheme == FHE_SCHEME::BGV) {
         init_helib();
+        generate_helib_keys();
     } else if (scheme == FHE_SCHEME::BFV) {
         init_seal();
+        generate_seal_keys();
+    }
+    init_runtime(params.num_threads);
+}
+
+/**
+ * @brief 从密钥目录加载FHEWrapper
+ * @param key_dir 密钥目录
+ * @param eval_only 只加载公钥和重线性化密钥
+ * @param num_threads 同态评估工作线程数
+ * @throws std::runtime_error 当文件缺失或格式错误时抛出异常
+ * @throws std::invalid_argument 当保存的参数无效时抛出异常
+ */
+FHEWrapper::FHEWrapper(const std::string& key_dir, bool eval_only, uint32_t num_threads)
+    : linear_layer_(), linear_schedule_(linear_layer_.addition_schedule()) {
+    std::ifstream in = open_input(key_dir, kParamsFile);
+    read_params(in, scheme_, params_);
+    params_.num_threads = num_threads;
+    check_params(params_);
+
+    if (scheme_ == FHE_SCHEME::BGV) {
+        load_helib(key_dir, eval_only);
+    } else {
+        load_seal(key_dir, eval_only);
     }
+    init_runtime(num_threads);
 }
 
 /**
@@ -55,16 +552,34 @@ FHEWrapper::FHEWrapper(FHE_SCHEME scheme, const FHEParams& params)
 FHEWrapper::~FHEWrapper() = default;
 
 /**
- * @brief 初始化HElib(BGV方案)
+ * @brief 初始化线程池、SEAL内存池和密文对象池
+ * @param num_threads 工作线程数，0表示使用硬件并发数
+ */
+void FHEWrapper::init_runtime(uint32_t num_threads) {
+    // 持久线程池，每个工作者独占一个SEAL内存池以避免全局内存池的互斥锁竞争
+    thread_pool_ = std::make_unique<ThreadPool>(num_threads);
+    for (size_t w = 0; w < thread_pool_->size(); ++w) {
+        seal_pools_.push_back(seal::MemoryPoolHandle::New());
+    }
+    ciphertext_pool_ = CiphertextPool::create(scheme_, seal_pools_);
+    if (scheme_ == FHE_SCHEME::BGV) {
+        ciphertext_pool_->set_helib_pubkey(helib_pubkey_.get());
+    }
+}
+
+/**
+ * @brief 初始化HElib(BGV方案)上下文
  * 
- * 配置HElib的BGV方案参数
- * 生成密钥对并初始化加密上下文。
+ * 配置HElib的BGV方案参数并构建加密上下文（含模数链）。
+ * @throws std::invalid_argument 当p超出HElib的long范围时抛出异常
  */
 void FHEWrapper::init_helib() {
-    unsigned long m = params_.poly_modulus_degree;
-    unsigned long p = params_.plain_modulus.get_ui();
+    // m是分圆多项式指数，2的幂分圆环Z[X]/(X^N+1)对应m = 2N
+    unsigned long m = params_.cyclotomic_index ? params_.cyclotomic_index : 2ul * params_.poly_modulus_degree;
+    long p = helib_plain_modulus(params_.plain_modulus);
     unsigned long r = 1;
     unsigned long bits = params_.cipher_modulus_bits;
+    unsigned long c = 2;   // 密钥交换矩阵的列数
 
     // 构建HElib上下文
     helib_context_.reset(
@@ -73,233 +588,1934 @@ void FHEWrapper::init_helib() {
             .p(p)
             .r(r)
             .bits(bits)
-            .c(params_.security_level)
+            .c(c)
             .buildPtr() 
     );
+}
 
-    // 生成密钥对
+/**
+ * @brief 生成HElib私钥和公钥
+ * 
+ * 公钥由私钥复制得到，包含重线性化所需的密钥交换矩阵。
+ */
+void FHEWrapper::generate_helib_keys() {
     helib_seckey_ = std::make_shared<helib::SecKey>(*helib_context_);
     helib_seckey_->GenSecKey();
     helib_pubkey_ = std::make_shared<helib::PubKey>(*helib_seckey_);
 }
 
 /**
- * @brief 初始化SEAL(BFV方案)
+ * @brief 初始化SEAL(BFV方案)上下文
  * 
- * 配置SEAL的BFV方案参数
- * 生成密钥对、重线性化密钥，并初始化各种操作器。
+ * 配置SEAL的BFV方案参数并构建上下文。加密器、解密器、评估器和编码器在首次使用时构造。
+ * @throws std::invalid_argument 当p不支持批处理或SEAL拒绝参数时抛出异常
  */
 void FHEWrapper::init_seal() {
     // 配置加密参数
     seal::EncryptionParameters enc_params(seal::scheme_type::bfv);
     enc_params.set_poly_modulus_degree(params_.poly_modulus_degree);
-    enc_params.set_coeff_modulus(
-        seal::CoeffModulus::BFVDefault(params_.poly_modulus_degree));
-    enc_params.set_plain_modulus(
-        seal::PlainModulus::Batching(params_.poly_modulus_degree, 20));
-
-    // 初始化SEAL上下文
-    seal_context_ = std::make_unique<seal::SEALContext>(enc_params);
-    
-    // 生成密钥对
+    if (params_.coeff_modulus_bits.empty()) {
+        enc_params.set_coeff_modulus(
+            seal::CoeffModulus::BFVDefault(params_.poly_modulus_degree));
+    } else {
+        enc_params.set_coeff_modulus(
+            seal::CoeffModulus::Create(params_.poly_modulus_degree, params_.coeff_modulus_bits));
+    }
+    // 明文模数即YuS素数p，批处理要求p ≡ 1 mod 2N
+    if (params_.plain_modulus % (2 * params_.poly_modulus_degree) != 1) {
+        throw std::invalid_argument("Plain modulus must satisfy p ≡ 1 mod 2N for BFV batching");
+    }
+    enc_params.set_plain_modulus(to_u64(params_.plain_modulus));
+    make_seal_context(enc_params);
+}
+
+/**
+ * @brief 构建SEAL上下文
+ * @param enc_params 加密参数
+ * @throws std::invalid_argument 当SEAL拒绝参数时抛出异常
+ */
+void FHEWrapper::make_seal_context(const seal::EncryptionParameters& enc_params) {
+    // SEAL只内置128位以上的安全表，80位参数由select_fhe_params保证
+    const auto sec_level = params_.security_level == 128 ? seal::sec_level_type::tc128
+                                                         : seal::sec_level_type::none;
+    seal_context_ = std::make_unique<seal::SEALContext>(enc_params, true, sec_level);
+    if (!seal_context_->parameters_set()) {
+        throw std::invalid_argument(std::string("Invalid SEAL parameters: ") +
+                                    seal_context_->parameter_error_message());
+    }
+}
+
+/**
+ * @brief 生成SEAL私钥、公钥和重线性化密钥
+ * 
+ * 已构造的加密器和解密器复制了旧密钥，需要随密钥重建；尚未构造的在首次使用时以新密钥构造。
+ */
+void FHEWrapper::generate_seal_keys() {
     seal::KeyGenerator keygen(*seal_context_);
     seal_seckey_ = std::make_unique<seal::SecretKey>(keygen.secret_key());
     seal_pubkey_ = std::make_unique<seal::PublicKey>();
     keygen.create_public_key(*seal_pubkey_);
-    
-    // 生成重线性化密钥
     seal_relin_keys_ = std::make_unique<seal::RelinKeys>();
     keygen.create_relin_keys(*seal_relin_keys_);
+    if (seal_galois_keys_) {
+        keygen.create_galois_keys(column_rotation_steps(), *seal_galois_keys_);
+    }
 
-    // 初始化各种操作器
-    seal_encryptor_ = std::make_unique<seal::Encryptor>(*seal_context_, *seal_pubkey_);
-    seal_decryptor_ = std::make_unique<seal::Decryptor>(*seal_context_, *seal_seckey_);
-    seal_evaluator_ = std::make_unique<seal::Evaluator>(*seal_context_);
-    seal_batch_encoder_ = std::make_unique<seal::BatchEncoder>(*seal_context_);
+    if (seal_encryptor_) {
+        seal_encryptor_ = std::make_unique<seal::Encryptor>(*seal_context_, *seal_pubkey_);
+    }
+    if (seal_decryptor_) {
+        seal_decryptor_ = std::make_unique<seal::Decryptor>(*seal_context_, *seal_seckey_);
+    }
 }
 
 /**
- * @brief 生成密钥对
+ * @brief 重新生成密钥对
  * 
  * 重新生成同态加密的密钥对，支持BGV和BFV两种方案。
- * 用于密钥轮换或重新初始化。
+ * 用于密钥轮换；HElib对象池随公钥更换丢弃旧公钥下的空闲密文。
  */
 void FHEWrapper::generate_keys() {
     if (scheme_ == FHE_SCHEME::BGV) {
-        helib_seckey_->GenSecKey();
-        helib_pubkey_ = std::make_shared<helib::PubKey>(*helib_seckey_);
+        generate_helib_keys();
+        ciphertext_pool_->set_helib_pubkey(helib_pubkey_.get());
     } else {
-        seal::KeyGenerator keygen(*seal_context_);
-        *seal_seckey_ = keygen.secret_key();
-        keygen.create_public_key(*seal_pubkey_);
-        keygen.create_relin_keys(*seal_relin_keys_);
-        
-        // 重新初始化加密器和解密器
-        seal_encryptor_ = std::make_unique<seal::Encryptor>(*seal_context_, *seal_pubkey_);
-        seal_decryptor_ = std::make_unique<seal::Decryptor>(*seal_context_, *seal_seckey_);
+        generate_seal_keys();
     }
 }
 
 /**
- * @brief 打包明文数据
- * @param data 原始明文数据向量
- * @return 打包后的明文数据向量
- * 
- * 对于BGV方案，将多个明文元素打包到单个密文槽中以提高效率。
- * 对于BFV方案，直接返回原始数据（支持批处理）。
+ * @brief 保存上下文、参数和密钥
+ * @param key_dir 密钥目录
+ * @throws std::runtime_error 当目录无法创建或文件无法写入时抛出异常
  */
-std::vector<mpz_class> FHEWrapper::pack_plaintext(const std::vector<mpz_class>& data) const {
-    if (scheme_ == FHE_SCHEME::BFV) {
-        return data;
-    }
-    
-    std::vector<mpz_class> packed;
-    long nslots = helib_context_->getNSlots();
-    uint32_t batch_size = nslots;
-    uint32_t num_batches = (data.size() + batch_size - 1) / batch_size;
-
-    // 将数据分批打包
-    for (uint32_t i = 0; i < num_batches; ++i) {
-        mpz_class batch(0);
-        uint32_t start = i * batch_size;
-        uint32_t end = std::min(start + batch_size, (uint32_t)data.size());
-        uint32_t elem_bits = mpz_sizeinbase(params_.plain_modulus.get_mpz_t(), 2);
-        
-        // 将多个元素打包到单个大整数中
-        for (uint32_t j = start; j < end; ++j) {
-            batch = (batch << elem_bits) | data[j];
-        }
-        packed.push_back(batch);
+void FHEWrapper::save(const std::string& key_dir) const {
+    std::error_code ec;
+    std::filesystem::create_directories(key_dir, ec);
+    if (ec) {
+        throw std::runtime_error("Cannot create key directory " + key_dir + ": " + ec.message());
     }
-    return packed;
-}
 
-/**
- * @brief 加密明文数据
- * @param plain 明文数据向量
- * @param cipher 输出密文向量
- * 
- * 使用配置的同态加密方案对明文数据进行加密。
- * BGV方案逐个元素加密，BFV方案支持批处理加密。
- */
-void FHEWrapper::encrypt(const std::vector<mpz_class>& plain, std::vector<CiphertextPtr>& cipher) {
-    cipher.clear();
+    std::ofstream params_out = open_output(key_dir, kParamsFile);
+    write_params(params_out, scheme_, params_);
+    close_output(params_out, key_dir, kParamsFile);
 
+    std::ofstream context_out = open_output(key_dir, kContextFile);
+    std::ofstream public_out = open_output(key_dir, kPublicKeyFile);
+    save_public_key(public_out);
     if (scheme_ == FHE_SCHEME::BGV) {
-        // BGV方案：逐个元素加密
-        for (const auto& p : plain) {
-            helib::Ptxt<helib::BGV> ptxt(*helib_context_);
-            ptxt[0] = p.get_si();
-            
-            auto ctxt = std::make_shared<helib::Ctxt>(*helib_pubkey_);
-            helib_pubkey_->Encrypt(*ctxt, ptxt);
-            cipher.push_back(ctxt);
+        helib_context_->writeTo(context_out);
+        if (helib_seckey_) {
+            std::ofstream secret_out = open_output(key_dir, kSecretKeyFile);
+            save_framed([&](std::ostream& s) { helib_seckey_->writeTo(s); }, secret_out, true);
+            close_output(secret_out, key_dir, kSecretKeyFile);
         }
     } else {
-        // BFV方案：批处理加密
-        std::vector<uint64_t> seal_plain(plain.size());
-        for (size_t i = 0; i < plain.size(); ++i) {
-            seal_plain[i] = plain[i].get_ui();
+        seal_context_->key_context_data()->parms().save(context_out);
+        std::ofstream relin_out = open_output(key_dir, kRelinKeysFile);
+        save_relin_keys(relin_out);
+        close_output(relin_out, key_dir, kRelinKeysFile);
+        if (seal_galois_keys_) {
+            std::ofstream galois_out = open_output(key_dir, kGaloisKeysFile);
+            seal_galois_keys_->save(galois_out, compr_mode(true));
+            close_output(galois_out, key_dir, kGaloisKeysFile);
+        }
+        if (seal_seckey_) {
+            std::ofstream secret_out = open_output(key_dir, kSecretKeyFile);
+            seal_seckey_->save(secret_out, compr_mode(true));
+            close_output(secret_out, key_dir, kSecretKeyFile);
         }
-        
-        seal::Plaintext ptxt;
-        seal_batch_encoder_->encode(seal_plain, ptxt);
-        
-        auto ctxt = std::make_shared<seal::Ciphertext>();
-        seal_encryptor_->encrypt(ptxt, *ctxt);
-        cipher.push_back(ctxt);
     }
+    close_output(context_out, key_dir, kContextFile);
+    close_output(public_out, key_dir, kPublicKeyFile);
 }
 
 /**
- * @brief 解密密文数据
- * @param cipher 密文向量
- * @return 解密后的明文数据向量
+ * @brief 从目录加载HElib上下文和密钥
+ * @param key_dir 密钥目录
+ * @param eval_only 只加载公钥
  * 
- * 使用对应的私钥对密文数据进行解密。
- * BGV方案逐个元素解密，BFV方案支持批处理解密。
+ * HElib的私钥文件包含公钥部分，完整模式只读取私钥文件。
  */
-std::vector<mpz_class> FHEWrapper::decrypt(const std::vector<CiphertextPtr>& cipher) const {
-    std::vector<mpz_class> plain;
+void FHEWrapper::load_helib(const std::string& key_dir, bool eval_only) {
+    std::ifstream context_in = open_input(key_dir, kContextFile);
+    helib_context_.reset(helib::Context::readPtrFrom(context_in));
 
-    if (scheme_ == FHE_SCHEME::BGV) {
-        // BGV方案：逐个元素解密
-        for (const auto& c : cipher) {
-            helib::Ctxt* ctxt = static_cast<helib::Ctxt*>(c.get());
-            helib::Ptxt<helib::BGV> ptxt(*helib_context_);
-            
-            helib_seckey_->Decrypt(ptxt, *ctxt);
-            plain.push_back(mpz_class(static_cast<long>(ptxt[0])));
-        }
+    if (eval_only) {
+        std::ifstream public_in = open_input(key_dir, kPublicKeyFile);
+        load_public_key(public_in);
     } else {
-        // BFV方案：批处理解密
-        if (cipher.empty()) return plain;
-        
-        seal::Ciphertext* ctxt = static_cast<seal::Ciphertext*>(cipher[0].get());
-        seal::Plaintext ptxt;
-        seal_decryptor_->decrypt(*ctxt, ptxt);
-        
-        std::vector<uint64_t> seal_plain;
-        seal_batch_encoder_->decode(ptxt, seal_plain);
-        
-        for (auto val : seal_plain) {
-            plain.push_back(mpz_class(static_cast<unsigned long>(val)));
-        }
-    }
-    
-    return plain;
+        std::ifstream secret_in = open_input(key_dir, kSecretKeyFile);
+        load_framed([&](std::istream& s) {
+            helib_seckey_ = std::make_shared<helib::SecKey>(helib::SecKey::readFrom(s, *helib_context_));
+        }, secret_in);
+        helib_pubkey_ = std::make_shared<helib::PubKey>(*helib_seckey_);
+    }
 }
 
 /**
- * @brief 同态评估YuS流密码
- * @param cipher_key 加密的密钥向量
- * @param cipher_keystream 加密的密钥流向量
- * @return 评估时间（毫秒）
- * 
- * 在密文状态下执行YuS流密码的同态评估，支持并行处理。
- * 测量评估性能并返回执行时间。
+ * @brief 从目录加载SEAL上下文和密钥
+ * @param key_dir 密钥目录
+ * @param eval_only 只加载公钥和重线性化密钥
+ * @throws std::invalid_argument 当保存的上下文与参数文件不一致时抛出异常
  */
-double FHEWrapper::evaluate_yus(const std::vector<CiphertextPtr>& cipher_key, 
-                                const std::vector<CiphertextPtr>& cipher_keystream) {
-    Timer timer;
-    timer.start();
+void FHEWrapper::load_seal(const std::string& key_dir, bool eval_only) {
+    std::ifstream context_in = open_input(key_dir, kContextFile);
+    seal::EncryptionParameters enc_params;
+    enc_params.load(context_in);
+    if (enc_params.poly_modulus_degree() != params_.poly_modulus_degree ||
+        enc_params.plain_modulus().value() != to_u64(params_.plain_modulus)) {
+        throw std::invalid_argument("Saved SEAL context does not match " + std::string(kParamsFile));
+    }
+    make_seal_context(enc_params);
 
-    if (scheme_ == FHE_SCHEME::BGV) {
-        // BGV方案：并行同态乘法
-        #pragma omp parallel for
-        for (size_t i = 0; i < cipher_key.size(); ++i) {
-            helib::Ctxt* key = static_cast<helib::Ctxt*>(cipher_key[i].get());
-            helib::Ctxt* ks = static_cast<helib::Ctxt*>(cipher_keystream[i].get());
-            
-            *ks *= *key;  // 同态乘法
-            ks->reLinearize();  // 重线性化
-        }
-    } else {
-        // BFV方案：批处理同态操作
-        if (cipher_key.empty() || cipher_keystream.empty()) return 0.0;
-        
-        seal::Ciphertext* key = static_cast<seal::Ciphertext*>(cipher_key[0].get());
-        seal::Ciphertext* ks = static_cast<seal::Ciphertext*>(cipher_keystream[0].get());
-        
-        seal_evaluator_->multiply_inplace(*ks, *key);  // 同态乘法
-        seal_evaluator_->relinearize_inplace(*ks, *seal_relin_keys_);  // 重线性化
+    std::ifstream public_in = open_input(key_dir, kPublicKeyFile);
+    load_public_key(public_in);
+
+    std::ifstream relin_in = open_input(key_dir, kRelinKeysFile);
+    load_relin_keys(relin_in);
+
+    // 伽罗瓦密钥只在生成过列式打包密钥时存在
+    if (std::filesystem::exists(std::filesystem::path(key_dir) / kGaloisKeysFile)) {
+        std::ifstream galois_in = open_input(key_dir, kGaloisKeysFile);
+        seal_galois_keys_ = std::make_unique<seal::GaloisKeys>();
+        seal_galois_keys_->load(*seal_context_, galois_in);
     }
 
-    timer.stop();
-    return timer.elapsed_ms();
+    if (!eval_only) {
+        std::ifstream secret_in = open_input(key_dir, kSecretKeyFile);
+        seal_seckey_ = std::make_unique<seal::SecretKey>();
+        seal_seckey_->load(*seal_context_, secret_in);
+    }
 }
 
 /**
- * @brief 计算吞吐量
- * @param data_size 数据大小（字节）
- * @param eval_time 评估时间（毫秒）
- * @return 吞吐量（KB/s）
- * 
- * 根据数据大小和评估时间计算同态加密的吞吐量性能指标。
+ * @brief 是否持有私钥
+ * @return 持有私钥返回true
+ */
+bool FHEWrapper::has_secret_key() const {
+    return scheme_ == FHE_SCHEME::BGV ? static_cast<bool>(helib_seckey_) : static_cast<bool>(seal_seckey_);
+}
+
+/**
+ * @brief 获取FHE参数
+ * @return FHE参数配置
+ */
+const FHEParams& FHEWrapper::params() const {
+    return params_;
+}
+
+/**
+ * @brief 获取SEAL加密器
+ * @return 加密器
+ */
+const seal::Encryptor& FHEWrapper::seal_encryptor() const {
+    std::call_once(seal_encryptor_once_, [this] {
+        seal_encryptor_ = std::make_unique<seal::Encryptor>(*seal_context_, *seal_pubkey_);
+    });
+    return *seal_encryptor_;
+}
+
+/**
+ * @brief 获取SEAL解密器
+ * @return 解密器
+ * @throws std::runtime_error 当未持有私钥时抛出异常
+ */
+seal::Decryptor& FHEWrapper::seal_decryptor() const {
+    if (!seal_seckey_) {
+        throw std::runtime_error("Secret key is not loaded (evaluation-only mode)");
+    }
+    std::call_once(seal_decryptor_once_, [this] {
+        seal_decryptor_ = std::make_unique<seal::Decryptor>(*seal_context_, *seal_seckey_);
+    });
+    return *seal_decryptor_;
+}
+
+/**
+ * @brief 获取SEAL评估器
+ * @return 评估器
+ */
+const seal::Evaluator& FHEWrapper::seal_evaluator() const {
+    std::call_once(seal_evaluator_once_, [this] {
+        seal_evaluator_ = std::make_unique<seal::Evaluator>(*seal_context_);
+    });
+    return *seal_evaluator_;
+}
+
+/**
+ * @brief 获取SEAL批处理编码器
+ * @return 批处理编码器
  */
-double FHEWrapper::get_throughput(uint32_t data_size, double eval_time) const {
-    double eval_time_sec = eval_time / 1000.0;
-    return eval_time_sec > 0 ? (data_size / 1024.0) / eval_time_sec : 0.0;
+const seal::BatchEncoder& FHEWrapper::seal_batch_encoder() const {
+    std::call_once(seal_batch_encoder_once_, [this] {
+        seal_batch_encoder_ = std::make_unique<seal::BatchEncoder>(*seal_context_);
+    });
+    return *seal_batch_encoder_;
+}
+
+/**
+ * @brief 打包明文数据
+ * @param data 原始明文数据向量
+ * @return 模p约简并补零到槽数量整数倍的明文向量
+ * 
+ * 返回encrypt使用的槽布局：第c个密文的槽j对应元素c·nslots+j。
+ * decrypt(encrypt(data))与pack_plaintext(data)逐元素相等。
+ */
+std::vector<mpz_class> FHEWrapper::pack_plaintext(const std::vector<mpz_class>& data) const {
+    const size_t nslots = slot_count();
+    const size_t num_cts = (data.size() + nslots - 1) / nslots;
+
+    std::vector<mpz_class> packed(num_cts * nslots, 0);
+    for (size_t i = 0; i < data.size(); ++i) {
+        packed[i] = mod(data[i], params_.plain_modulus);
+    }
+    return packed;
+}
+
+/**
+ * @brief 加密明文数据
+ * @param plain 明文数据向量
+ * @param cipher 输出密文向量
+ * 
+ * 两种方案均按槽打包：输入按slot_count()分块，每块加密为一个密文，
+ * 最后一块不足的槽填0。各块在线程池上并行加密。
+ */
+void FHEWrapper::encrypt(const std::vector<mpz_class>& plain, std::vector<Ciphertext>& cipher) {
+    const size_t nslots = slot_count();
+    const size_t num_cts = (plain.size() + nslots - 1) / nslots;
+
+    cipher.assign(num_cts, Ciphertext());
+    thread_pool_->parallel_for(num_cts, [&](size_t c, size_t worker) {
+        std::vector<uint64_t> slots(nslots, 0);
+        for (size_t j = 0; j < nslots && c * nslots + j < plain.size(); ++j) {
+            slots[j] = to_u64(mod(plain[c * nslots + j], params_.plain_modulus));
+        }
+        cipher[c] = encrypt_slots(slots, worker);
+    });
+}
+
+/**
+ * @brief 解密密文数据
+ * @param cipher 密文向量
+ * @return 解密后的明文数据向量
+ * 
+ * 返回每个密文的全部槽，按密文顺序拼接，长度为cipher.size()·slot_count()。
+ * 各密文在线程池上并行解密。
+ */
+std::vector<mpz_class> FHEWrapper::decrypt(const std::vector<Ciphertext>& cipher) const {
+    if (!has_secret_key()) {
+        throw std::runtime_error("Secret key is not loaded (evaluation-only mode)");
+    }
+    const size_t nslots = slot_count();
+    std::vector<mpz_class> plain(cipher.size() * nslots);
+
+    thread_pool_->parallel_for(cipher.size(), [&](size_t c, size_t) {
+        if (scheme_ == FHE_SCHEME::BGV) {
+            const auto& ctxt = cipher[c].helib();
+            helib::Ptxt<helib::BGV> ptxt(*helib_context_);
+            helib_seckey_->Decrypt(ptxt, ctxt);
+            for (size_t j = 0; j < nslots; ++j) {
+                plain[c * nslots + j] = from_u64(bgv_slot(ptxt, j));
+            }
+        } else {
+            const auto& ctxt = cipher[c].seal();
+            seal::Plaintext ptxt;
+            seal_decryptor().decrypt(ctxt, ptxt);
+            std::vector<uint64_t> slots;
+            seal_batch_encoder().decode(ptxt, slots);
+            for (size_t j = 0; j < nslots; ++j) {
+                plain[c * nslots + j] = from_u64(slots[j]);
+            }
+        }
+    });
+    return plain;
+}
+
+/**
+ * @brief 获取每个密文的槽数量
+ * @return 槽数量
+ */
+size_t FHEWrapper::slot_count() const {
+    if (scheme_ == FHE_SCHEME::BGV) {
+        return static_cast<size_t>(helib_context_->getNSlots());
+    }
+    return seal_batch_encoder().slot_count();
+}
+
+/**
+ * @brief 获取新鲜密文可丢弃的模数个数
+ * @return 模数切换链上新鲜密文之下的层数
+ */
+size_t FHEWrapper::mod_switch_capacity() const {
+    if (scheme_ == FHE_SCHEME::BGV) {
+        return static_cast<size_t>(helib_context_->getCtxtPrimes().card() - 1);
+    }
+    return seal_context_->first_context_data()->chain_index();
+}
+
+/**
+ * @brief 加密槽向量
+ * @param slots 每个槽的明文值
+ * @param worker 工作者编号
+ * @return 从密文对象池分配的新密文
+ */
+Ciphertext FHEWrapper::encrypt_slots(const std::vector<uint64_t>& slots, size_t worker) {
+    if (scheme_ == FHE_SCHEME::BGV) {
+        helib::Ptxt<helib::BGV> ptxt = make_bgv_ptxt(*helib_context_, slots);
+        Ciphertext ctxt = ciphertext_pool_->acquire(worker);
+        helib_pubkey_->Encrypt(ctxt.helib(), ptxt);
+        return ctxt;
+    }
+
+    seal::Plaintext ptxt(seal_pool(worker));
+    seal_batch_encoder().encode(slots, ptxt);
+    Ciphertext ctxt = ciphertext_pool_->acquire(worker);
+    seal_encryptor().encrypt(ptxt, ctxt.seal(), seal_pool(worker));
+    return ctxt;
+}
+
+/**
+ * @brief 加密YuS主密钥
+ * @param master_key 36个F_p元素的主密钥
+ * @param cipher_key 输出36个密文
+ * @throws std::invalid_argument 当主密钥大小不正确时抛出异常
+ * 
+ * 行式打包下每个槽对应一个块，因此第i个密文的所有槽都填充k_i。
+ */
+void FHEWrapper::encrypt_key(const std::vector<mpz_class>& master_key, std::vector<Ciphertext>& cipher_key) {
+    if (master_key.size() != 36) {
+        throw std::invalid_argument("Master key must be 36 elements (F_p^36)");
+    }
+    const size_t nslots = slot_count();
+
+    cipher_key.clear();
+    for (const auto& k : master_key) {
+        std::vector<uint64_t> slots(nslots, to_u64(mod(k, params_.plain_modulus)));
+        cipher_key.push_back(encrypt_slots(slots));
+    }
+}
+
+/**
+ * @brief 客户端以私钥对称加密YuS主密钥并序列化
+ * @param master_key 36个F_p元素的主密钥
+ * @param out 输出流
+ * @param compress 是否压缩
+ * @return 未压缩和实际写出的字节数
+ * @throws std::invalid_argument 当主密钥大小不正确时抛出异常
+ * @throws std::runtime_error 当未持有私钥时抛出异常
+ * 
+ * BFV密文的第二个多项式是均匀随机的，SEAL的encrypt_symmetric只保存生成它的种子，
+ * 加载时再展开，上传量约为公钥加密的一半。HElib没有带种子的对称加密，
+ * BGV密文以私钥加密（噪声更小），大小不变，只靠压缩缩减。
+ */
+SerializedSize FHEWrapper::encrypt_key_symmetric(const std::vector<mpz_class>& master_key, std::ostream& out,
+                                                 bool compress) const {
+    if (master_key.size() != 36) {
+        throw std::invalid_argument("Master key must be 36 elements (F_p^36)");
+    }
+    if (!has_secret_key()) {
+        throw std::runtime_error("Secret key is not loaded (evaluation-only mode)");
+    }
+    const size_t nslots = slot_count();
+    std::unique_ptr<seal::Encryptor> encryptor;
+    if (scheme_ == FHE_SCHEME::BFV) {
+        encryptor = std::make_unique<seal::Encryptor>(*seal_context_, *seal_seckey_);
+    }
+
+    std::vector<std::string> frames(master_key.size());
+    std::vector<uint64_t> raw_bytes(master_key.size());
+    thread_pool_->parallel_for(master_key.size(), [&](size_t i, size_t worker) {
+        std::vector<uint64_t> slots(nslots, to_u64(mod(master_key[i], params_.plain_modulus)));
+        std::ostringstream frame(std::ios::binary);
+        if (scheme_ == FHE_SCHEME::BGV) {
+            // 密文绑定私钥对象本身，HElib的对称加密要求二者一致；序列化结果不含公钥引用
+            helib::Ctxt ctxt(*helib_seckey_);
+            static_cast<const helib::PubKey&>(*helib_seckey_).Encrypt(ctxt, make_bgv_ptxt(*helib_context_, slots));
+            raw_bytes[i] = save_framed([&](std::ostream& s) { ctxt.writeTo(s); }, frame, compress).raw_bytes;
+        } else {
+            seal::Plaintext ptxt(seal_pool(worker));
+            seal_batch_encoder().encode(slots, ptxt);
+            auto seeded = encryptor->encrypt_symmetric(ptxt, seal_pool(worker));
+            raw_bytes[i] = static_cast<uint64_t>(seeded.save_size(seal::compr_mode_type::none));
+            seeded.save(frame, compr_mode(compress));
+        }
+        frames[i] = frame.str();
+    });
+    return write_container(out, scheme_, frames, raw_bytes);
+}
+
+/**
+ * @brief 客户端对称加密YuS主密钥并序列化到内存缓冲区
+ * @param master_key 36个F_p元素的主密钥
+ * @param buffer 输出缓冲区
+ * @param compress 是否压缩
+ * @return 未压缩和实际写出的字节数
+ */
+SerializedSize FHEWrapper::encrypt_key_symmetric(const std::vector<mpz_class>& master_key,
+                                                 std::vector<uint8_t>& buffer, bool compress) const {
+    std::ostringstream out(std::ios::binary);
+    SerializedSize size = encrypt_key_symmetric(master_key, out, compress);
+    const std::string bytes = out.str();
+    buffer.assign(bytes.begin(), bytes.end());
+    return size;
+}
+
+/**
+ * @brief 服务端加载客户端上传的加密主密钥
+ * @param in 输入流
+ * @param cipher_key 输出36个密文
+ * @throws std::runtime_error 当数据格式错误、方案不匹配或密文数不为36时抛出异常
+ * 
+ * 带种子的SEAL密文在反序列化时展开为完整密文，结果与encrypt_key的输出可互换使用。
+ */
+void FHEWrapper::load_key(std::istream& in, std::vector<Ciphertext>& cipher_key) const {
+    load_ciphertexts(in, cipher_key);
+    if (cipher_key.size() != 36) {
+        cipher_key.clear();
+        throw std::runtime_error("Uploaded master key must be 36 ciphertexts");
+    }
+}
+
+/**
+ * @brief 服务端从内存缓冲区加载加密主密钥
+ * @param data 缓冲区首地址
+ * @param size 缓冲区字节数
+ * @param cipher_key 输出36个密文
+ */
+void FHEWrapper::load_key(const uint8_t* data, size_t size, std::vector<Ciphertext>& cipher_key) const {
+    std::istringstream in(std::string(reinterpret_cast<const char*>(data), size), std::ios::binary);
+    load_key(in, cipher_key);
+}
+
+/**
+ * @brief 获取工作者独占的SEAL内存池
+ * @param worker 工作者编号
+ * @return 该工作者的内存池句柄
+ * 
+ * 使用MemoryPoolHandle::New()而非线程局部池：密文在不同工作者之间传递，
+ * 线程局部池是单线程池，跨线程释放不安全；独立的多线程池在各自工作者上几乎无竞争。
+ */
+const seal::MemoryPoolHandle& FHEWrapper::seal_pool(size_t worker) const {
+    return seal_pools_[worker];
+}
+
+/**
+ * @brief 服务端预计算加密密钥乘积
+ * @param cipher_key 加密的主密钥
+ * @param key_products 输出24个加密密钥乘积
+ * @throws std::invalid_argument 当加密密钥大小不正确时抛出异常
+ * 
+ * 每个密钥只需执行一次，结果可用于该密钥下的所有评估。
+ */
+void FHEWrapper::precompute_key_products(const std::vector<Ciphertext>& cipher_key,
+                                         std::vector<Ciphertext>& key_products) const {
+    if (cipher_key.size() != 36) {
+        throw std::invalid_argument("Encrypted master key must be 36 ciphertexts");
+    }
+    key_products.assign(24, Ciphertext());
+
+    // 每个S盒需要k0·k2和k0·k1两个乘积
+    thread_pool_->parallel_for(24, [&](size_t idx, size_t worker) {
+        const size_t base = 3 * (idx / 2);
+        const size_t other = (idx % 2 == 0) ? base + 2 : base + 1;
+        multiply(cipher_key[base], cipher_key[other], key_products[idx], worker);
+    });
+}
+
+/**
+ * @brief 客户端加密密钥乘积
+ * @param master_key 36个F_p元素的主密钥
+ * @param key_products 输出24个新鲜密文
+ * @throws std::invalid_argument 当主密钥大小不正确时抛出异常
+ */
+void FHEWrapper::encrypt_key_products(const std::vector<mpz_class>& master_key,
+                                      std::vector<Ciphertext>& key_products) {
+    if (master_key.size() != 36) {
+        throw std::invalid_argument("Master key must be 36 elements (F_p^36)");
+    }
+    const size_t nslots = slot_count();
+
+    key_products.clear();
+    for (size_t idx = 0; idx < 24; ++idx) {
+        const size_t base = 3 * (idx / 2);
+        const size_t other = (idx % 2 == 0) ? base + 2 : base + 1;
+        mpz_class product = mod(master_key[base] * master_key[other], params_.plain_modulus);
+        std::vector<uint64_t> slots(nslots, to_u64(product));
+        key_products.push_back(encrypt_slots(slots));
+    }
+}
+
+/**
+ * @brief 复制密文
+ * @param dst 目标密文，为空或被共享时从对象池分配新对象
+ * @param src 源密文
+ * @param worker 工作者编号
+ */
+void FHEWrapper::copy_ciphertext(Ciphertext& dst, const Ciphertext& src, size_t worker) const {
+    // 共享的目标可能是调用方或缓存持有的密文，换成池中的新对象而不是原地覆盖
+    if (!dst.unique()) {
+        dst = ciphertext_pool_->acquire(worker);
+    }
+    if (scheme_ == FHE_SCHEME::BGV) {
+        dst.helib() = src.helib();
+    } else {
+        dst.seal() = src.seal();
+    }
+}
+
+/**
+ * @brief 密文原地加法：dst += src
+ */
+void FHEWrapper::add_inplace(Ciphertext& dst, const Ciphertext& src) const {
+    if (scheme_ == FHE_SCHEME::BGV) {
+        dst.helib() += src.helib();
+    } else {
+        seal_evaluator().add_inplace(dst.seal(),
+                                     src.seal());
+    }
+}
+
+/**
+ * @brief 密文原地减法：dst -= src
+ */
+void FHEWrapper::sub_inplace(Ciphertext& dst, const Ciphertext& src) const {
+    if (scheme_ == FHE_SCHEME::BGV) {
+        dst.helib() -= src.helib();
+    } else {
+        seal_evaluator().sub_inplace(dst.seal(),
+                                     src.seal());
+    }
+}
+
+/**
+ * @brief 密文原地取负：ct = -ct
+ */
+void FHEWrapper::negate_inplace(Ciphertext& ct) const {
+    if (scheme_ == FHE_SCHEME::BGV) {
+        ct.helib().negate();
+    } else {
+        seal_evaluator().negate_inplace(ct.seal());
+    }
+}
+
+/**
+ * @brief 密文乘法并重线性化：dst = a * b
+ */
+void FHEWrapper::multiply(const Ciphertext& a, const Ciphertext& b, Ciphertext& dst, size_t worker,
+                          TraceRecorder* trace) const {
+    copy_ciphertext(dst, a, worker);
+    const int64_t level = trace ? ciphertext_level(a) : -1;
+    if (scheme_ == FHE_SCHEME::BGV) {
+        // HElib的multiplyBy会自动重线性化
+        TraceSpan span(trace, "multiply_relinearize", "fhe", static_cast<uint32_t>(worker), -1, level);
+        YUS_INSTRUMENT_SCOPE(Stage::FHE_MULTIPLY);
+        YUS_INSTRUMENT_COUNT(Stage::FHE_RELINEARIZE);
+        dst.helib().multiplyBy(b.helib());
+    } else {
+        auto& d = dst.seal();
+        {
+            YUS_INSTRUMENT_SCOPE(Stage::FHE_MULTIPLY);
+            seal_evaluator().multiply_inplace(d, b.seal(), seal_pool(worker));
+        }
+        TraceSpan span(trace, "relinearize", "fhe", static_cast<uint32_t>(worker), -1, level);
+        YUS_INSTRUMENT_SCOPE(Stage::FHE_RELINEARIZE);
+        seal_evaluator().relinearize_inplace(d, *seal_relin_keys_, seal_pool(worker));
+    }
+}
+
+/**
+ * @brief 密文所在的模数链层级
+ */
+int64_t FHEWrapper::ciphertext_level(const Ciphertext& ct) const {
+    if (scheme_ == FHE_SCHEME::BGV) {
+        return static_cast<int64_t>(ct.helib().getPrimeSet().card());
+    }
+    return static_cast<int64_t>(seal_context_->get_context_data(ct.seal().parms_id())->chain_index());
+}
+
+/**
+ * @brief 密文与明文槽向量原地相乘
+ */
+void FHEWrapper::multiply_plain_inplace(Ciphertext& ct, const std::vector<uint64_t>& slots, size_t worker) const {
+    if (scheme_ == FHE_SCHEME::BGV) {
+        helib::Ptxt<helib::BGV> ptxt = make_bgv_ptxt(*helib_context_, slots);
+        ct.helib() *= ptxt;
+    } else {
+        seal::Plaintext ptxt(seal_pool(worker));
+        seal_batch_encoder().encode(slots, ptxt);
+        seal_evaluator().multiply_plain_inplace(ct.seal(), ptxt, seal_pool(worker));
+    }
+}
+
+/**
+ * @brief 密文与明文槽向量原地相加
+ */
+void FHEWrapper::add_plain_inplace(Ciphertext& ct, const std::vector<uint64_t>& slots, size_t worker) const {
+    if (scheme_ == FHE_SCHEME::BGV) {
+        helib::Ptxt<helib::BGV> ptxt = make_bgv_ptxt(*helib_context_, slots);
+        ct.helib() += ptxt;
+    } else {
+        seal::Plaintext ptxt(seal_pool(worker));
+        seal_batch_encoder().encode(slots, ptxt);
+        seal_evaluator().add_plain_inplace(ct.seal(), ptxt);
+    }
+}
+
+/**
+ * @brief 密文模数切换：丢弃levels个模数
+ * @param ct 待切换的密文
+ * @param levels 丢弃的模数个数
+ * @param worker 工作者编号
+ * @throws std::invalid_argument 当模数链不足时抛出异常
+ */
+void FHEWrapper::mod_switch_down(Ciphertext& ct, uint32_t levels, size_t worker) const {
+    if (levels == 0) {
+        return;
+    }
+    YUS_INSTRUMENT_SCOPE(Stage::FHE_MOD_SWITCH);
+    if (scheme_ == FHE_SCHEME::BGV) {
+        auto& c = ct.helib();
+        helib::IndexSet primes = c.getPrimeSet() & helib_context_->getCtxtPrimes();
+        if (primes.card() <= static_cast<long>(levels)) {
+            throw std::invalid_argument("Modulus switching schedule exceeds the remaining primes");
+        }
+        for (uint32_t k = 0; k < levels; ++k) {
+            primes.remove(primes.last());
+        }
+        c.modDownToSet(primes);
+    } else {
+        auto& c = ct.seal();
+        if (seal_context_->get_context_data(c.parms_id())->chain_index() < levels) {
+            throw std::invalid_argument("Modulus switching schedule exceeds the remaining primes");
+        }
+        for (uint32_t k = 0; k < levels; ++k) {
+            seal_evaluator().mod_switch_to_next_inplace(c, seal_pool(worker));
+        }
+    }
+}
+
+/**
+ * @brief 由评估参数生成各块的随机数和块索引
+ * @param eval_params 评估参数
+ * @param capacity 最大块数
+ * @param rk_gens 输出的轮密钥生成器
+ * @return 各块的随机数和块索引
+ * @throws std::invalid_argument 当块数超过capacity时抛出异常
+ */
+std::vector<FHEWrapper::SlotBlock> FHEWrapper::make_slot_blocks(
+    const YuSEvalParams& eval_params, size_t capacity,
+    std::vector<std::unique_ptr<RoundKeyGenerator>>& rk_gens) const {
+    const uint32_t rounds = static_cast<uint32_t>(eval_params.level);
+    std::vector<SlotBlock> slot_blocks;
+    if (eval_params.segments.empty()) {
+        const size_t block_count = eval_params.block_count ? eval_params.block_count : capacity;
+        if (block_count > capacity) {
+            throw std::invalid_argument("Block count exceeds slot count");
+        }
+        rk_gens.push_back(std::make_unique<RoundKeyGenerator>(eval_params.nonce, rounds));
+        for (size_t j = 0; j < block_count; ++j) {
+            slot_blocks.push_back(SlotBlock{rk_gens.back().get(), eval_params.first_block + static_cast<uint32_t>(j)});
+        }
+    } else {
+        for (const auto& segment : eval_params.segments) {
+            if (slot_blocks.size() + segment.block_count > capacity) {
+                throw std::invalid_argument("Block count exceeds slot count");
+            }
+            rk_gens.push_back(std::make_unique<RoundKeyGenerator>(segment.nonce, rounds));
+            for (uint32_t j = 0; j < segment.block_count; ++j) {
+                slot_blocks.push_back(SlotBlock{rk_gens.back().get(), segment.first_block + j});
+            }
+        }
+    }
+    return slot_blocks;
+}
+
+/**
+ * @brief 生成一轮的行式打包轮常数
+ * @param slot_blocks 有效槽的随机数和块索引
+ * @param round 轮索引
+ * @return 36个槽向量
+ */
+std::vector<std::vector<uint64_t>> FHEWrapper::round_constant_slots(
+    const std::vector<SlotBlock>& slot_blocks, uint32_t round) const {
+    std::vector<std::vector<uint64_t>> rc(36, std::vector<uint64_t>(slot_count(), 0));
+    const size_t block_count = slot_blocks.size();
+
+    // 各块的XOF调用相互独立，按连续块区间分配给工作者
+    const size_t chunks = std::min(block_count, thread_pool_->size());
+    thread_pool_->parallel_for(chunks, [&](size_t c, size_t) {
+        const size_t begin = block_count * c / chunks;
+        const size_t end = block_count * (c + 1) / chunks;
+        for (size_t j = begin; j < end; ++j) {
+            auto block_rc = slot_blocks[j].rk_gen->generate_round_constant(round, slot_blocks[j].block,
+                                                                           params_.plain_modulus);
+            for (int i = 0; i < 36; ++i) {
+                rc[i][j] = to_u64(block_rc[i]);
+            }
+        }
+    });
+    return rc;
+}
+
+/**
+ * @brief 同态S盒层
+ * @param state 36个状态密文
+ * @param products 24个乘积临时密文
+ */
+void FHEWrapper::eval_sbox_layer(std::vector<Ciphertext>& state, std::vector<Ciphertext>& products,
+                                 TraceRecorder* trace) const {
+    YUS_INSTRUMENT_SCOPE(Stage::SBOX_LAYER);
+    products.resize(24);
+
+    // 12个S盒相互独立，在线程池上并行处理
+    thread_pool_->parallel_for(12, [&](size_t i, size_t worker) {
+        Ciphertext& x0 = state[3 * i];
+        Ciphertext& x1 = state[3 * i + 1];
+        Ciphertext& x2 = state[3 * i + 2];
+        Ciphertext& x0x2 = products[2 * i];
+        Ciphertext& x0x1 = products[2 * i + 1];
+        TraceSpan span(trace, "sbox", "sbox_layer", static_cast<uint32_t>(worker), static_cast<int64_t>(i),
+                       trace ? ciphertext_level(x0) : -1);
+
+        // 先计算两个乘积，再原地更新x1和x2
+        multiply(x0, x2, x0x2, worker, trace);
+        multiply(x0, x1, x0x1, worker, trace);
+
+        add_inplace(x1, x0x2);   // y1 = x0x2 + x1
+        add_inplace(x2, x0x2);   // y2 = x0x2 + x2 - x0x1
+        sub_inplace(x2, x0x1);
+    });
+}
+
+/**
+ * @brief 使用密钥乘积的第一轮同态S盒层
+ * @param state 白化后的36个状态密文
+ * @param cipher_key 与状态同层的加密主密钥
+ * @param key_products 与状态同层的24个加密密钥乘积
+ * @param cv 白化使用的计数器槽向量
+ * @param rc0 白化使用的第0轮轮常数槽向量
+ * @param products 24个乘积临时密文
+ * @param scratch 至少12个临时密文
+ */
+void FHEWrapper::eval_first_sbox_layer(std::vector<Ciphertext>& state, const std::vector<Ciphertext>& cipher_key,
+                                       const std::vector<Ciphertext>& key_products,
+                                       const std::vector<std::vector<uint64_t>>& cv,
+                                       const std::vector<std::vector<uint64_t>>& rc0,
+                                       std::vector<Ciphertext>& products,
+                                       std::vector<Ciphertext>& scratch,
+                                       TraceRecorder* trace) const {
+    YUS_INSTRUMENT_SCOPE(Stage::SBOX_LAYER);
+    products.resize(24);
+    const uint64_t p = to_u64(params_.plain_modulus);
+    const size_t nslots = slot_count();
+
+    thread_pool_->parallel_for(12, [&](size_t i, size_t worker) {
+        TraceSpan span(trace, "sbox", "sbox_layer", static_cast<uint32_t>(worker), static_cast<int64_t>(i),
+                       trace ? ciphertext_level(state[3 * i]) : -1);
+        Ciphertext& term = scratch[i];
+        std::vector<uint64_t> coeff(nslots);
+
+        // x_a·x_b的四项展开，结果写入products[idx]
+        auto affine_product = [&](size_t idx, size_t a, size_t b) {
+            Ciphertext& out = products[idx];
+
+            // (rc_a·rc_b)·E(k_a·k_b)
+            for (size_t j = 0; j < nslots; ++j) {
+                coeff[j] = mul_mod(rc0[a][j], rc0[b][j], p);
+            }
+            copy_ciphertext(out, key_products[idx], worker);
+            multiply_plain_inplace(out, coeff, worker);
+
+            // (cv_a·rc_b)·E(k_b) + (cv_b·rc_a)·E(k_a)，全零系数跳过以免得到透明密文
+            const size_t key_index[2] = {b, a};
+            const size_t cv_index[2] = {a, b};
+            for (int t = 0; t < 2; ++t) {
+                bool nonzero = false;
+                for (size_t j = 0; j < nslots; ++j) {
+                    coeff[j] = mul_mod(cv[cv_index[t]][j], rc0[key_index[t]][j], p);
+                    nonzero = nonzero || coeff[j] != 0;
+                }
+                if (nonzero) {
+                    copy_ciphertext(term, cipher_key[key_index[t]], worker);
+                    multiply_plain_inplace(term, coeff, worker);
+                    add_inplace(out, term);
+                }
+            }
+
+            // cv_a·cv_b
+            for (size_t j = 0; j < nslots; ++j) {
+                coeff[j] = mul_mod(cv[a][j], cv[b][j], p);
+            }
+            add_plain_inplace(out, coeff, worker);
+        };
+
+        const size_t base = 3 * i;
+        affine_product(2 * i, base, base + 2);       // x0·x2
+        affine_product(2 * i + 1, base, base + 1);   // x0·x1
+
+        Ciphertext& x1 = state[base + 1];
+        Ciphertext& x2 = state[base + 2];
+        add_inplace(x1, products[2 * i]);       // y1 = x0x2 + x1
+        add_inplace(x2, products[2 * i]);       // y2 = x0x2 + x2 - x0x1
+        sub_inplace(x2, products[2 * i + 1]);
+    });
+}
+
+/**
+ * @brief 同态线性层
+ * @param state 36个输入状态密文
+ * @param schedule 加法调度
+ * @param temps 部分和临时密文
+ * @param out 输出密文
+ * @throws std::runtime_error 当调度中存在空行时抛出异常
+ */
+void FHEWrapper::eval_linear_layer(const std::vector<Ciphertext>& state, const AdditionSchedule& schedule,
+                                   std::vector<Ciphertext>& temps, std::vector<Ciphertext>& out,
+                                   TraceRecorder* trace) const {
+    YUS_INSTRUMENT_SCOPE(Stage::LINEAR_LAYER);
+    auto reg = [&](uint32_t idx) -> const Ciphertext& {
+        return idx < 36 ? state[idx] : temps[idx - 36];
+    };
+    const int64_t level = trace ? ciphertext_level(state.front()) : -1;
+
+    if (temps.size() < schedule.num_registers - 36) {
+        temps.resize(schedule.num_registers - 36);
+    }
+
+    // 共享的分组部分和：依赖只存在于同一列分组内，按分组并行、组内按顺序构造
+    thread_pool_->parallel_for(9, [&](size_t group, size_t worker) {
+        TraceSpan span(trace, "partial_sums", "linear_layer", static_cast<uint32_t>(worker),
+                       static_cast<int64_t>(group), level);
+        for (const auto& step : schedule.partial_sums) {
+            if (step.group != group) {
+                continue;
+            }
+            Ciphertext& dst = temps[step.dst - 36];
+            copy_ciphertext(dst, reg(step.lhs), worker);
+            add_inplace(dst, reg(step.rhs));
+        }
+    });
+
+    // 按不相交的连续行分组并行累加分组部分和
+    const size_t num_rows = schedule.rows.size();
+    out.resize(num_rows);
+    const size_t chunks = std::min(num_rows, thread_pool_->size());
+    thread_pool_->parallel_for(chunks, [&](size_t c, size_t worker) {
+        TraceSpan span(trace, "row_chunk", "linear_layer", static_cast<uint32_t>(worker), static_cast<int64_t>(c),
+                       level);
+        for (size_t i = num_rows * c / chunks; i < num_rows * (c + 1) / chunks; ++i) {
+            const auto& row = schedule.rows[i];
+            if (row.empty()) {
+                throw std::runtime_error("Linear layer row " + std::to_string(schedule.first_row + i) + " is zero");
+            }
+            copy_ciphertext(out[i], reg(row[0]), worker);
+            for (size_t k = 1; k < row.size(); ++k) {
+                add_inplace(out[i], reg(row[k]));
+            }
+        }
+    });
+}
+
+/**
+ * @brief 同态轮密钥加：state_i += E(k_i) ⊙ rc_i
+ * @param state 36个状态密文
+ * @param cipher_key 加密的主密钥
+ * @param rc 行式打包的轮常数
+ * @param scratch 36个临时密文
+ */
+void FHEWrapper::eval_add_round_key(std::vector<Ciphertext>& state, const std::vector<Ciphertext>& cipher_key,
+                                    const std::vector<std::vector<uint64_t>>& rc,
+                                    std::vector<Ciphertext>& scratch) const {
+    scratch.resize(36);
+    thread_pool_->parallel_for(36, [&](size_t i, size_t worker) {
+        copy_ciphertext(scratch[i], cipher_key[i], worker);
+        multiply_plain_inplace(scratch[i], rc[i], worker);
+        add_inplace(state[i], scratch[i]);
+    });
+}
+
+/**
+ * @brief 同态评估YuS流密码
+ * @param cipher_key 加密的主密钥
+ * @param eval_params 随机数、轮数、截断和块范围
+ * @param cipher_keystream 输出的加密密钥流
+ * @return 评估时间（毫秒）
+ */
+double FHEWrapper::evaluate_yus(const std::vector<Ciphertext>& cipher_key,
+                                const YuSEvalParams& eval_params,
+                                std::vector<Ciphertext>& cipher_keystream) {
+    return evaluate_yus(cipher_key, {}, eval_params, cipher_keystream);
+}
+
+/**
+ * @brief 使用预计算密钥乘积同态评估YuS流密码
+ * @param cipher_key 加密的主密钥
+ * @param key_products 24个加密密钥乘积，可为空
+ * @param eval_params 随机数、轮数、截断和块范围
+ * @param cipher_keystream 输出的加密密钥流
+ * @return 评估时间（毫秒）
+ */
+double FHEWrapper::evaluate_yus(const std::vector<Ciphertext>& cipher_key,
+                                const std::vector<Ciphertext>& key_products,
+                                const YuSEvalParams& eval_params,
+                                std::vector<Ciphertext>& cipher_keystream) {
+    YuSEvalReport report;
+    return evaluate_yus(cipher_key, key_products, eval_params, cipher_keystream, report);
+}
+
+/**
+ * @brief 同态评估YuS流密码并输出评估报告
+ * @param cipher_key 加密的主密钥
+ * @param key_products 24个加密密钥乘积，可为空
+ * @param eval_params 随机数、轮数、截断、块范围和遥测选项
+ * @param cipher_keystream 输出的加密密钥流
+ * @param report 输出的评估报告
+ * @return 评估时间（毫秒）
+ * @throws std::invalid_argument 当密钥、密钥乘积或评估参数不正确时抛出异常
+ * @throws std::runtime_error 当噪声预算低于min_noise_budget时抛出异常
+ * 
+ * 行式打包下每个槽独立执行一个块的YuS计算：
+ * 1. 密钥白化：state_i = CV_i + rc^0_i ⊙ E(k_i)
+ * 2. r轮变换：S盒层、线性层、轮密钥加；提供密钥乘积时第一轮S盒不做密文乘法
+ * 3. 最终线性层只计算行trunc_m..35
+ * 
+ * 模数切换在白化后和每轮结束后按计划执行。轮密钥加使用与状态同层的密钥副本，
+ * 密钥副本随状态一起切换，因此SEAL中的加法两侧始终处于同一模数层。
+ * 
+ * 并行任务只写入各自独占的密文，共享的密钥、上下文和重线性化密钥只读。
+ * SEAL运算使用工作者独占的内存池；HElib依赖NTL_THREADS构建，不同Ctxt对象上的运算互不干扰。
+ */
+double FHEWrapper::evaluate_yus(const std::vector<Ciphertext>& cipher_key,
+                                const std::vector<Ciphertext>& key_products,
+                                const YuSEvalParams& eval_params,
+                                std::vector<Ciphertext>& cipher_keystream,
+                                YuSEvalReport& report) {
+    report = YuSEvalReport();
+    if (cipher_key.size() != 36) {
+        throw std::invalid_argument("Encrypted master key must be 36 ciphertexts");
+    }
+    if (!key_products.empty() && key_products.size() != 24) {
+        throw std::invalid_argument("Encrypted key products must be 24 ciphertexts");
+    }
+    if (eval_params.trunc_m >= 36) {
+        throw std::invalid_argument("Truncation m must be <36");
+    }
+    const size_t nslots = slot_count();
+    const uint32_t rounds = static_cast<uint32_t>(eval_params.level);
+
+    // 每个有效槽的随机数和块索引；合并评估时每段一个轮密钥生成器
+    std::vector<std::unique_ptr<RoundKeyGenerator>> rk_gens;
+    const std::vector<SlotBlock> slot_blocks = make_slot_blocks(eval_params, nslots, rk_gens);
+
+    const auto& schedule = eval_params.mod_switch_schedule;
+    const size_t total_drop = check_mod_switch_schedule(schedule, rounds, mod_switch_capacity());
+
+    const AdditionSchedule final_schedule = linear_layer_.addition_schedule(eval_params.trunc_m);
+
+    // 按电路的存活密文数预留对象：状态、线性层输出、乘积、部分和、输出，以及切换时的密钥副本
+    size_t live = 36 + 36 + 24 +
+                  std::max(linear_schedule_.num_registers, final_schedule.num_registers) - 36 +
+                  final_schedule.rows.size();
+    if (total_drop > 0) {
+        live += cipher_key.size() + key_products.size();
+    }
+    ciphertext_pool_->reserve(live);
+
+    Timer timer;
+    timer.start();
+    const auto start = std::chrono::steady_clock::now();
+    AllocCounts alloc_mark = alloc_counts();
+
+    std::vector<Ciphertext> state(36);
+    std::vector<Ciphertext> scratch(36);
+    std::vector<Ciphertext> products;
+    std::vector<Ciphertext> temps;
+
+    // 与状态同层的密钥和密钥乘积：未切换前直接引用调用方的密文，首次切换时才复制
+    std::vector<Ciphertext> level_key = cipher_key;
+    std::vector<Ciphertext> level_products = key_products;
+    bool owns_level_key = false;
+
+    // 把共享引用替换为私有副本后再切换，避免修改调用方的密文
+    auto switch_copy = [&](Ciphertext& level_ct, const Ciphertext& original,
+                           uint32_t levels, size_t worker) {
+        if (!owns_level_key) {
+            Ciphertext copy;
+            copy_ciphertext(copy, original, worker);
+            level_ct = copy;
+        }
+        mod_switch_down(level_ct, levels, worker);
+    };
+
+    // 第stage阶段结束后按计划丢弃模数；密钥乘积只在第一轮使用，只需跟随白化后的切换
+    auto switch_stage = [&](uint32_t stage) {
+        const uint32_t levels = stage < schedule.size() ? schedule[stage] : 0;
+        if (levels == 0) {
+            return;
+        }
+        thread_pool_->parallel_for(36, [&](size_t i, size_t worker) {
+            mod_switch_down(state[i], levels, worker);
+            switch_copy(level_key[i], cipher_key[i], levels, worker);
+            if (stage == 0 && i < level_products.size()) {
+                switch_copy(level_products[i], key_products[i], levels, worker);
+            }
+        });
+        owns_level_key = true;
+    };
+
+    // 密钥白化：CV_j = (1+j, 2+j, ..., 36+j)
+    std::vector<std::vector<uint64_t>> rc0;
+    std::vector<std::vector<uint64_t>> cv(36, std::vector<uint64_t>(nslots, 0));
+    const uint64_t p = to_u64(params_.plain_modulus);
+    TraceRecorder* trace = eval_params.trace;
+    {
+        TraceSpan span(trace, "whitening", "round", 0, 0, trace ? ciphertext_level(cipher_key.front()) : -1);
+        YUS_INSTRUMENT_SCOPE(Stage::WHITENING);
+        rc0 = round_constant_slots(slot_blocks, 0);
+        thread_pool_->parallel_for(36, [&](size_t i, size_t worker) {
+            for (size_t j = 0; j < slot_blocks.size(); ++j) {
+                cv[i][j] = (i + 1 + static_cast<uint64_t>(slot_blocks[j].block)) % p;
+            }
+            copy_ciphertext(state[i], cipher_key[i], worker);
+            multiply_plain_inplace(state[i], rc0[i], worker);
+            add_plain_inplace(state[i], cv[i], worker);
+        });
+    }
+    switch_stage(0);
+    record_noise_stage("whitening", state, eval_params, start, alloc_mark, report);
+
+    // 轮变换：RF = AK ∘ LP ∘ SL，线性层在state与scratch之间交替输出
+    for (uint32_t r = 1; r <= rounds; ++r) {
+        {
+            TraceSpan round_span(trace, "round", "round", 0, r, trace ? ciphertext_level(state.front()) : -1);
+            if (r == 1 && !level_products.empty()) {
+                eval_first_sbox_layer(state, level_key, level_products, cv, rc0, products, scratch, trace);
+            } else {
+                eval_sbox_layer(state, products, trace);
+            }
+            eval_linear_layer(state, linear_schedule_, temps, scratch, trace);
+            std::swap(state, scratch);
+
+            YUS_INSTRUMENT_SCOPE(Stage::ROUND_KEY);
+            auto rc = round_constant_slots(slot_blocks, r);
+            eval_add_round_key(state, level_key, rc, scratch);
+        }
+        switch_stage(r);
+        record_noise_stage("round " + std::to_string(r), state, eval_params, start, alloc_mark, report);
+    }
+
+    // 最终线性层+截断：被截断的行不参与计算
+    {
+        TraceSpan span(trace, "final_linear_layer", "round", 0, rounds + 1,
+                       trace ? ciphertext_level(state.front()) : -1);
+        eval_linear_layer(state, final_schedule, temps, cipher_keystream, trace);
+    }
+    record_noise_stage("final", cipher_keystream, eval_params, start, alloc_mark, report);
+
+    timer.stop();
+    report.eval_time_ms = timer.elapsed_ms();
+    return report.eval_time_ms;
+}
+
+/**
+ * @brief 记录一个阶段的噪声遥测
+ * @param stage 阶段名
+ * @param cts 该阶段的密文
+ * @param eval_params 遥测选项
+ * @param start 评估开始时间
+ * @param alloc_mark 上一阶段结束时的分配计数
+ * @param report 评估报告
+ * @throws std::runtime_error 当噪声预算低于min_noise_budget时抛出异常
+ * 
+ * 同一阶段各密文的噪声预算并行测量，记录最小值。
+ * 分配计数在噪声测量之前取差，测量之后重新取基准，记录本身和解密的分配不计入任何阶段。
+ */
+void FHEWrapper::record_noise_stage(const std::string& stage, const std::vector<Ciphertext>& cts,
+                                    const YuSEvalParams& eval_params,
+                                    std::chrono::steady_clock::time_point start,
+                                    AllocCounts& alloc_mark, YuSEvalReport& report) const {
+    if (alloc_tracking_enabled()) {
+        report.alloc_stages.push_back({stage, alloc_counts() - alloc_mark});
+        alloc_mark = alloc_counts();
+    }
+    if (!eval_params.noise_telemetry && eval_params.min_noise_budget <= 0) {
+        return;
+    }
+
+    std::vector<double> budgets(cts.size());
+    thread_pool_->parallel_for(cts.size(), [&](size_t i, size_t) {
+        budgets[i] = noise_budget(cts[i]);
+    });
+
+    NoiseStage entry;
+    entry.stage = stage;
+    entry.noise_budget_bits = *std::min_element(budgets.begin(), budgets.end());
+    entry.modulus_bits = modulus_bits(cts.front());
+    entry.elapsed_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    report.stages.push_back(entry);
+    if (alloc_tracking_enabled()) {
+        alloc_mark = alloc_counts();
+    }
+
+    if (entry.noise_budget_bits < eval_params.min_noise_budget) {
+        throw std::runtime_error("Noise budget " + std::to_string(entry.noise_budget_bits) +
+                                 " bits after " + stage + " is below the threshold of " +
+                                 std::to_string(eval_params.min_noise_budget) + " bits");
+    }
+}
+
+/**
+ * @brief 生成列式打包线性层所需的伽罗瓦密钥
+ * @throws std::invalid_argument 当方案为BGV时抛出异常
+ * @throws std::runtime_error 当未持有私钥时抛出异常
+ */
+void FHEWrapper::generate_column_galois_keys() {
+    if (scheme_ == FHE_SCHEME::BGV) {
+        throw std::invalid_argument("Column-wise packing is only supported for BFV");
+    }
+    if (!seal_seckey_) {
+        throw std::runtime_error("Galois key generation requires the secret key");
+    }
+    seal::KeyGenerator keygen(*seal_context_, *seal_seckey_);
+    auto galois_keys = std::make_unique<seal::GaloisKeys>();
+    keygen.create_galois_keys(column_rotation_steps(), *galois_keys);
+    seal_galois_keys_ = std::move(galois_keys);
+}
+
+/**
+ * @brief 是否持有列式打包所需的伽罗瓦密钥
+ */
+bool FHEWrapper::has_column_galois_keys() const {
+    return static_cast<bool>(seal_galois_keys_);
+}
+
+/**
+ * @brief 列式打包下每块占用的槽数
+ * @param level 安全级别
+ * @return 不小于12 + 11·(rounds+1)的最小的12的倍数
+ */
+size_t FHEWrapper::column_region_size(SecurityLevel level) const {
+    const size_t layers = static_cast<size_t>(level) + 1;
+    return (12 + 11 * layers + 11) / 12 * 12;
+}
+
+/**
+ * @brief 列式打包下单次评估可覆盖的最大块数
+ * @param level 安全级别
+ * @return 两个SEAL槽行中可容纳的槽区间总数
+ */
+size_t FHEWrapper::column_block_capacity(SecurityLevel level) const {
+    if (scheme_ == FHE_SCHEME::BGV) {
+        return 0;
+    }
+    return 2 * ((slot_count() / 2) / column_region_size(level));
+}
+
+/**
+ * @brief 列式打包下第j块的槽区间起点
+ * @param j 块序号
+ * @param region 每块占用的槽数
+ * 
+ * 旋转只在SEAL的行内循环，槽区间不跨行；区间起点在行内是12的倍数，与密钥和对角线的周期对齐。
+ */
+size_t FHEWrapper::column_slot(size_t j, size_t region) const {
+    const size_t row = slot_count() / 2;
+    const size_t per_row = row / region;
+    return (j / per_row) * row + (j % per_row) * region;
+}
+
+/**
+ * @brief 把每块的36个值按列式打包展开为3个槽向量
+ * @param values 各块的36个值
+ * @param region 每块占用的槽数
+ * @return 3个槽向量
+ */
+std::vector<std::vector<uint64_t>> FHEWrapper::column_slots(const std::vector<std::vector<uint64_t>>& values,
+                                                            size_t region) const {
+    std::vector<std::vector<uint64_t>> slots(3, std::vector<uint64_t>(slot_count(), 0));
+    for (size_t j = 0; j < values.size(); ++j) {
+        const size_t base = column_slot(j, region);
+        for (size_t q = 0; q < region; ++q) {
+            for (size_t t = 0; t < 3; ++t) {
+                slots[t][base + q] = values[j][3 * (q % 12) + t];
+            }
+        }
+    }
+    return slots;
+}
+
+/**
+ * @brief 编码列式线性层的预旋转对角明文
+ * @return 108个明文，全零对角为零明文
+ * 
+ * 输出t'、输入t、大步g、小步b的对角明文在行内槽i处为M[3((i-4g) mod 12)+t'][3((i+b) mod 12)+t]，
+ * 即对角线d = 4g+b右旋4g步，使大步旋转可以提到对输入t和小步b的求和之外。
+ */
+const std::vector<seal::Plaintext>& FHEWrapper::column_diagonals() const {
+    std::call_once(column_diagonals_once_, [this] {
+        const auto& matrix = linear_layer_.matrix();
+        const size_t nslots = slot_count();
+        const size_t row = nslots / 2;
+        const size_t count = 9 * kColumnGiantSteps * kColumnBabySteps;
+        column_diagonals_.assign(count, seal::Plaintext());
+        thread_pool_->parallel_for(count, [&](size_t k, size_t worker) {
+            const size_t b = k % kColumnBabySteps;
+            const size_t g = k / kColumnBabySteps % kColumnGiantSteps;
+            const size_t t = k / (kColumnBabySteps * kColumnGiantSteps) % 3;
+            const size_t t_out = k / (3 * kColumnBabySteps * kColumnGiantSteps);
+            std::vector<uint64_t> slots(nslots);
+            for (size_t j = 0; j < nslots; ++j) {
+                const size_t i = j % row;
+                const size_t s_out = (i + 12 - kColumnBabySteps * g % 12) % 12;
+                const size_t s_in = (i + b) % 12;
+                slots[j] = matrix[3 * s_out + t_out][3 * s_in + t];
+            }
+            column_diagonals_[k] = seal::Plaintext(seal_pool(worker));
+            seal_batch_encoder().encode(slots, column_diagonals_[k]);
+        });
+    });
+    return column_diagonals_;
+}
+
+/**
+ * @brief 列式打包的同态线性层
+ * @param state 3个输入密文
+ * @param temps 27个临时密文
+ * @param out 3个输出密文
+ * @throws std::runtime_error 当某个输出没有非零对角线时抛出异常
+ * 
+ * 每层9次小步旋转和至多6次大步旋转；全零的对角线跳过，不做明文乘法。
+ * 小步旋转、9个部分和（含其大步旋转）和3个输出各自并行。
+ */
+void FHEWrapper::eval_column_linear_layer(const std::vector<Ciphertext>& state, std::vector<Ciphertext>& temps,
+                                          std::vector<Ciphertext>& out, TraceRecorder* trace) const {
+    YUS_INSTRUMENT_SCOPE(Stage::LINEAR_LAYER);
+    const auto& diagonals = column_diagonals();
+    const int64_t level = trace ? ciphertext_level(state.front()) : -1;
+    const size_t baby = kColumnBabySteps - 1;
+    const size_t partial_count = 3 * kColumnGiantSteps;
+    temps.resize(3 * baby + 2 * partial_count);
+    out.resize(3);
+    Ciphertext* rotated = temps.data();
+    Ciphertext* partials = rotated + 3 * baby;
+    Ciphertext* terms = partials + partial_count;
+
+    // 小步旋转：rotated[t·3+b-1] = rot_b(in_t)
+    thread_pool_->parallel_for(3 * baby, [&](size_t k, size_t worker) {
+        TraceSpan span(trace, "baby_step_rotate", "linear_layer", static_cast<uint32_t>(worker),
+                       static_cast<int64_t>(k), level);
+        copy_ciphertext(rotated[k], state[k / baby], worker);
+        YUS_INSTRUMENT_SCOPE(Stage::FHE_ROTATE);
+        seal_evaluator().rotate_rows_inplace(rotated[k].seal(), static_cast<int>(k % baby + 1),
+                                             *seal_galois_keys_, seal_pool(worker));
+    });
+
+    // 部分和：partials[t'·3+g] = rot_{4g}(Σ_{t,b} diag' ⊙ rot_b(in_t))
+    std::vector<char> has_partial(partial_count, 0);
+    thread_pool_->parallel_for(partial_count, [&](size_t k, size_t worker) {
+        TraceSpan span(trace, "partial_sums", "linear_layer", static_cast<uint32_t>(worker),
+                       static_cast<int64_t>(k), level);
+        const size_t t_out = k / kColumnGiantSteps;
+        const size_t g = k % kColumnGiantSteps;
+        for (size_t t = 0; t < 3; ++t) {
+            for (size_t b = 0; b < static_cast<size_t>(kColumnBabySteps); ++b) {
+                const auto& diagonal = diagonals[((t_out * 3 + t) * kColumnGiantSteps + g) * kColumnBabySteps + b];
+                if (diagonal.is_zero()) {
+                    continue;
+                }
+                const Ciphertext& input = b == 0 ? state[t] : rotated[t * baby + b - 1];
+                Ciphertext& dst = has_partial[k] ? terms[k] : partials[k];
+                copy_ciphertext(dst, input, worker);
+                seal_evaluator().multiply_plain_inplace(dst.seal(), diagonal, seal_pool(worker));
+                if (has_partial[k]) {
+                    add_inplace(partials[k], terms[k]);
+                }
+                has_partial[k] = 1;
+            }
+        }
+        if (has_partial[k] && g > 0) {
+            YUS_INSTRUMENT_SCOPE(Stage::FHE_ROTATE);
+            seal_evaluator().rotate_rows_inplace(partials[k].seal(), static_cast<int>(kColumnBabySteps * g),
+                                                 *seal_galois_keys_, seal_pool(worker));
+        }
+    });
+
+    thread_pool_->parallel_for(3, [&](size_t t_out, size_t worker) {
+        bool first = true;
+        for (size_t g = 0; g < static_cast<size_t>(kColumnGiantSteps); ++g) {
+            const size_t k = t_out * kColumnGiantSteps + g;
+            if (!has_partial[k]) {
+                continue;
+            }
+            if (first) {
+                copy_ciphertext(out[t_out], partials[k], worker);
+                first = false;
+            } else {
+                add_inplace(out[t_out], partials[k]);
+            }
+        }
+        if (first) {
+            throw std::runtime_error("Linear layer output lane " + std::to_string(t_out) + " has no diagonals");
+        }
+    });
+}
+
+/**
+ * @brief 按列式打包加密YuS主密钥
+ * @param master_key 36个F_p元素的主密钥
+ * @param cipher_key 输出3个密文
+ * @throws std::invalid_argument 当主密钥大小不正确或方案为BGV时抛出异常
+ * 
+ * 密钥在所有槽上按行内12周期重复，与块所在的槽区间无关，任意块范围都可以复用。
+ */
+void FHEWrapper::encrypt_key_columnwise(const std::vector<mpz_class>& master_key,
+                                        std::vector<Ciphertext>& cipher_key) {
+    if (scheme_ == FHE_SCHEME::BGV) {
+        throw std::invalid_argument("Column-wise packing is only supported for BFV");
+    }
+    if (master_key.size() != 36) {
+        throw std::invalid_argument("Master key must be 36 elements (F_p^36)");
+    }
+    const size_t nslots = slot_count();
+    const size_t row = nslots / 2;
+
+    cipher_key.clear();
+    for (size_t t = 0; t < 3; ++t) {
+        std::vector<uint64_t> slots(nslots);
+        for (size_t j = 0; j < nslots; ++j) {
+            slots[j] = to_u64(mod(master_key[3 * (j % row % 12) + t], params_.plain_modulus));
+        }
+        cipher_key.push_back(encrypt_slots(slots));
+    }
+}
+
+/**
+ * @brief 列式打包同态评估YuS流密码
+ * @param cipher_key 列式加密的主密钥
+ * @param eval_params 随机数、轮数、块范围、模数切换和遥测选项
+ * @param cipher_keystream 输出3个密文
+ * @param report 输出的评估报告
+ * @return 评估时间（毫秒）
+ * @throws std::invalid_argument 当方案为BGV、密钥大小或评估参数不正确时抛出异常
+ * @throws std::runtime_error 当未生成伽罗瓦密钥或噪声预算低于min_noise_budget时抛出异常
+ * 
+ * 每块占用一个槽区间，区间内第q个槽保存S盒q mod 12的x0、x1、x2（分别在3个密文中）。
+ * 白化、S盒和轮密钥加都是逐槽运算，与行式打包相同；只有线性层需要槽旋转。
+ * 每层旋转使区间的有效前缀缩短11个槽，区间大小保证最终层后前12个槽仍然有效。
+ */
+double FHEWrapper::evaluate_yus_columnwise(const std::vector<Ciphertext>& cipher_key,
+                                           const YuSEvalParams& eval_params,
+                                           std::vector<Ciphertext>& cipher_keystream,
+                                           YuSEvalReport& report) {
+    report = YuSEvalReport();
+    if (scheme_ == FHE_SCHEME::BGV) {
+        throw std::invalid_argument("Column-wise packing is only supported for BFV");
+    }
+    if (!seal_galois_keys_) {
+        throw std::runtime_error("Column-wise evaluation requires generate_column_galois_keys()");
+    }
+    if (cipher_key.size() != 3) {
+        throw std::invalid_argument("Column-wise encrypted master key must be 3 ciphertexts");
+    }
+    if (eval_params.trunc_m >= 36) {
+        throw std::invalid_argument("Truncation m must be <36");
+    }
+    const uint32_t rounds = static_cast<uint32_t>(eval_params.level);
+    const size_t region = column_region_size(eval_params.level);
+
+    std::vector<std::unique_ptr<RoundKeyGenerator>> rk_gens;
+    const std::vector<SlotBlock> slot_blocks =
+        make_slot_blocks(eval_params, column_block_capacity(eval_params.level), rk_gens);
+    const auto& schedule = eval_params.mod_switch_schedule;
+    const size_t total_drop = check_mod_switch_schedule(schedule, rounds, mod_switch_capacity());
+
+    // 状态、线性层输出、2个乘积、线性层临时密文，以及切换时的密钥副本
+    ciphertext_pool_->reserve(3 + 3 + 2 + 27 + (total_drop > 0 ? 3 : 0));
+
+    const uint64_t p = to_u64(params_.plain_modulus);
+    auto column_round_constants = [&](uint32_t round) {
+        std::vector<std::vector<uint64_t>> values(slot_blocks.size(), std::vector<uint64_t>(36));
+        thread_pool_->parallel_for(slot_blocks.size(), [&](size_t j, size_t) {
+            auto block_rc = slot_blocks[j].rk_gen->generate_round_constant(round, slot_blocks[j].block,
+                                                                           params_.plain_modulus);
+            for (size_t i = 0; i < 36; ++i) {
+                values[j][i] = to_u64(block_rc[i]);
+            }
+        });
+        return column_slots(values, region);
+    };
+
+    Timer timer;
+    timer.start();
+    const auto start = std::chrono::steady_clock::now();
+    AllocCounts alloc_mark = alloc_counts();
+
+    std::vector<Ciphertext> state(3);
+    std::vector<Ciphertext> scratch(3);
+    std::vector<Ciphertext> products(2);
+    std::vector<Ciphertext> temps;
+
+    std::vector<Ciphertext> level_key = cipher_key;
+    bool owns_level_key = false;
+    auto switch_stage = [&](uint32_t stage) {
+        const uint32_t levels = stage < schedule.size() ? schedule[stage] : 0;
+        if (levels == 0) {
+            return;
+        }
+        thread_pool_->parallel_for(3, [&](size_t t, size_t worker) {
+            mod_switch_down(state[t], levels, worker);
+            if (!owns_level_key) {
+                Ciphertext copy;
+                copy_ciphertext(copy, cipher_key[t], worker);
+                level_key[t] = copy;
+            }
+            mod_switch_down(level_key[t], levels, worker);
+        });
+        owns_level_key = true;
+    };
+
+    // 密钥白化：state_t = CV_t + rc^0_t ⊙ E(k_t)
+    std::vector<std::vector<uint64_t>> cv_values(slot_blocks.size(), std::vector<uint64_t>(36));
+    for (size_t j = 0; j < slot_blocks.size(); ++j) {
+        for (size_t i = 0; i < 36; ++i) {
+            cv_values[j][i] = (i + 1 + static_cast<uint64_t>(slot_blocks[j].block)) % p;
+        }
+    }
+    TraceRecorder* trace = eval_params.trace;
+    {
+        TraceSpan span(trace, "whitening", "round", 0, 0, trace ? ciphertext_level(cipher_key.front()) : -1);
+        YUS_INSTRUMENT_SCOPE(Stage::WHITENING);
+        const auto cv = column_slots(cv_values, region);
+        const auto rc0 = column_round_constants(0);
+        thread_pool_->parallel_for(3, [&](size_t t, size_t worker) {
+            copy_ciphertext(state[t], cipher_key[t], worker);
+            multiply_plain_inplace(state[t], rc0[t], worker);
+            add_plain_inplace(state[t], cv[t], worker);
+        });
+    }
+    switch_stage(0);
+    record_noise_stage("whitening", state, eval_params, start, alloc_mark, report);
+
+    for (uint32_t r = 1; r <= rounds; ++r) {
+        {
+            TraceSpan round_span(trace, "round", "round", 0, r, trace ? ciphertext_level(state.front()) : -1);
+
+            // S盒层：12个S盒共用2次密文乘法，y1 = x1 + x0x2，y2 = x2 + x0x2 - x0x1
+            {
+                YUS_INSTRUMENT_SCOPE(Stage::SBOX_LAYER);
+                thread_pool_->parallel_for(2, [&](size_t k, size_t worker) {
+                    TraceSpan span(trace, "sbox", "sbox_layer", static_cast<uint32_t>(worker),
+                                   static_cast<int64_t>(k), trace ? ciphertext_level(state[0]) : -1);
+                    multiply(state[0], state[k == 0 ? 2 : 1], products[k], worker, trace);
+                });
+                thread_pool_->parallel_for(2, [&](size_t k, size_t) {
+                    if (k == 0) {
+                        add_inplace(state[1], products[0]);
+                    } else {
+                        add_inplace(state[2], products[0]);
+                        sub_inplace(state[2], products[1]);
+                    }
+                });
+            }
+
+            eval_column_linear_layer(state, temps, scratch, trace);
+            std::swap(state, scratch);
+
+            // 轮密钥加：scratch保存上一层的输入，已不再使用
+            {
+                YUS_INSTRUMENT_SCOPE(Stage::ROUND_KEY);
+                const auto rc = column_round_constants(r);
+                thread_pool_->parallel_for(3, [&](size_t t, size_t worker) {
+                    copy_ciphertext(scratch[t], level_key[t], worker);
+                    multiply_plain_inplace(scratch[t], rc[t], worker);
+                    add_inplace(state[t], scratch[t]);
+                });
+            }
+        }
+        switch_stage(r);
+        record_noise_stage("round " + std::to_string(r), state, eval_params, start, alloc_mark, report);
+    }
+
+    {
+        TraceSpan span(trace, "final_linear_layer", "round", 0, rounds + 1,
+                       trace ? ciphertext_level(state.front()) : -1);
+        eval_column_linear_layer(state, temps, cipher_keystream, trace);
+    }
+    record_noise_stage("final", cipher_keystream, eval_params, start, alloc_mark, report);
+
+    timer.stop();
+    report.eval_time_ms = timer.elapsed_ms();
+    return report.eval_time_ms;
+}
+
+/**
+ * @brief 解密列式打包的密钥流
+ * @param cipher_keystream evaluate_yus_columnwise输出的3个密文
+ * @param level 评估使用的安全级别
+ * @param trunc_m 截断位数
+ * @param block_count 块数量
+ * @return 按块顺序排列的密钥流
+ * @throws std::invalid_argument 当密文数量、截断位数或块数不正确时抛出异常
+ * @throws std::runtime_error 当未持有私钥时抛出异常
+ */
+std::vector<mpz_class> FHEWrapper::decrypt_columnwise(const std::vector<Ciphertext>& cipher_keystream,
+                                                      SecurityLevel level, uint32_t trunc_m,
+                                                      size_t block_count) const {
+    if (cipher_keystream.size() != 3) {
+        throw std::invalid_argument("Column-wise keystream must be 3 ciphertexts");
+    }
+    if (trunc_m >= 36) {
+        throw std::invalid_argument("Truncation m must be <36");
+    }
+    if (block_count > column_block_capacity(level)) {
+        throw std::invalid_argument("Block count exceeds column-wise capacity");
+    }
+    const size_t nslots = slot_count();
+    const size_t region = column_region_size(level);
+    const auto slots = decrypt(cipher_keystream);
+
+    std::vector<mpz_class> keystream;
+    keystream.reserve(block_count * (36 - trunc_m));
+    for (size_t j = 0; j < block_count; ++j) {
+        const size_t base = column_slot(j, region);
+        for (size_t i = trunc_m; i < 36; ++i) {
+            keystream.push_back(slots[(i % 3) * nslots + base + i / 3]);
+        }
+    }
+    return keystream;
+}
+
+/**
+ * @brief 获取密文的剩余噪声预算
+ * @param ct 密文
+ * @return 剩余噪声预算（比特）
+ */
+double FHEWrapper::noise_budget(const Ciphertext& ct) const {
+    if (scheme_ == FHE_SCHEME::BGV) {
+        return ct.helib().capacity();
+    }
+    return static_cast<double>(
+        seal_decryptor().invariant_noise_budget(ct.seal()));
+}
+
+/**
+ * @brief 获取密文当前模数的位数
+ * @param ct 密文
+ * @return 模数位数
+ */
+double FHEWrapper::modulus_bits(const Ciphertext& ct) const {
+    if (scheme_ == FHE_SCHEME::BGV) {
+        return ct.helib().logOfPrimeSet() / std::log(2.0);
+    }
+    const auto& c = ct.seal();
+    return static_cast<double>(seal_context_->get_context_data(c.parms_id())->total_coeff_modulus_bit_count());
+}
+
+/**
+ * @brief 在线转密：从对称密文中剥离加密密钥流
+ * @param cipher_keystream 加密密钥流
+ * @param sym_ct 按块顺序排列的对称密文
+ * @param block_count 块数量
+ * @param cipher_data 输出的加密明文
+ * @return 转密时间（毫秒）
+ * @throws std::invalid_argument 当密钥流为空或块数量超过槽数量时抛出异常
+ * 
+ * 输出密文先复制密钥流再原地更新，缓存中的密钥流保持不变，可被并发的查询共享。
+ * 超出block_count的槽对应未使用的密钥流，其内容为-z，调用方应忽略。
+ */
+double FHEWrapper::strip_keystream(const std::vector<Ciphertext>& cipher_keystream,
+                                   const uint64_t* sym_ct, size_t block_count,
+                                   std::vector<Ciphertext>& cipher_data) const {
+    if (cipher_keystream.empty()) {
+        throw std::invalid_argument("Encrypted keystream is empty");
+    }
+    const size_t nslots = slot_count();
+    if (block_count > nslots) {
+        throw std::invalid_argument("Block count exceeds slot count");
+    }
+    const size_t width = cipher_keystream.size();
+    const uint64_t p = to_u64(params_.plain_modulus);
+
+    Timer timer;
+    timer.start();
+
+    cipher_data.assign(width, Ciphertext());
+    thread_pool_->parallel_for(width, [&](size_t i, size_t worker) {
+        std::vector<uint64_t> slots(nslots, 0);
+        for (size_t j = 0; j < block_count; ++j) {
+            slots[j] = sym_ct[j * width + i] % p;
+        }
+        // E(m_i) = c_i - E(z_i)
+        copy_ciphertext(cipher_data[i], cipher_keystream[i], worker);
+        negate_inplace(cipher_data[i]);
+        add_plain_inplace(cipher_data[i], slots, worker);
+    });
+
+    timer.stop();
+    return timer.elapsed_ms();
+}
+
+/**
+ * @brief 获取密文在内存中占用的字节数
+ * @param ct 密文
+ * @return 多项式系数占用的字节数
+ * 
+ * HElib不公开密文部件数，这里按重线性化后的2个部件计算。
+ */
+size_t FHEWrapper::ciphertext_bytes(const Ciphertext& ct) const {
+    if (scheme_ == FHE_SCHEME::BGV) {
+        const auto& c = ct.helib();
+        return 2 * static_cast<size_t>(helib_context_->getPhiM()) *
+               static_cast<size_t>(c.getPrimeSet().card()) * sizeof(uint64_t);
+    }
+    const auto& c = ct.seal();
+    return c.size() * c.poly_modulus_degree() * c.coeff_modulus_size() * sizeof(uint64_t);
+}
+
+/**
+ * @brief 单个密文序列化帧的最大字节数
+ * @return 模数链全部素数（含特殊素数）上3个多项式的未压缩大小，加上元数据和压缩膨胀的余量
+ */
+uint64_t FHEWrapper::max_ciphertext_frame_bytes() const {
+    uint64_t coeffs = 0;
+    if (scheme_ == FHE_SCHEME::BGV) {
+        coeffs = static_cast<uint64_t>(helib_context_->getPhiM()) *
+                 static_cast<uint64_t>(helib_context_->getCtxtPrimes().card() +
+                                       helib_context_->getSpecialPrimes().card());
+    } else {
+        const auto& parms = seal_context_->key_context_data()->parms();
+        coeffs = static_cast<uint64_t>(parms.poly_modulus_degree()) * parms.coeff_modulus().size();
+    }
+    const uint64_t raw = kMaxCiphertextParts * coeffs * sizeof(uint64_t);
+    return raw + raw / 64 + kFrameSlackBytes;
+}
+
+/**
+ * @brief 序列化密文向量到流
+ * @param cts 密文向量
+ * @param out 输出流
+ * @param compress 是否压缩
+ * @return 未压缩和实际写出的字节数
+ * @throws std::runtime_error 当写入失败时抛出异常
+ * 
+ * 各密文在线程池上并行序列化和压缩到独立的内存缓冲区，再按顺序写出。
+ */
+SerializedSize FHEWrapper::save_ciphertexts(const std::vector<Ciphertext>& cts, std::ostream& out,
+                                            bool compress) const {
+    std::vector<std::string> frames(cts.size());
+    std::vector<uint64_t> raw_bytes(cts.size());
+    thread_pool_->parallel_for(cts.size(), [&](size_t i, size_t) {
+        std::ostringstream frame(std::ios::binary);
+        if (scheme_ == FHE_SCHEME::BGV) {
+            raw_bytes[i] = save_framed([&](std::ostream& s) { cts[i].helib().writeTo(s); }, frame, compress).raw_bytes;
+        } else {
+            const auto& c = cts[i].seal();
+            raw_bytes[i] = static_cast<uint64_t>(c.save_size(seal::compr_mode_type::none));
+            c.save(frame, compr_mode(compress));
+        }
+        frames[i] = frame.str();
+    });
+    return write_container(out, scheme_, frames, raw_bytes);
+}
+
+/**
+ * @brief 序列化密文向量到内存缓冲区
+ * @param cts 密文向量
+ * @param buffer 输出缓冲区
+ * @param compress 是否压缩
+ * @return 未压缩和实际写出的字节数
+ */
+SerializedSize FHEWrapper::save_ciphertexts(const std::vector<Ciphertext>& cts, std::vector<uint8_t>& buffer,
+                                            bool compress) const {
+    std::ostringstream out(std::ios::binary);
+    SerializedSize size = save_ciphertexts(cts, out, compress);
+    const std::string bytes = out.str();
+    buffer.assign(bytes.begin(), bytes.end());
+    return size;
+}
+
+/**
+ * @brief 从流反序列化密文向量
+ * @param in 输入流
+ * @param cts 输出密文向量
+ * @throws std::runtime_error 当数据格式错误、方案不匹配或帧长超出上限时抛出异常
+ * 
+ * 按帧头中的长度顺序读出各帧，再在线程池上并行解压和反序列化。
+ * 数据可能来自不可信的客户端，密文数和帧长在分配之前检查：可定位的流不能超过剩余字节数，
+ * 帧长还不能超过max_ciphertext_frame_bytes()。
+ */
+void FHEWrapper::load_ciphertexts(std::istream& in, std::vector<Ciphertext>& cts) const {
+    char magic[sizeof(kCiphertextMagic)] = {0};
+    in.read(magic, sizeof(magic));
+    const int format = in.get();
+    const int scheme = in.get();
+    const uint64_t count = read_u64(in);
+    if (!in || std::memcmp(magic, kCiphertextMagic, sizeof(magic)) != 0 || format != kCiphertextFormat) {
+        throw std::runtime_error("Not a serialized YuS ciphertext container");
+    }
+    if (scheme != static_cast<int>(scheme_)) {
+        throw std::runtime_error("Serialized ciphertexts belong to a different FHE scheme");
+    }
+
+    // 不可定位的流（如管道）只受帧长上限约束，截断时在读取处失败
+    uint64_t remaining = std::numeric_limits<uint64_t>::max();
+    const std::streampos start = in.tellg();
+    if (start != std::streampos(-1)) {
+        in.seekg(0, std::ios::end);
+        const std::streampos end = in.tellg();
+        in.seekg(start);
+        if (!in || end == std::streampos(-1)) {
+            throw std::runtime_error("Cannot determine the size of the ciphertext container");
+        }
+        remaining = static_cast<uint64_t>(end - start);
+    }
+    const uint64_t header_bytes = seal::Serialization::seal_header_size;
+    if (count > remaining / header_bytes) {
+        throw std::runtime_error("Ciphertext count " + std::to_string(count) + " exceeds the container size");
+    }
+    const uint64_t max_frame = max_ciphertext_frame_bytes();
+
+    std::vector<std::string> frames;
+    for (uint64_t i = 0; i < count; ++i) {
+        std::string frame(seal::Serialization::seal_header_size, '\0');
+        in.read(&frame[0], static_cast<std::streamsize>(frame.size()));
+        seal::Serialization::SEALHeader header;
+        if (in) {
+            seal::Serialization::LoadHeader(reinterpret_cast<const seal::seal_byte*>(frame.data()),
+                                            frame.size(), header, false);
+        }
+        if (!in || !seal::Serialization::IsValidHeader(header) || header.size < frame.size()) {
+            throw std::runtime_error("Corrupted ciphertext frame " + std::to_string(i));
+        }
+        remaining -= header_bytes;
+        if (header.size > max_frame || header.size - header_bytes > remaining) {
+            throw std::runtime_error("Ciphertext frame " + std::to_string(i) + " claims " +
+                                     std::to_string(header.size) + " bytes, more than the container or context allows");
+        }
+        remaining -= header.size - header_bytes;
+        frame.resize(static_cast<size_t>(header.size));
+        in.read(&frame[seal::Serialization::seal_header_size],
+                static_cast<std::streamsize>(header.size - seal::Serialization::seal_header_size));
+        if (!in) {
+            throw std::runtime_error("Truncated ciphertext frame " + std::to_string(i));
+        }
+        frames.push_back(std::move(frame));
+    }
+
+    cts.assign(frames.size(), Ciphertext());
+    thread_pool_->parallel_for(frames.size(), [&](size_t i, size_t worker) {
+        cts[i] = ciphertext_pool_->acquire(worker);
+        if (scheme_ == FHE_SCHEME::BGV) {
+            load_framed([&](std::istream& s) { cts[i].helib().read(s); }, frames[i]);
+        } else {
+            cts[i].seal().load(*seal_context_, reinterpret_cast<const seal::seal_byte*>(frames[i].data()),
+                               frames[i].size());
+        }
+    });
+}
+
+/**
+ * @brief 从内存缓冲区反序列化密文向量
+ * @param data 缓冲区首地址
+ * @param size 缓冲区字节数
+ * @param cts 输出密文向量
+ */
+void FHEWrapper::load_ciphertexts(const uint8_t* data, size_t size, std::vector<Ciphertext>& cts) const {
+    std::istringstream in(std::string(reinterpret_cast<const char*>(data), size), std::ios::binary);
+    load_ciphertexts(in, cts);
+}
+
+/**
+ * @brief 序列化公钥
+ * @param out 输出流
+ * @param compress 是否压缩
+ * @return 未压缩和实际写出的字节数
+ */
+SerializedSize FHEWrapper::save_public_key(std::ostream& out, bool compress) const {
+    if (scheme_ == FHE_SCHEME::BGV) {
+        return save_framed([&](std::ostream& s) { helib_pubkey_->writeTo(s); }, out, compress);
+    }
+    SerializedSize size;
+    size.raw_bytes = static_cast<uint64_t>(seal_pubkey_->save_size(seal::compr_mode_type::none));
+    size.stored_bytes = static_cast<uint64_t>(seal_pubkey_->save(out, compr_mode(compress)));
+    return size;
+}
+
+/**
+ * @brief 序列化重线性化密钥
+ * @param out 输出流
+ * @param compress 是否压缩
+ * @return 未压缩和实际写出的字节数
+ * @throws std::invalid_argument 当方案为BGV时抛出异常
+ */
+SerializedSize FHEWrapper::save_relin_keys(std::ostream& out, bool compress) const {
+    if (scheme_ == FHE_SCHEME::BGV) {
+        throw std::invalid_argument("HElib key-switching matrices are saved with the public key");
+    }
+    SerializedSize size;
+    size.raw_bytes = static_cast<uint64_t>(seal_relin_keys_->save_size(seal::compr_mode_type::none));
+    size.stored_bytes = static_cast<uint64_t>(seal_relin_keys_->save(out, compr_mode(compress)));
+    return size;
+}
+
+/**
+ * @brief 加载公钥
+ * @param in 输入流
+ */
+void FHEWrapper::load_public_key(std::istream& in) {
+    if (scheme_ == FHE_SCHEME::BGV) {
+        load_framed([&](std::istream& s) {
+            helib_pubkey_ = std::make_shared<helib::PubKey>(helib::PubKey::readFrom(s, *helib_context_));
+        }, in);
+        if (ciphertext_pool_) {
+            ciphertext_pool_->set_helib_pubkey(helib_pubkey_.get());
+        }
+        return;
+    }
+    auto pubkey = std::make_unique<seal::PublicKey>();
+    pubkey->load(*seal_context_, in);
+    seal_pubkey_ = std::move(pubkey);
+    if (seal_encryptor_) {
+        seal_encryptor_ = std::make_unique<seal::Encryptor>(*seal_context_, *seal_pubkey_);
+    }
+}
+
+/**
+ * @brief 加载重线性化密钥
+ * @param in 输入流
+ * @throws std::invalid_argument 当方案为BGV时抛出异常
+ */
+void FHEWrapper::load_relin_keys(std::istream& in) {
+    if (scheme_ == FHE_SCHEME::BGV) {
+        throw std::invalid_argument("HElib key-switching matrices are loaded with the public key");
+    }
+    auto relin_keys = std::make_unique<seal::RelinKeys>();
+    relin_keys->load(*seal_context_, in);
+    seal_relin_keys_ = std::move(relin_keys);
+}
+
+/**
+ * @brief 获取密文对象池统计信息
+ * @return 分配次数、新建密文对象次数和空闲对象数
+ */
+CiphertextPool::Stats FHEWrapper::ciphertext_pool_stats() const {
+    return ciphertext_pool_->stats();
+}
+
+/**
+ * @brief 计算密钥流吞吐量
+ * @param block_count 一次评估生成的块数
+ * @param trunc_m 截断位数
+ * @param eval_time 评估时间（毫秒）
+ * @return 吞吐量（KiB/s）
+ * @throws std::invalid_argument 当截断位数不小于36时抛出异常
+ */
+double FHEWrapper::get_throughput(uint32_t block_count, uint32_t trunc_m, double eval_time) const {
+    if (trunc_m >= 36) {
+        throw std::invalid_argument("Truncation must be less than 36");
+    }
+    return throughput_kibps(params_.plain_modulus, static_cast<double>(block_count) * (36 - trunc_m), eval_time);
 }
 
 } // namespace yus
\ No newline at end of file
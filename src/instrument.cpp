@@ -0,0 +1,233 @@
+/**
+ * @file instrument.cpp
+ * @brief YuS流密码热路径插桩实现
+ * @author Aurorp1g
+ * @date 2025-11-07
+ *
+ * 实现按线程的阶段计数器、跨线程汇总和快照输出。
+ */
+
+#include "yus/instrument.h"
+#include "yus/timing.h"
+#include <atomic>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+namespace yus {
+
+namespace {
+
+/// 每个阶段保存calls、ns、bytes三个计数
+constexpr size_t kFields = 3;
+constexpr size_t kSlots = kStageCount * kFields;
+
+using Totals = std::array<uint64_t, kSlots>;
+
+const char* const kStageNames[kStageCount] = {
+    "whitening", "sbox_layer", "linear_layer", "round_key", "xof",
+    "fhe_multiply", "fhe_relinearize", "fhe_rotate", "fhe_mod_switch"
+};
+
+struct ThreadCounters;
+
+/**
+ * @struct Registry
+ * @brief 所有线程计数器的登记表
+ */
+struct Registry {
+    std::mutex mutex;                       ///< 保护以下成员
+    std::vector<ThreadCounters*> live;      ///< 存活线程的计数器
+    Totals retired{};                       ///< 已退出线程的累计计数
+    Totals baseline{};                      ///< instrument_reset()时的汇总值
+};
+
+/**
+ * @brief 获取登记表
+ *
+ * 有意不析构：线程可能在静态对象析构之后才退出并归还计数。
+ */
+Registry& registry() {
+    static Registry* instance = new Registry;
+    return *instance;
+}
+
+/**
+ * @struct ThreadCounters
+ * @brief 单个线程的计数器
+ *
+ * 只有所属线程写入，用relaxed的load/store代替原子读改写，汇总线程读到的是完整的64位值。
+ */
+struct ThreadCounters {
+    std::array<std::atomic<uint64_t>, kSlots> values;
+
+    ThreadCounters() {
+        for (auto& value : values) {
+            value.store(0, std::memory_order_relaxed);
+        }
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        reg.live.push_back(this);
+    }
+
+    ~ThreadCounters() {
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        for (size_t k = 0; k < kSlots; ++k) {
+            reg.retired[k] += values[k].load(std::memory_order_relaxed);
+        }
+        for (size_t i = 0; i < reg.live.size(); ++i) {
+            if (reg.live[i] == this) {
+                reg.live[i] = reg.live.back();
+                reg.live.pop_back();
+                break;
+            }
+        }
+    }
+
+    void add(size_t slot, uint64_t amount) {
+        values[slot].store(values[slot].load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+};
+
+/**
+ * @brief 获取当前线程的计数器，首次调用时登记
+ */
+ThreadCounters& local_counters() {
+    thread_local ThreadCounters counters;
+    return counters;
+}
+
+/**
+ * @brief 在锁内汇总已退出线程和存活线程的计数
+ */
+Totals collect_totals(Registry& reg) {
+    Totals totals = reg.retired;
+    for (const ThreadCounters* counters : reg.live) {
+        for (size_t k = 0; k < kSlots; ++k) {
+            totals[k] += counters->values[k].load(std::memory_order_relaxed);
+        }
+    }
+    return totals;
+}
+
+} // namespace
+
+/**
+ * @brief 获取阶段名
+ * @param stage 阶段
+ * @return 小写阶段名
+ */
+const char* stage_name(Stage stage) {
+    const size_t index = static_cast<size_t>(stage);
+    return index < kStageCount ? kStageNames[index] : "unknown";
+}
+
+/**
+ * @brief 获取某个阶段的计数
+ */
+const StageCounter& InstrumentSnapshot::operator[](Stage stage) const {
+    return stages[static_cast<size_t>(stage)];
+}
+
+/**
+ * @brief 序列化为JSON对象
+ */
+std::string InstrumentSnapshot::to_json() const {
+    std::ostringstream out;
+    out << "{";
+    for (size_t s = 0; s < kStageCount; ++s) {
+        out << (s ? "," : "") << "\"" << kStageNames[s] << "\":{\"calls\":" << stages[s].calls
+            << ",\"ns\":" << stages[s].ns << ",\"bytes\":" << stages[s].bytes << "}";
+    }
+    out << "}";
+    return out.str();
+}
+
+/**
+ * @brief 以表格形式输出计数
+ * @param out 输出流
+ *
+ * 没有调用记录的阶段不输出。
+ */
+void InstrumentSnapshot::print(std::ostream& out) const {
+    const auto flags = out.flags();
+    const auto precision = out.precision();
+    out << std::left << std::setw(18) << "stage" << std::right << std::setw(14) << "calls" << std::setw(14)
+        << "total ms" << std::setw(14) << "ns/call" << std::setw(14) << "bytes" << std::endl;
+    for (size_t s = 0; s < kStageCount; ++s) {
+        const StageCounter& c = stages[s];
+        if (c.calls == 0) {
+            continue;
+        }
+        out << std::left << std::setw(18) << kStageNames[s] << std::right << std::setw(14) << c.calls
+            << std::fixed << std::setprecision(3) << std::setw(14) << static_cast<double>(c.ns) / 1e6
+            << std::setprecision(1) << std::setw(14) << static_cast<double>(c.ns) / static_cast<double>(c.calls)
+            << std::setw(14) << c.bytes << std::endl;
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
+
+/**
+ * @brief 插桩是否已编译进库
+ */
+bool instrument_enabled() {
+#if defined(YUS_INSTRUMENT)
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief 汇总所有线程自上次重置以来的计数
+ */
+InstrumentSnapshot instrument_snapshot() {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    const Totals totals = collect_totals(reg);
+
+    InstrumentSnapshot snapshot;
+    for (size_t s = 0; s < kStageCount; ++s) {
+        const size_t base = s * kFields;
+        snapshot.stages[s].calls = totals[base] - reg.baseline[base];
+        snapshot.stages[s].ns = totals[base + 1] - reg.baseline[base + 1];
+        snapshot.stages[s].bytes = totals[base + 2] - reg.baseline[base + 2];
+    }
+    return snapshot;
+}
+
+/**
+ * @brief 把所有线程的计数清零
+ */
+void instrument_reset() {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    reg.baseline = collect_totals(reg);
+}
+
+namespace detail {
+
+/**
+ * @brief 向当前线程的计数器累加一次记录
+ */
+void instrument_record(Stage stage, uint64_t ns, uint64_t bytes) {
+    ThreadCounters& counters = local_counters();
+    const size_t base = static_cast<size_t>(stage) * kFields;
+    counters.add(base, 1);
+    counters.add(base + 1, ns);
+    counters.add(base + 2, bytes);
+}
+
+/**
+ * @brief 读取插桩使用的单调时钟（纳秒）
+ */
+uint64_t instrument_now() {
+    return steady_ns();
+}
+
+} // namespace detail
+
+} // namespace yus
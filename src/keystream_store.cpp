@@ -0,0 +1,185 @@
+/**
+ * @file keystream_store.cpp
+ * @brief YuS流密码加密密钥流缓存实现
+ * @author Aurorp1g
+ * @date 2025-11-07
+ *
+ * 实现加密密钥流的离线预计算、查询和按最近最少使用顺序的容量淘汰。
+ */
+
+#include "yus/keystream_store.h"
+
+namespace yus {
+
+/**
+ * @brief KeystreamStore构造函数
+ * @param max_entries 最大条目数，0表示不限制
+ * @param max_bytes 最大密文字节数，0表示不限制
+ */
+KeystreamStore::KeystreamStore(size_t max_entries, size_t max_bytes)
+    : max_entries_(max_entries), max_bytes_(max_bytes), bytes_(0), stats_{0, 0, 0} {}
+
+/**
+ * @brief 构造条目索引
+ * @param key_id 加密密钥标识
+ * @param eval_params 评估参数
+ * @return 条目索引
+ *
+ * 模数切换计划不影响密钥流的值，不参与索引。
+ */
+KeystreamStore::Key KeystreamStore::make_key(const std::string& key_id, const YuSEvalParams& eval_params) {
+    return Key(key_id, eval_params.nonce, static_cast<uint32_t>(eval_params.level),
+               eval_params.trunc_m, eval_params.first_block);
+}
+
+/**
+ * @brief 离线预计算并缓存加密密钥流
+ * @param fhe 同态加密封装实例
+ * @param key_id 加密密钥标识
+ * @param cipher_key 加密的主密钥
+ * @param key_products 24个加密密钥乘积，可为空
+ * @param eval_params 随机数、轮数、截断和块范围
+ * @return 评估时间（毫秒）
+ */
+double KeystreamStore::precompute(FHEWrapper& fhe, const std::string& key_id,
+                                  const std::vector<Ciphertext>& cipher_key,
+                                  const std::vector<Ciphertext>& key_products,
+                                  const YuSEvalParams& eval_params) {
+    std::vector<Ciphertext> keystream;
+    double eval_time = fhe.evaluate_yus(cipher_key, key_products, eval_params, keystream);
+
+    size_t bytes = 0;
+    for (const auto& ct : keystream) {
+        bytes += fhe.ciphertext_bytes(ct);
+    }
+    insert(key_id, eval_params, std::move(keystream), bytes);
+    return eval_time;
+}
+
+/**
+ * @brief 插入加密密钥流
+ * @param key_id 加密密钥标识
+ * @param eval_params 生成该密钥流所用的评估参数
+ * @param cipher_keystream 行式打包的加密密钥流
+ * @param bytes 密文占用的字节数
+ * @return 插入成功返回true
+ */
+bool KeystreamStore::insert(const std::string& key_id, const YuSEvalParams& eval_params,
+                            std::vector<Ciphertext> cipher_keystream, size_t bytes) {
+    if ((max_bytes_ != 0 && bytes > max_bytes_) || !eval_params.segments.empty()) {
+        return false;
+    }
+    Key key = make_key(key_id, eval_params);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+        bytes_ -= it->second->bytes;
+        lru_.erase(it->second);
+        index_.erase(it);
+    }
+
+    lru_.push_front(Entry{key, eval_params.block_count, std::move(cipher_keystream), bytes});
+    index_[key] = lru_.begin();
+    bytes_ += bytes;
+    evict();
+    return true;
+}
+
+/**
+ * @brief 查询加密密钥流
+ * @param key_id 加密密钥标识
+ * @param eval_params 需要的随机数、轮数、截断和块范围
+ * @param cipher_keystream 命中时输出缓存的密文
+ * @return 命中返回true
+ *
+ * block_count为0表示填满所有槽：这样的条目覆盖任意请求，而这样的请求只匹配同样填满的条目。
+ */
+bool KeystreamStore::lookup(const std::string& key_id, const YuSEvalParams& eval_params,
+                            std::vector<Ciphertext>& cipher_keystream) {
+    const Key key = make_key(key_id, eval_params);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = eval_params.segments.empty() ? index_.find(key) : index_.end();
+    if (it != index_.end()) {
+        const uint32_t covered = it->second->block_count;
+        const uint32_t requested = eval_params.block_count;
+        if (covered == 0 || (requested != 0 && requested <= covered)) {
+            // 移到表头标记为最近使用
+            lru_.splice(lru_.begin(), lru_, it->second);
+            cipher_keystream = it->second->keystream;
+            ++stats_.hits;
+            return true;
+        }
+    }
+    ++stats_.misses;
+    return false;
+}
+
+/**
+ * @brief 删除某个随机数下的全部条目
+ * @param key_id 加密密钥标识
+ * @param nonce 随机数
+ * @return 删除的条目数
+ */
+size_t KeystreamStore::erase(const std::string& key_id, const std::vector<uint8_t>& nonce) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t erased = 0;
+    for (auto it = index_.begin(); it != index_.end();) {
+        if (std::get<0>(it->first) == key_id && std::get<1>(it->first) == nonce) {
+            bytes_ -= it->second->bytes;
+            lru_.erase(it->second);
+            it = index_.erase(it);
+            ++erased;
+        } else {
+            ++it;
+        }
+    }
+    return erased;
+}
+
+/**
+ * @brief 获取条目数
+ * @return 条目数
+ */
+size_t KeystreamStore::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return lru_.size();
+}
+
+/**
+ * @brief 获取缓存密文的总字节数
+ * @return 字节数
+ */
+size_t KeystreamStore::bytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bytes_;
+}
+
+/**
+ * @brief 获取统计信息
+ * @return 命中、未命中和淘汰次数
+ */
+KeystreamStore::Stats KeystreamStore::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+/**
+ * @brief 淘汰条目直到满足容量限制
+ *
+ * 从表尾（最久未使用）开始淘汰，刚插入的表头条目保留。
+ */
+void KeystreamStore::evict() {
+    while (lru_.size() > 1 &&
+           ((max_entries_ != 0 && lru_.size() > max_entries_) ||
+            (max_bytes_ != 0 && bytes_ > max_bytes_))) {
+        const Entry& victim = lru_.back();
+        bytes_ -= victim.bytes;
+        index_.erase(victim.key);
+        lru_.pop_back();
+        ++stats_.evictions;
+    }
+}
+
+} // namespace yus
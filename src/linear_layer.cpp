@@ -10,6 +10,7 @@
 
 #include "yus/linear_layer.h"
 #include "yus/utils.h"
+#include "yus/instrument.h"
 #include <stdexcept>
 #include <algorithm>
 #include <string>
@@ -82,39 +83,93 @@ LinearLayer::LinearLayer() {
     precompute_four_russians();
 }
 
+/**
+ * @brief 统计调度所需的加法次数
+ * @return 部分和构造与行累加的加法总数
+ */
+uint32_t AdditionSchedule::addition_count() const {
+    uint32_t count = static_cast<uint32_t>(partial_sums.size());
+    for (const auto& row : rows) {
+        if (!row.empty()) {
+            count += static_cast<uint32_t>(row.size()) - 1;
+        }
+    }
+    return count;
+}
+
 /**
  * @brief 预计算四俄罗斯人算法表
  */
 void LinearLayer::precompute_four_russians() {
+    schedule_ = addition_schedule(0);
+}
+
+/**
+ * @brief 生成加法调度
+ * @param first_row 首个需要计算的输出行
+ * @return 只覆盖行first_row..35的加法调度
+ * @throws std::invalid_argument 当first_row大于36时抛出异常
+ * 
+ * 36列分成9组，每组4列。每行在每组中的4位构成掩码，
+ * 相同(组, 掩码)的部分和只计算一次并在各行间共享：
+ * 掩码部分和 = 去掉最低位后的部分和 + 最低位对应的输入。
+ */
+AdditionSchedule LinearLayer::addition_schedule(uint32_t first_row) const {
+    if (first_row > 36) {
+        throw std::invalid_argument("First row must be ≤36");
+    }
+
     const uint32_t group_size = 4;
     const uint32_t num_groups = 36 / group_size;
     const uint32_t group_mask_count = 1 << group_size;  // 16种掩码组合
 
-    // 初始化预计算表：9组 × 16种掩码
-    four_russians_table_.resize(num_groups, std::vector<mpz_class>(group_mask_count, 0));
+    AdditionSchedule schedule;
+    schedule.first_row = first_row;
+    schedule.num_registers = 36;
+
+    // (组, 掩码) -> 寄存器编号，0表示尚未分配（输入寄存器不会出现在表中）
+    std::vector<std::vector<uint32_t>> table(num_groups, std::vector<uint32_t>(group_mask_count, 0));
 
-    for (uint32_t group = 0; group < num_groups; ++group) {
+    // 递归构造部分和寄存器，单列掩码直接复用输入寄存器
+    auto build = [&](auto&& self, uint32_t group, uint32_t mask) -> uint32_t {
         const uint32_t col_start = group * group_size;
+        uint32_t low_bit = 0;
+        while (!(mask & (1u << low_bit))) {
+            ++low_bit;
+        }
+        const uint32_t rest = mask & ~(1u << low_bit);
+        if (rest == 0) {
+            return col_start + low_bit;
+        }
+        if (table[group][mask] == 0) {
+            const uint32_t lhs = self(self, group, rest);
+            const uint32_t dst = schedule.num_registers++;
+            schedule.partial_sums.push_back({dst, lhs, col_start + low_bit, group});
+            table[group][mask] = dst;
+        }
+        return table[group][mask];
+    };
 
-        for (uint32_t mask = 0; mask < group_mask_count; ++mask) {
-            mpz_class sum(0);
-            // 根据掩码选择列向量
+    for (uint32_t row = first_row; row < 36; ++row) {
+        std::vector<uint32_t> terms;
+        for (uint32_t group = 0; group < num_groups; ++group) {
+            const uint32_t col_start = group * group_size;
+            uint32_t mask = 0;
+
+            // 构建行掩码：选择当前行中对应组的非零元素
             for (uint32_t bit = 0; bit < group_size; ++bit) {
-                if (mask & (1 << bit)) {
-                    const uint32_t col = col_start + bit;
-                    mpz_class col_vec(0);
-                    // 构建列向量
-                    for (uint32_t row = 0; row < 36; ++row) {
-                        if (matrix_[row][col] == 1) {
-                            mpz_setbit(col_vec.get_mpz_t(), row);
-                        }
-                    }
-                    sum ^= col_vec;  // 异或操作
+                if (matrix_[row][col_start + bit] == 1) {
+                    mask |= (1 << bit);
                 }
             }
-            four_russians_table_[group][mask] = sum;
+            if (mask != 0) {
+                terms.push_back(build(build, group, mask));
+            }
         }
+        schedule.rows.push_back(std::move(terms));
     }
+
+    return schedule;
 }
 
 /**
@@ -125,45 +180,41 @@ void LinearLayer::precompute_four_russians() {
  * @throws std::invalid_argument 当状态向量大小不正确时抛出异常
  */
 std::vector<mpz_class> LinearLayer::apply(const std::vector<mpz_class>& state, const mpz_class& p) const {
+    YUS_INSTRUMENT_SCOPE(Stage::LINEAR_LAYER);
     if (state.size() != 36) {
         throw std::invalid_argument("Linear layer input must be 36 elements");
     }
 
+    // 计算共享的分组部分和
+    std::vector<mpz_class> regs(schedule_.num_registers);
+    std::copy(state.begin(), state.end(), regs.begin());
+    for (const auto& step : schedule_.partial_sums) {
+        regs[step.dst] = regs[step.lhs] + regs[step.rhs];
+    }
+
     std::vector<mpz_class> output(36, 0);
-    const uint32_t group_size = 4;
-    const uint32_t num_groups = 9;
 
     // 并行处理36行
     #pragma omp parallel for
     for (uint32_t row = 0; row < 36; ++row) {
         mpz_class row_sum(0);
-        
-        for (uint32_t group = 0; group < num_groups; ++group) {
-            const uint32_t col_start = group * group_size;
-            uint8_t mask = 0;
-            
-            // 构建行掩码：选择当前行中对应组的非零元素
-            for (uint32_t bit = 0; bit < group_size; ++bit) {
-                if (matrix_[row][col_start + bit] == 1) {
-                    mask |= (1 << bit);
-                }
-            }
-            
-            const mpz_class& precomputed = four_russians_table_[group][mask];
-            
-            // 应用预计算结果到状态向量
-            for (uint32_t i = 0; i < 36; ++i) {
-                if (mpz_tstbit(precomputed.get_mpz_t(), i)) {
-                    row_sum = mod(row_sum + state[col_start + i % group_size], p);
-                }
-            }
+        for (uint32_t reg : schedule_.rows[row]) {
+            row_sum += regs[reg];
         }
-        output[row] = row_sum;
+        output[row] = mod(row_sum, p);
     }
 
     return output;
 }
 
+/**
+ * @brief 获取36x36二进制矩阵
+ * @return 线性层矩阵的只读引用
+ */
+const std::vector<std::vector<uint8_t>>& LinearLayer::matrix() const {
+    return matrix_;
+}
+
 /**
  * @brief 计算线性分支数
  * @return 线性分支数
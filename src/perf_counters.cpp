@@ -0,0 +1,184 @@
+/**
+ * @file perf_counters.cpp
+ * @brief YuS流密码硬件性能计数器实现
+ * @author Aurorp1g
+ * @date 2025-11-07
+ *
+ * Linux上通过perf_event_open系统调用实现；其他平台所有计数器均不可用。
+ */
+
+#include "yus/perf_counters.h"
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+namespace yus {
+
+namespace {
+
+#if defined(__linux__)
+/**
+ * @brief 打开一个只统计用户态的事件，初始为停止状态
+ * @return 文件描述符，失败时返回-1并设置errno
+ *
+ * inherit使事件同时统计当前线程之后创建的线程（如OpenMP线程组）；
+ * 对父事件的ioctl作用于所有继承的事件，read返回它们的总和。
+ */
+int open_event(uint32_t type, uint64_t config) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.inherit = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+/// L1数据缓存读未命中的cache事件编码
+constexpr uint64_t kL1dReadMiss = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+#endif
+
+} // namespace
+
+/**
+ * @brief 构造函数，打开默认的硬件事件
+ */
+PerfCounters::PerfCounters() {
+#if defined(__linux__)
+    open("cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    open("instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    open("l1d_misses", PERF_TYPE_HW_CACHE, kL1dReadMiss);
+    open("llc_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    open("branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+#else
+    for (const char* name : {"cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses"}) {
+        counters_.push_back(PerfCounter{name, -1, 0});
+    }
+    error_ = "perf_event_open is only available on Linux";
+#endif
+}
+
+/**
+ * @brief 析构函数，关闭所有事件
+ */
+PerfCounters::~PerfCounters() {
+#if defined(__linux__)
+    for (const auto& counter : counters_) {
+        if (counter.fd >= 0) {
+            close(counter.fd);
+        }
+    }
+#endif
+}
+
+/**
+ * @brief 添加原始硬件事件
+ */
+bool PerfCounters::add_raw(const std::string& name, uint64_t config) {
+#if defined(__linux__)
+    return open(name, PERF_TYPE_RAW, config);
+#else
+    (void)config;
+    counters_.push_back(PerfCounter{name, -1, 0});
+    return false;
+#endif
+}
+
+/**
+ * @brief 打开一个事件并追加到计数器列表
+ */
+bool PerfCounters::open(const std::string& name, uint32_t type, uint64_t config) {
+    PerfCounter counter{name, -1, 0};
+#if defined(__linux__)
+    counter.fd = open_event(type, config);
+    if (counter.fd < 0 && error_.empty()) {
+        error_ = name + ": " + std::strerror(errno);
+    }
+#else
+    (void)type;
+    (void)config;
+#endif
+    counters_.push_back(counter);
+    return counter.fd >= 0;
+}
+
+/**
+ * @brief 是否至少有一个计数器可用
+ */
+bool PerfCounters::available() const {
+    for (const auto& counter : counters_) {
+        if (counter.fd >= 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 清零并开始计数
+ */
+void PerfCounters::start() {
+#if defined(__linux__)
+    for (const auto& counter : counters_) {
+        if (counter.fd >= 0) {
+            ioctl(counter.fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(counter.fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#endif
+}
+
+/**
+ * @brief 停止计数并读取各计数器
+ *
+ * 读数为{count, time_enabled, time_running}；被复用调度时按enabled/running放大，
+ * 从未被调度时记为0。
+ */
+void PerfCounters::stop() {
+#if defined(__linux__)
+    for (const auto& counter : counters_) {
+        if (counter.fd >= 0) {
+            ioctl(counter.fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+    for (auto& counter : counters_) {
+        if (counter.fd < 0) {
+            continue;
+        }
+        uint64_t data[3] = {0, 0, 0};
+        if (read(counter.fd, data, sizeof(data)) != static_cast<ssize_t>(sizeof(data)) || data[2] == 0) {
+            counter.value = 0;
+            continue;
+        }
+        counter.value = static_cast<double>(data[0]);
+        if (data[2] < data[1]) {
+            counter.value *= static_cast<double>(data[1]) / static_cast<double>(data[2]);
+        }
+    }
+#endif
+}
+
+/**
+ * @brief 按名称获取最近一次区间的计数
+ */
+double PerfCounters::value(const std::string& name) const {
+    for (const auto& counter : counters_) {
+        if (counter.name == name) {
+            return counter.fd >= 0 ? counter.value : -1;
+        }
+    }
+    return -1;
+}
+
+} // namespace yus
@@ -10,6 +10,7 @@
 
 #include "yus/round_key.h"
 #include "yus/utils.h"
+#include "yus/instrument.h"
 #include <stdexcept>
 #include <cstring>
 #include <openssl/evp.h>
@@ -39,6 +40,7 @@ RoundKeyGenerator::RoundKeyGenerator(const std::vector<uint8_t>& nonce, uint32_t
 void RoundKeyGenerator::shake128_xof(const std::vector<uint8_t>& input, 
                                      uint32_t output_len, 
                                      std::vector<uint8_t>& output) const {
+    YUS_INSTRUMENT_SCOPE_BYTES(Stage::XOF, output_len);
     output.resize(output_len);
     
     // 创建EVP上下文
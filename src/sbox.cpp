@@ -10,6 +10,7 @@
 
 #include "yus/sbox.h"
 #include "yus/utils.h"
+#include "yus/instrument.h"
 #include <stdexcept>
 #include <set>
 
@@ -97,6 +98,7 @@ mpz_class SBox::differential_uniformity() const {
  * @throws std::invalid_argument 当状态向量大小不正确时抛出异常
  */
 std::vector<mpz_class> apply_sbox_layer(const std::vector<mpz_class>& state, const mpz_class& p) {
+    YUS_INSTRUMENT_SCOPE(Stage::SBOX_LAYER);
     if (state.size() != 36) {
         throw std::invalid_argument("SBox layer input must be 36 elements");
     }
@@ -0,0 +1,199 @@
+/**
+ * @file thread_pool.cpp
+ * @brief YuS流密码持久线程池实现
+ * @author Aurorp1g
+ * @date 2025-11-07
+ *
+ * 实现常驻工作线程和阻塞式parallel_for。
+ * 任务索引通过原子计数器动态分配，调用线程同时作为0号工作者参与计算。
+ */
+
+#include "yus/thread_pool.h"
+
+namespace yus {
+
+namespace {
+thread_local const ThreadPool* tls_pool = nullptr; ///< 当前线程作为工作者所属的线程池
+thread_local size_t tls_worker = 0;                 ///< 当前线程在tls_pool中的工作者编号
+
+/**
+ * @brief 在作用域内把当前线程登记为某个线程池的工作者，退出时恢复原登记
+ *
+ * 其他线程池的任务中调用parallel_for时，外层的登记在内层返回后恢复。
+ */
+class WorkerScope {
+public:
+    WorkerScope(const ThreadPool* pool, size_t worker) : saved_pool_(tls_pool), saved_worker_(tls_worker) {
+        tls_pool = pool;
+        tls_worker = worker;
+    }
+    ~WorkerScope() {
+        tls_pool = saved_pool_;
+        tls_worker = saved_worker_;
+    }
+    WorkerScope(const WorkerScope&) = delete;
+    WorkerScope& operator=(const WorkerScope&) = delete;
+
+private:
+    const ThreadPool* saved_pool_;
+    size_t saved_worker_;
+};
+}
+
+/**
+ * @brief ThreadPool构造函数
+ * @param num_threads 工作者数量（含调用线程），0表示使用硬件并发数
+ */
+ThreadPool::ThreadPool(size_t num_threads)
+    : task_(nullptr), task_count_(0), next_index_(0),
+      active_(0), generation_(0), stop_(false) {
+    if (num_threads == 0) {
+        num_threads = std::thread::hardware_concurrency();
+        if (num_threads == 0) {
+            num_threads = 1;
+        }
+    }
+    // 调用线程作为0号工作者，只需创建num_threads-1个常驻线程
+    for (size_t w = 1; w < num_threads; ++w) {
+        threads_.emplace_back(&ThreadPool::worker_loop, this, w);
+    }
+}
+
+/**
+ * @brief ThreadPool析构函数
+ */
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    work_cv_.notify_all();
+    for (auto& t : threads_) {
+        t.join();
+    }
+}
+
+/**
+ * @brief 获取工作者数量
+ * @return 工作者数量（含调用线程）
+ */
+size_t ThreadPool::size() const {
+    return threads_.size() + 1;
+}
+
+/**
+ * @brief 获取当前线程的工作者编号
+ * @return 工作者编号，编号属于当前线程正在为其执行任务的线程池
+ */
+size_t ThreadPool::current_worker() {
+    return tls_worker;
+}
+
+/**
+ * @brief 并行执行count个相互独立的任务
+ * @param count 任务数量
+ * @param fn 任务回调
+ * @throws 重新抛出任务中抛出的第一个异常
+ */
+void ThreadPool::parallel_for(size_t count, const std::function<void(size_t, size_t)>& fn) {
+    if (count == 0) {
+        return;
+    }
+
+    // 本线程池任务内的嵌套调用：在当前线程串行执行，沿用当前工作者编号
+    if (tls_pool == this) {
+        for (size_t i = 0; i < count; ++i) {
+            fn(i, tls_worker);
+        }
+        return;
+    }
+
+    // 其余调用线程（包括其他线程池的工作线程）都以0号工作者身份执行，
+    // 持有提交锁保证0号工作者的资源不会被并发使用
+    std::lock_guard<std::mutex> submit_lock(submit_mutex_);
+    WorkerScope scope(this, 0);
+    if (threads_.empty() || count == 1) {
+        for (size_t i = 0; i < count; ++i) {
+            fn(i, 0);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        task_ = &fn;
+        task_count_ = count;
+        next_index_.store(0);
+        active_ = threads_.size();
+        error_ = nullptr;
+        ++generation_;
+    }
+    work_cv_.notify_all();
+
+    // 调用线程作为0号工作者参与计算
+    run_tasks(0);
+
+    std::exception_ptr error;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_cv_.wait(lock, [this] { return active_ == 0; });
+        task_ = nullptr;
+        error = error_;
+        error_ = nullptr;
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+/**
+ * @brief 工作线程主循环
+ * @param worker 工作者编号
+ */
+void ThreadPool::worker_loop(size_t worker) {
+    tls_pool = this;
+    tls_worker = worker;
+    uint64_t seen_generation = 0;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            work_cv_.wait(lock, [&] { return stop_ || generation_ != seen_generation; });
+            if (stop_) {
+                return;
+            }
+            seen_generation = generation_;
+        }
+
+        run_tasks(worker);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (--active_ == 0) {
+                done_cv_.notify_one();
+            }
+        }
+    }
+}
+
+/**
+ * @brief 领取并执行当前任务的剩余索引
+ * @param worker 工作者编号
+ */
+void ThreadPool::run_tasks(size_t worker) {
+    size_t i;
+    while ((i = next_index_.fetch_add(1)) < task_count_) {
+        try {
+            (*task_)(i, worker);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!error_) {
+                error_ = std::current_exception();
+            }
+            // 放弃剩余任务
+            next_index_.store(task_count_);
+        }
+    }
+}
+
+} // namespace yus
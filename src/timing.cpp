@@ -0,0 +1,311 @@
+/**
+ * @file timing.cpp
+ * @brief YuS流密码计时组件实现
+ * @author Aurorp1g
+ * @date 2025-11-07
+ *
+ * 实现稳定时钟和串行化TSC读取、TSC频率校准、计时器和样本统计。
+ */
+
+#include "yus/timing.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define YUS_HAS_TSC 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+#endif
+
+namespace yus {
+
+namespace {
+
+/**
+ * @brief 检查CPUID声明的不变TSC（扩展叶0x80000007的EDX第8位）
+ */
+bool detect_invariant_tsc() {
+#if defined(YUS_HAS_TSC)
+#if defined(_MSC_VER)
+    int regs[4] = {0};
+    __cpuid(regs, 0x80000000);
+    if (static_cast<unsigned>(regs[0]) < 0x80000007u) {
+        return false;
+    }
+    __cpuid(regs, 0x80000007);
+    return (regs[3] & (1 << 8)) != 0;
+#else
+    unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (__get_cpuid_max(0x80000000u, nullptr) < 0x80000007u) {
+        return false;
+    }
+    __cpuid(0x80000007u, eax, ebx, ecx, edx);
+    return (edx & (1u << 8)) != 0;
+#endif
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief 对照稳定时钟校准TSC频率
+ * @return GHz，不可用时返回0
+ *
+ * 取3次约17毫秒窗口的中位数，降低调度打断对单次窗口的影响。
+ */
+double calibrate_tsc_ghz() {
+    if (!tsc_available()) {
+        return 0;
+    }
+    double rates[3];
+    for (double& rate : rates) {
+        const uint64_t ns0 = steady_ns();
+        const uint64_t tsc0 = tsc_begin();
+        std::this_thread::sleep_for(std::chrono::milliseconds(17));
+        const uint64_t tsc1 = tsc_end();
+        const uint64_t ns1 = steady_ns();
+        rate = static_cast<double>(tsc1 - tsc0) / static_cast<double>(ns1 - ns0);
+    }
+    std::sort(rates, rates + 3);
+    return rates[1];
+}
+
+} // namespace
+
+/**
+ * @brief 读取稳定时钟
+ * @return 纳秒数
+ */
+uint64_t steady_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/**
+ * @brief 当前平台是否提供不变的时间戳计数器
+ */
+bool tsc_available() {
+    static const bool available = detect_invariant_tsc();
+    return available;
+}
+
+/**
+ * @brief 在计时区间起点读取TSC
+ */
+uint64_t tsc_begin() {
+#if defined(YUS_HAS_TSC)
+    _mm_lfence();
+    const uint64_t t = __rdtsc();
+    _mm_lfence();
+    return t;
+#else
+    return steady_ns();
+#endif
+}
+
+/**
+ * @brief 在计时区间终点读取TSC
+ */
+uint64_t tsc_end() {
+#if defined(YUS_HAS_TSC)
+    unsigned int aux = 0;
+    const uint64_t t = __rdtscp(&aux);
+    _mm_lfence();
+    return t;
+#else
+    return steady_ns();
+#endif
+}
+
+/**
+ * @brief 获取TSC频率
+ * @return GHz，不可用时返回0
+ */
+double tsc_ghz() {
+    static const double ghz = calibrate_tsc_ghz();
+    return ghz;
+}
+
+/**
+ * @brief Timer构造函数
+ * @param clock 计时使用的时钟
+ */
+Timer::Timer(TimerClock clock)
+    : clock_(clock == TimerClock::TSC && !tsc_available() ? TimerClock::STEADY : clock),
+      start_ticks_(0), stop_ticks_(0) {}
+
+/**
+ * @brief 开始计时
+ */
+void Timer::start() {
+    start_ticks_ = clock_ == TimerClock::TSC ? tsc_begin() : steady_ns();
+}
+
+/**
+ * @brief 停止计时
+ */
+void Timer::stop() {
+    stop_ticks_ = clock_ == TimerClock::TSC ? tsc_end() : steady_ns();
+}
+
+/**
+ * @brief 实际使用的时钟
+ */
+TimerClock Timer::clock() const {
+    return clock_;
+}
+
+/**
+ * @brief 获取经过的原始计数
+ */
+uint64_t Timer::elapsed_ticks() const {
+    return stop_ticks_ - start_ticks_;
+}
+
+/**
+ * @brief 获取经过的时间（纳秒）
+ */
+double Timer::elapsed_ns() const {
+    const double ticks = static_cast<double>(elapsed_ticks());
+    return clock_ == TimerClock::TSC ? ticks / tsc_ghz() : ticks;
+}
+
+/**
+ * @brief 获取经过的时间（毫秒）
+ */
+double Timer::elapsed_ms() const {
+    return elapsed_ns() / 1e6;
+}
+
+/**
+ * @brief 获取经过的TSC周期数
+ */
+double Timer::elapsed_cycles() const {
+    const double ticks = static_cast<double>(elapsed_ticks());
+    return clock_ == TimerClock::TSC ? ticks : ticks * tsc_ghz();
+}
+
+/**
+ * @brief 加入一个样本
+ */
+void SampleStats::add(double sample) {
+    if (sorted_ && !samples_.empty() && sample < samples_.back()) {
+        sorted_ = false;
+    }
+    samples_.push_back(sample);
+}
+
+/**
+ * @brief 合并另一个累加器的样本
+ */
+void SampleStats::merge(const SampleStats& other) {
+    for (double sample : other.samples_) {
+        add(sample);
+    }
+}
+
+/**
+ * @brief 清空样本
+ */
+void SampleStats::clear() {
+    samples_.clear();
+    sorted_ = true;
+}
+
+/**
+ * @brief 样本数
+ */
+size_t SampleStats::count() const {
+    return samples_.size();
+}
+
+/**
+ * @brief 按需排序样本
+ */
+const std::vector<double>& SampleStats::sorted() const {
+    if (!sorted_) {
+        std::sort(samples_.begin(), samples_.end());
+        sorted_ = true;
+    }
+    return samples_;
+}
+
+/**
+ * @brief 最小值
+ */
+double SampleStats::min() const {
+    return samples_.empty() ? 0 : sorted().front();
+}
+
+/**
+ * @brief 最大值
+ */
+double SampleStats::max() const {
+    return samples_.empty() ? 0 : sorted().back();
+}
+
+/**
+ * @brief 算术平均值
+ */
+double SampleStats::mean() const {
+    if (samples_.empty()) {
+        return 0;
+    }
+    double sum = 0;
+    for (double sample : samples_) {
+        sum += sample;
+    }
+    return sum / static_cast<double>(samples_.size());
+}
+
+/**
+ * @brief 中位数
+ *
+ * 偶数个样本时取中间两个的平均值。
+ */
+double SampleStats::median() const {
+    if (samples_.empty()) {
+        return 0;
+    }
+    const auto& s = sorted();
+    const size_t n = s.size();
+    return n % 2 ? s[n / 2] : (s[n / 2 - 1] + s[n / 2]) / 2;
+}
+
+/**
+ * @brief 分位数（最近秩法）
+ * @param q 分位
+ */
+double SampleStats::percentile(double q) const {
+    if (samples_.empty()) {
+        return 0;
+    }
+    const auto& s = sorted();
+    q = std::min(1.0, std::max(0.0, q));
+    const size_t rank = static_cast<size_t>(std::ceil(q * static_cast<double>(s.size())));
+    return s[rank == 0 ? 0 : rank - 1];
+}
+
+/**
+ * @brief 样本标准差
+ */
+double SampleStats::stddev() const {
+    const size_t n = samples_.size();
+    if (n < 2) {
+        return 0;
+    }
+    const double m = mean();
+    double sq = 0;
+    for (double sample : samples_) {
+        sq += (sample - m) * (sample - m);
+    }
+    return std::sqrt(sq / static_cast<double>(n - 1));
+}
+
+} // namespace yus
@@ -0,0 +1,137 @@
+/**
+ * @file trace.cpp
+ * @brief YuS流密码评估时间线记录实现
+ * @author Aurorp1g
+ * @date 2025-11-07
+ *
+ * 实现时间跨度的记录和Chrome trace-event JSON输出。
+ */
+
+#include "yus/trace.h"
+#include "yus/timing.h"
+#include <fstream>
+#include <iomanip>
+#include <set>
+#include <stdexcept>
+
+namespace yus {
+
+/**
+ * @brief 构造函数，以当前时刻为时间原点
+ */
+TraceRecorder::TraceRecorder() : origin_ns_(steady_ns()) {}
+
+/**
+ * @brief 记录一个时间跨度
+ */
+void TraceRecorder::record(const char* name, const char* category, uint32_t tid, uint64_t start_ns,
+                           uint64_t end_ns, int64_t index, int64_t level) {
+    TraceEvent event{name, category, tid,
+                     start_ns > origin_ns_ ? start_ns - origin_ns_ : 0,
+                     end_ns > start_ns ? end_ns - start_ns : 0,
+                     index, level};
+    std::lock_guard<std::mutex> lock(mutex_);
+    events_.push_back(std::move(event));
+}
+
+/**
+ * @brief 已记录的事件副本
+ */
+std::vector<TraceEvent> TraceRecorder::events() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return events_;
+}
+
+/**
+ * @brief 已记录的事件数
+ */
+size_t TraceRecorder::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return events_.size();
+}
+
+/**
+ * @brief 清空事件
+ */
+void TraceRecorder::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    events_.clear();
+}
+
+/**
+ * @brief 输出Chrome trace-event JSON
+ * @param out 输出流
+ */
+void TraceRecorder::write_json(std::ostream& out) const {
+    const auto snapshot = events();
+    std::set<uint32_t> tids;
+    for (const auto& event : snapshot) {
+        tids.insert(event.tid);
+    }
+
+    const auto flags = out.flags();
+    const auto precision = out.precision();
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    for (uint32_t tid : tids) {
+        out << (first ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+            << ",\"args\":{\"name\":\"" << (tid == 0 ? std::string("caller") : "worker " + std::to_string(tid))
+            << "\"}}";
+        first = false;
+    }
+    out << std::fixed << std::setprecision(3);
+    for (const auto& event : snapshot) {
+        out << (first ? "\n" : ",\n") << "{\"name\":\"" << event.name << "\",\"cat\":\"" << event.category
+            << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.tid
+            << ",\"ts\":" << static_cast<double>(event.start_ns) / 1e3
+            << ",\"dur\":" << static_cast<double>(event.duration_ns) / 1e3 << ",\"args\":{";
+        bool first_arg = true;
+        if (event.index >= 0) {
+            out << "\"index\":" << event.index;
+            first_arg = false;
+        }
+        if (event.level >= 0) {
+            out << (first_arg ? "" : ",") << "\"level\":" << event.level;
+        }
+        out << "}}";
+        first = false;
+    }
+    out << "\n]}" << std::endl;
+    out.flags(flags);
+    out.precision(precision);
+}
+
+/**
+ * @brief 把Chrome trace-event JSON写入文件
+ * @param path 文件路径
+ * @throws std::runtime_error 当文件无法写入时抛出异常
+ */
+void TraceRecorder::save(const std::string& path) const {
+    std::ofstream out(path);
+    if (!out) {
+        throw std::runtime_error("Cannot open trace file: " + path);
+    }
+    write_json(out);
+    if (!out) {
+        throw std::runtime_error("Failed to write trace file: " + path);
+    }
+}
+
+/**
+ * @brief TraceSpan构造函数
+ */
+TraceSpan::TraceSpan(TraceRecorder* recorder, const char* name, const char* category, uint32_t tid,
+                     int64_t index, int64_t level)
+    : recorder_(recorder), name_(name), category_(category), tid_(tid), index_(index), level_(level),
+      start_ns_(recorder ? steady_ns() : 0) {}
+
+/**
+ * @brief TraceSpan析构函数
+ */
+TraceSpan::~TraceSpan() {
+    if (recorder_) {
+        recorder_->record(name_, category_, tid_, start_ns_, steady_ns(), index_, level_);
+    }
+}
+
+} // namespace yus
@@ -0,0 +1,286 @@
+/**
+ * @file transcipher_batcher.cpp
+ * @brief YuS流密码转密请求合批器实现
+ * @author Aurorp1g
+ * @date 2025-11-07
+ *
+ * 实现请求入队、背压、按批满或截止时间触发的合并评估，以及延迟统计。
+ */
+
+#include "yus/transcipher_batcher.h"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+namespace yus {
+
+namespace {
+
+/**
+ * @brief 计算两个时间点之间的毫秒数
+ */
+double elapsed_ms(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) {
+    return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+} // namespace
+
+/**
+ * @brief TranscipherBatcher构造函数
+ * @param fhe 同态加密封装实例
+ * @param level 安全级别
+ * @param trunc_m 截断位数
+ * @param options 合批选项
+ * @throws std::invalid_argument 当截断位数不正确时抛出异常
+ */
+TranscipherBatcher::TranscipherBatcher(FHEWrapper& fhe, SecurityLevel level, uint32_t trunc_m, Options options)
+    : fhe_(fhe), level_(level), trunc_m_(trunc_m), options_(std::move(options)),
+      slots_(fhe.slot_count()), stopping_(false) {
+    if (trunc_m_ >= 36) {
+        throw std::invalid_argument("Truncation must leave at least one word per block");
+    }
+    if (options_.max_queued_blocks == 0) {
+        options_.max_queued_blocks = 4 * slots_;
+    }
+    worker_ = std::thread(&TranscipherBatcher::run, this);
+}
+
+/**
+ * @brief 析构函数
+ */
+TranscipherBatcher::~TranscipherBatcher() {
+    stop();
+}
+
+/**
+ * @brief 评估剩余请求并停止后台线程
+ */
+void TranscipherBatcher::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+/**
+ * @brief 每块的数据字数
+ */
+size_t TranscipherBatcher::words_per_block() const {
+    return 36 - trunc_m_;
+}
+
+/**
+ * @brief 注册加密密钥
+ * @param key_id 加密密钥标识
+ * @param cipher_key 加密的主密钥
+ * @param key_products 加密密钥乘积，可为空
+ * @throws std::invalid_argument 当密钥或密钥乘积大小不正确时抛出异常
+ */
+void TranscipherBatcher::add_key(const std::string& key_id, std::vector<Ciphertext> cipher_key,
+                                 std::vector<Ciphertext> key_products) {
+    if (cipher_key.size() != 36) {
+        throw std::invalid_argument("Encrypted master key must be 36 ciphertexts");
+    }
+    if (!key_products.empty() && key_products.size() != 24) {
+        throw std::invalid_argument("Key products must be 24 ciphertexts");
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    KeyQueue& queue = queues_[key_id];
+    queue.cipher_key = std::move(cipher_key);
+    queue.key_products = std::move(key_products);
+}
+
+/**
+ * @brief 提交转密请求
+ * @param request 转密请求
+ * @param reply 输出应答的future
+ * @return 入队返回true；超过待处理块数上限时返回false
+ * @throws std::invalid_argument 当请求不合法或合批器已停止时抛出异常
+ */
+bool TranscipherBatcher::submit(TranscipherRequest request, std::future<TranscipherReply>& reply) {
+    const size_t width = words_per_block();
+    const size_t blocks = (request.sym_ct.size() + width - 1) / width;
+    if (blocks == 0) {
+        throw std::invalid_argument("Symmetric ciphertext is empty");
+    }
+    if (blocks > slots_) {
+        throw std::invalid_argument("Request exceeds one batch (" + std::to_string(slots_) + " blocks)");
+    }
+    if (blocks - 1 > std::numeric_limits<uint32_t>::max() - request.first_block) {
+        throw std::invalid_argument("Block index overflows 32 bits");
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (stopping_) {
+        throw std::invalid_argument("Transcipher batcher is stopped");
+    }
+    auto it = queues_.find(request.key_id);
+    if (it == queues_.end()) {
+        throw std::invalid_argument("Unknown key id: " + request.key_id);
+    }
+    if (stats_.queued_blocks + blocks > options_.max_queued_blocks) {
+        ++stats_.rejected;
+        return false;
+    }
+
+    Pending pending{std::move(request), blocks, Clock::now(), std::promise<TranscipherReply>()};
+    reply = pending.promise.get_future();
+    KeyQueue& queue = it->second;
+    const bool was_short = queue.blocks < slots_;
+    queue.pending.push_back(std::move(pending));
+    queue.blocks += blocks;
+    stats_.queued_blocks += blocks;
+    const bool wake = queue.pending.size() == 1 || (was_short && queue.blocks >= slots_);
+    lock.unlock();
+
+    // 队列由空变为非空（需要设置截止时间）或刚好凑满一批时唤醒后台线程
+    if (wake) {
+        cv_.notify_one();
+    }
+    return true;
+}
+
+/**
+ * @brief 获取统计信息
+ */
+TranscipherBatcher::Stats TranscipherBatcher::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+/**
+ * @brief 后台线程主循环
+ *
+ * 在凑满一批或到达截止时间的队列中选最早入队的一个，按先进先出取出不超过slot_count()块的请求，
+ * 释放锁后评估。停止时不再等待截止时间，逐批评估剩余请求后退出。
+ */
+void TranscipherBatcher::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        const auto now = Clock::now();
+        KeyQueue* ready = nullptr;
+        auto next_deadline = Clock::time_point::max();
+        for (auto& entry : queues_) {
+            KeyQueue& queue = entry.second;
+            if (queue.pending.empty()) {
+                continue;
+            }
+            const auto deadline = queue.pending.front().enqueued + options_.deadline;
+            if (queue.blocks >= slots_ || deadline <= now || stopping_) {
+                if (!ready || queue.pending.front().enqueued < ready->pending.front().enqueued) {
+                    ready = &queue;
+                }
+            } else {
+                next_deadline = std::min(next_deadline, deadline);
+            }
+        }
+
+        if (!ready) {
+            if (stopping_) {
+                return;
+            }
+            if (next_deadline == Clock::time_point::max()) {
+                cv_.wait(lock);
+            } else {
+                cv_.wait_until(lock, next_deadline);
+            }
+            continue;
+        }
+
+        std::vector<Pending> batch;
+        size_t batch_blocks = 0;
+        while (!ready->pending.empty() && batch_blocks + ready->pending.front().blocks <= slots_) {
+            batch_blocks += ready->pending.front().blocks;
+            batch.push_back(std::move(ready->pending.front()));
+            ready->pending.pop_front();
+        }
+        ready->blocks -= batch_blocks;
+        stats_.queued_blocks -= batch_blocks;
+        // 共享引用：评估期间替换密钥不影响本批
+        std::vector<Ciphertext> cipher_key = ready->cipher_key;
+        std::vector<Ciphertext> key_products = ready->key_products;
+
+        lock.unlock();
+        evaluate_batch(batch, cipher_key, key_products);
+        lock.lock();
+    }
+}
+
+/**
+ * @brief 评估一批请求并应答
+ * @param batch 本批请求
+ * @param cipher_key 加密的主密钥
+ * @param key_products 加密密钥乘积
+ *
+ * 各请求按顺序占用相邻的槽，每个请求一个SlotSegment，因此不同随机数的请求可以同批评估。
+ * 对称密文按相同的槽顺序拼接，末块不足的请求在拼接缓冲区中补零。
+ */
+void TranscipherBatcher::evaluate_batch(std::vector<Pending>& batch, const std::vector<Ciphertext>& cipher_key,
+                                        const std::vector<Ciphertext>& key_products) {
+    const size_t width = words_per_block();
+    const auto start = Clock::now();
+
+    YuSEvalParams eval_params{};
+    eval_params.level = level_;
+    eval_params.trunc_m = trunc_m_;
+    eval_params.mod_switch_schedule = options_.mod_switch_schedule;
+    std::vector<uint64_t> sym_ct;
+    size_t batch_blocks = 0;
+    for (const auto& pending : batch) {
+        const auto& request = pending.request;
+        eval_params.segments.push_back(
+            SlotSegment{request.nonce, request.first_block, static_cast<uint32_t>(pending.blocks)});
+        sym_ct.insert(sym_ct.end(), request.sym_ct.begin(), request.sym_ct.end());
+        sym_ct.resize((batch_blocks + pending.blocks) * width, 0);
+        batch_blocks += pending.blocks;
+    }
+
+    std::vector<Ciphertext> cipher_data;
+    std::exception_ptr error;
+    try {
+        std::vector<Ciphertext> keystream;
+        fhe_.evaluate_yus(cipher_key, key_products, eval_params, keystream);
+        fhe_.strip_keystream(keystream, sym_ct.data(), batch_blocks, cipher_data);
+    } catch (...) {
+        error = std::current_exception();
+    }
+    const auto done = Clock::now();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++stats_.batches;
+    if (batch_blocks == slots_) {
+        ++stats_.full_batches;
+    }
+    stats_.filled_slots += batch_blocks;
+    stats_.total_slots += slots_;
+
+    size_t first_slot = 0;
+    for (auto& pending : batch) {
+        if (error) {
+            ++stats_.failed;
+            pending.promise.set_exception(error);
+            continue;
+        }
+        TranscipherReply reply;
+        reply.cipher_data = cipher_data;
+        reply.first_slot = first_slot;
+        reply.blocks = pending.blocks;
+        reply.batch_blocks = batch_blocks;
+        reply.queue_ms = elapsed_ms(pending.enqueued, start);
+        reply.service_ms = elapsed_ms(start, done);
+        reply.latency_ms = elapsed_ms(pending.enqueued, Clock::now());
+        first_slot += pending.blocks;
+
+        ++stats_.requests;
+        stats_.latency_sum_ms += reply.latency_ms;
+        stats_.latency_max_ms = std::max(stats_.latency_max_ms, reply.latency_ms);
+        pending.promise.set_value(std::move(reply));
+    }
+}
+
+} // namespace yus
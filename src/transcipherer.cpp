@@ -0,0 +1,160 @@
+/**
+ * @file transcipherer.cpp
+ * @brief YuS流密码转密接口实现
+ * @author Aurorp1g
+ * @date 2025-11-07
+ *
+ * 实现对称密文的分批、密钥流的缓存查询或在线评估，以及密钥流的同态减法。
+ */
+
+#include "yus/transcipherer.h"
+#include "yus/timing.h"
+#include "yus/utils.h"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+namespace yus {
+
+/**
+ * @brief Transcipherer构造函数
+ * @param fhe 同态加密封装实例
+ * @param cipher_key 加密的主密钥
+ * @param level 安全级别
+ * @param trunc_m 截断位数
+ * @throws std::invalid_argument 当加密密钥大小或截断位数不正确时抛出异常
+ */
+Transcipherer::Transcipherer(FHEWrapper& fhe, std::vector<Ciphertext> cipher_key,
+                             SecurityLevel level, uint32_t trunc_m)
+    : fhe_(fhe), cipher_key_(std::move(cipher_key)), level_(level), trunc_m_(trunc_m),
+      store_(nullptr) {
+    if (cipher_key_.size() != 36) {
+        throw std::invalid_argument("Encrypted master key must be 36 ciphertexts");
+    }
+    if (trunc_m_ >= 36) {
+        throw std::invalid_argument("Truncation must leave at least one word per block");
+    }
+}
+
+/**
+ * @brief 设置加密密钥乘积
+ * @param key_products 24个加密密钥乘积，为空时不使用
+ * @throws std::invalid_argument 当密钥乘积大小不正确时抛出异常
+ */
+void Transcipherer::set_key_products(std::vector<Ciphertext> key_products) {
+    if (!key_products.empty() && key_products.size() != 24) {
+        throw std::invalid_argument("Key products must be 24 ciphertexts");
+    }
+    key_products_ = std::move(key_products);
+}
+
+/**
+ * @brief 设置密钥流缓存
+ * @param store 密钥流缓存，可为nullptr
+ * @param key_id 该加密密钥在缓存中的标识
+ */
+void Transcipherer::set_keystream_store(KeystreamStore* store, const std::string& key_id) {
+    store_ = store;
+    key_id_ = key_id;
+}
+
+/**
+ * @brief 设置在线评估使用的模数切换计划
+ * @param schedule 模数切换计划
+ */
+void Transcipherer::set_mod_switch_schedule(std::vector<uint32_t> schedule) {
+    mod_switch_schedule_ = std::move(schedule);
+}
+
+/**
+ * @brief 每块的数据字数
+ */
+size_t Transcipherer::words_per_block() const {
+    return 36 - trunc_m_;
+}
+
+/**
+ * @brief 一批可转密的数据字数
+ */
+size_t Transcipherer::words_per_batch() const {
+    return fhe_.slot_count() * words_per_block();
+}
+
+/**
+ * @brief 计算数据字对应的客户端数据字节数
+ * @param words 数据字数
+ * @return 字节数
+ */
+double Transcipherer::data_bytes(size_t words) const {
+    return field_word_bytes(fhe_.params().plain_modulus, static_cast<double>(words));
+}
+
+/**
+ * @brief 转密
+ * @param nonce 客户端加密所用的随机数
+ * @param first_block sym_ct[0]所在块的索引
+ * @param sym_ct 对称密文
+ * @param n 数据字数
+ * @return 数据的FHE密文和计时
+ * @throws std::invalid_argument 当数据为空或块索引溢出时抛出异常
+ *
+ * 末批的块数按实际数据计算，评估时只计算这些块；末块不足的字复制到补零的缓冲区，
+ * 不要求调用方对输入补齐。
+ */
+TranscipherResult Transcipherer::transcipher(const std::vector<uint8_t>& nonce, uint32_t first_block,
+                                             const uint64_t* sym_ct, size_t n) {
+    if (n == 0 || sym_ct == nullptr) {
+        throw std::invalid_argument("Symmetric ciphertext is empty");
+    }
+    const size_t width = words_per_block();
+    const size_t nslots = fhe_.slot_count();
+    const size_t blocks = (n + width - 1) / width;
+    if (blocks - 1 > std::numeric_limits<uint32_t>::max() - first_block) {
+        throw std::invalid_argument("Block index overflows 32 bits");
+    }
+
+    TranscipherResult result;
+    result.words = n;
+    result.blocks = blocks;
+    result.batches = (blocks + nslots - 1) / nslots;
+    result.cipher_data.reserve(result.batches * width);
+
+    Timer timer;
+    timer.start();
+
+    std::vector<uint64_t> padded;
+    std::vector<Ciphertext> keystream;
+    std::vector<Ciphertext> batch_data;
+    for (size_t b = 0; b < result.batches; ++b) {
+        const size_t batch_first = b * nslots;
+        const size_t batch_blocks = std::min(nslots, blocks - batch_first);
+        const uint64_t* batch_ct = sym_ct + batch_first * width;
+        const size_t batch_words = std::min(batch_blocks * width, n - batch_first * width);
+        if (batch_words < batch_blocks * width) {
+            padded.assign(batch_blocks * width, 0);
+            std::copy(batch_ct, batch_ct + batch_words, padded.begin());
+            batch_ct = padded.data();
+        }
+
+        YuSEvalParams eval_params{nonce, level_, trunc_m_,
+                                  first_block + static_cast<uint32_t>(batch_first),
+                                  static_cast<uint32_t>(batch_blocks), mod_switch_schedule_};
+        if (store_ && store_->lookup(key_id_, eval_params, keystream)) {
+            ++result.keystream_hits;
+        } else {
+            result.keystream_ms += fhe_.evaluate_yus(cipher_key_, key_products_, eval_params, keystream);
+        }
+        result.strip_ms += fhe_.strip_keystream(keystream, batch_ct, batch_blocks, batch_data);
+        for (auto& ct : batch_data) {
+            result.cipher_data.push_back(std::move(ct));
+        }
+    }
+
+    timer.stop();
+    result.total_ms = timer.elapsed_ms();
+    result.throughput_kibps = throughput_kibps(fhe_.params().plain_modulus, static_cast<double>(n), result.total_ms);
+    return result;
+}
+
+} // namespace yus
@@ -4,16 +4,28 @@
  * @author Aurorp1g
  * @date 2025-11-07
  * 
- * 实现YuS流密码的通用工具函数，包括素数生成、数据转换、模运算和性能计时器。
+ * 实现YuS流密码的通用工具函数，包括素数生成、数据转换、模运算和内存统计。
  * 使用GMP库进行大数运算，OpenSSL提供密码学安全随机数。
  */
 
 #include "yus/utils.h"
+#include <fstream>
 #include <stdexcept>
-#include <chrono>
+#include <string>
 #include <gmpxx.h>
 #include <openssl/rand.h>
 
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
 namespace yus {
 
 /**
@@ -59,6 +71,52 @@ mpz_class generate_prime(uint32_t bits) {
     return p;
 }
 
+/**
+ * @brief 生成支持批处理的明文素数
+ * @param bits 素数位数
+ * @param poly_modulus_degree 环维数N
+ * @return 满足 p ≡ 2 mod 3 且 p ≡ 1 mod 2N 的素数
+ * @throws std::invalid_argument 当bits位内不存在满足条件的素数时抛出异常
+ * @throws std::runtime_error 当随机数生成失败时抛出异常
+ * 
+ * 候选素数形如 k·2N + 1，从随机的k开始在[2^(bits-1), 2^bits)内循环搜索。
+ */
+mpz_class generate_batching_prime(uint32_t bits, uint32_t poly_modulus_degree) {
+    const mpz_class step = mpz_class(2) * poly_modulus_degree;
+    if (bits < 2 || poly_modulus_degree == 0) {
+        throw std::invalid_argument("Invalid prime size or ring dimension");
+    }
+    const mpz_class lower = mpz_class(1) << (bits - 1);
+    const mpz_class upper = mpz_class(1) << bits;
+    const mpz_class k_min = (lower + step - 2) / step;   // 最小的k使k·2N+1 >= 2^(bits-1)
+    const mpz_class k_max = (upper - 2) / step;          // 最大的k使k·2N+1 < 2^bits
+    if (k_min > k_max) {
+        throw std::invalid_argument("No " + std::to_string(bits) + "-bit prime is 1 mod 2N");
+    }
+
+    gmp_randstate_t state;
+    gmp_randinit_default(state);
+    unsigned long seed;
+    if (RAND_bytes(reinterpret_cast<uint8_t*>(&seed), sizeof(seed)) != 1) {
+        gmp_randclear(state);
+        throw std::runtime_error("Failed to generate secure random seed");
+    }
+    gmp_randseed_ui(state, seed);
+
+    const mpz_class range = k_max - k_min + 1;
+    mpz_class offset;
+    mpz_urandomm(offset.get_mpz_t(), state, range.get_mpz_t());
+    gmp_randclear(state);
+
+    for (mpz_class n = 0; n < range; ++n) {
+        mpz_class p = (k_min + (offset + n) % range) * step + 1;
+        if (is_p_2mod3(p) && mpz_probab_prime_p(p.get_mpz_t(), 25) != 0) {
+            return p;
+        }
+    }
+    throw std::invalid_argument("No " + std::to_string(bits) + "-bit prime satisfies p = 2 mod 3 and p = 1 mod 2N");
+}
+
 /**
  * @brief 将大整数转换为字节数组
  * @param num 待转换的大整数
@@ -105,42 +163,139 @@ mpz_class mod(const mpz_class& a, const mpz_class& p) {
 }
 
 /**
- * @brief Timer构造函数
+ * @brief 64位模乘
+ * @param a 乘数
+ * @param b 乘数
+ * @param p 模数
+ * @return a * b mod p
  * 
- * 初始化计时器，设置起始和结束时间戳为0。
+ * 支持128位整数的编译器直接使用unsigned __int128；MSVC x64使用_umul128/_udiv128，
+ * 商须能放入64位，因此先把a、b约化到[0, p)；其他平台用mpz_import/mpz_export按64位字
+ * 读写GMP整数（Windows上unsigned long只有32位，不能用mpz_set_ui）。
  */
-Timer::Timer() : start_ticks_(0), stop_ticks_(0) {}
+uint64_t mul_mod(uint64_t a, uint64_t b, uint64_t p) {
+#if defined(__SIZEOF_INT128__)
+    __extension__ typedef unsigned __int128 uint128_t;
+    return static_cast<uint64_t>((static_cast<uint128_t>(a) * b) % p);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    uint64_t high = 0;
+    const uint64_t low = _umul128(a % p, b % p, &high);
+    uint64_t r = 0;
+    _udiv128(high, low, p, &r);
+    return r;
+#else
+    mpz_t x, y, m;
+    mpz_inits(x, y, m, nullptr);
+    mpz_import(x, 1, -1, sizeof(uint64_t), 0, 0, &a);
+    mpz_import(y, 1, -1, sizeof(uint64_t), 0, 0, &b);
+    mpz_import(m, 1, -1, sizeof(uint64_t), 0, 0, &p);
+    mpz_mul(x, x, y);
+    mpz_mod(x, x, m);
+    uint64_t r = 0;
+    mpz_export(&r, nullptr, -1, sizeof(uint64_t), 0, 0, x);
+    mpz_clears(x, y, m, nullptr);
+    return r;
+#endif
+}
 
 /**
- * @brief 开始计时
- * 
- * 记录当前时间作为起始时间戳，使用高精度时钟。
+ * @brief F_p字对应的数据字节数
  */
-void Timer::start() {
-    start_ticks_ = std::chrono::duration_cast<std::chrono::microseconds>(
-        std::chrono::high_resolution_clock::now().time_since_epoch()
-    ).count();
+double field_word_bytes(const mpz_class& p, double words) {
+    return words * static_cast<double>(mpz_sizeinbase(p.get_mpz_t(), 2)) / 8.0;
 }
 
 /**
- * @brief 停止计时
- * 
- * 记录当前时间作为结束时间戳，使用高精度时钟。
+ * @brief 吞吐量（KiB/s）
+ */
+double throughput_kibps(const mpz_class& p, double words, double elapsed_ms) {
+    return elapsed_ms > 0 ? (field_word_bytes(p, words) / 1024.0) / (elapsed_ms / 1000.0) : 0.0;
+}
+
+#if defined(__linux__)
+namespace {
+
+/**
+ * @brief 读取/proc/self/status中以KiB为单位的字段
+ * @param key 字段名，例如"VmRSS:"
+ * @return 字节数，字段不存在时返回0
+ */
+uint64_t read_proc_status_kib(const std::string& key) {
+    std::ifstream in("/proc/self/status");
+    std::string name;
+    uint64_t kib = 0;
+    while (in >> name) {
+        if (name == key) {
+            in >> kib;
+            return kib * 1024;
+        }
+        in.ignore(256, '\n');
+    }
+    return 0;
+}
+
+} // namespace
+#endif
+
+/**
+ * @brief 获取进程当前的常驻内存
+ * @return 字节数，平台不支持时返回0
  */
-void Timer::stop() {
-    stop_ticks_ = std::chrono::duration_cast<std::chrono::microseconds>(
-        std::chrono::high_resolution_clock::now().time_since_epoch()
-    ).count();
+uint64_t current_rss_bytes() {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) {
+        return static_cast<uint64_t>(pmc.WorkingSetSize);
+    }
+    return 0;
+#elif defined(__linux__)
+    return read_proc_status_kib("VmRSS:");
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief 获取进程常驻内存的峰值
+ * @return 字节数，平台不支持时返回0
+ */
+uint64_t peak_rss_bytes() {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) {
+        return static_cast<uint64_t>(pmc.PeakWorkingSetSize);
+    }
+    return 0;
+#elif defined(__linux__)
+    return read_proc_status_kib("VmHWM:");
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#if defined(__APPLE__)
+    return static_cast<uint64_t>(usage.ru_maxrss);          // macOS以字节计
+#else
+    return static_cast<uint64_t>(usage.ru_maxrss) * 1024;   // 其他Unix以KiB计
+#endif
+#endif
 }
 
 /**
- * @brief 获取经过的时间（毫秒）
- * @return 经过的时间（毫秒）
+ * @brief 把常驻内存峰值重置为当前值
+ * @return 重置成功返回true
  * 
- * 计算从开始计时到停止计时的时间间隔，转换为毫秒单位。
+ * Linux向/proc/self/clear_refs写入5重置VmHWM（内核4.0起支持）。
  */
-double Timer::elapsed_ms() const {
-    return static_cast<double>(stop_ticks_ - start_ticks_) / 1000.0;
+bool reset_peak_rss() {
+#if defined(__linux__)
+    std::ofstream out("/proc/self/clear_refs");
+    out << "5";
+    out.flush();
+    return static_cast<bool>(out);
+#else
+    return false;
+#endif
 }
 
 } // namespace yus
\ No newline at end of file
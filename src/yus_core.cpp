@@ -12,6 +12,7 @@
 #include "yus/utils.h"
 #include "yus/sbox.h"
 #include "yus/round_key.h"
+#include "yus/instrument.h"
 #include <stdexcept>
 #include <algorithm>
 
@@ -94,6 +95,7 @@ std::vector<mpz_class> YuSCipher::truncate(const std::vector<mpz_class>& state)
  * @return 白化后的状态向量
  */
 std::vector<mpz_class> YuSCipher::key_whitening(const std::vector<mpz_class>& state, uint32_t block_index) {
+    YUS_INSTRUMENT_SCOPE(Stage::WHITENING);
     auto rc0 = rk_gen_.generate_round_constant(0, block_index, p_);
     auto rk0 = rk_gen_.generate_round_key(master_key_, rc0, p_);
     return add_round_key(state, rk0, p_);
@@ -131,8 +133,12 @@ std::vector<mpz_class> YuSCipher::generate_keystream(uint32_t block_count) {
 
         // 轮变换
         for (uint32_t r = 1; r <= rounds; ++r) {
-            auto rc = rk_gen_.generate_round_constant(r, j, p_);
-            auto rk = rk_gen_.generate_round_key(master_key_, rc, p_);
+            std::vector<mpz_class> rk;
+            {
+                YUS_INSTRUMENT_SCOPE(Stage::ROUND_KEY);
+                auto rc = rk_gen_.generate_round_constant(r, j, p_);
+                rk = rk_gen_.generate_round_key(master_key_, rc, p_);
+            }
             state = round_transform(state, rk);
         }
 
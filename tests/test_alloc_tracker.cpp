@@ -0,0 +1,72 @@
+/**
+ * @file test_alloc_tracker.cpp
+ * @brief YuS流密码堆分配统计测试
+ * @author Aurorp1g
+ * @date 2025-11-07
+ *
+ * 使用Google Test框架对operator new/delete和GMP分配函数的统计进行单元测试。
+ */
+
+#include "yus/alloc_tracker.h"
+#include <gmpxx.h>
+#include <gtest/gtest.h>
+#include <thread>
+
+/**
+ * @test AllocTrackerTest.CountsNewAndGmp
+ * @brief 测试operator new和GMP分配的计数
+ *
+ * 验证：
+ * - 未编译分配统计时所有计数为0
+ * - new/delete各计一次，字节数不少于请求的大小
+ * - 超过一个limb的mpz_class运算经GMP分配函数计数
+ * - 纯整数运算不产生分配
+ * - 其他线程的分配计入该线程和全局计数
+ */
+TEST(AllocTrackerTest, CountsNewAndGmp) {
+    if (!yus::alloc_tracking_enabled()) {
+        EXPECT_EQ(yus::alloc_counts().allocations, 0u);
+        EXPECT_EQ(yus::thread_alloc_counts().allocations, 0u);
+        return;
+    }
+
+    auto before = yus::thread_alloc_counts();
+    {
+        uint64_t* volatile buffer = new uint64_t[64];
+        delete[] buffer;
+    }
+    auto delta = yus::thread_alloc_counts() - before;
+    EXPECT_EQ(delta.allocations, 1u);
+    EXPECT_GE(delta.bytes, 64u * sizeof(uint64_t));
+    EXPECT_EQ(delta.frees, 1u);
+
+    before = yus::thread_alloc_counts();
+    {
+        mpz_class big("340282366920938463463374607431768211457");
+        big *= big;
+    }
+    delta = yus::thread_alloc_counts() - before;
+    EXPECT_GT(delta.allocations, 0u);
+    EXPECT_GT(delta.frees, 0u);
+
+    before = yus::thread_alloc_counts();
+    volatile uint64_t sink = 0;
+    for (uint64_t i = 0; i < 1000; ++i) {
+        sink = sink + i * i % 65537;
+    }
+    delta = yus::thread_alloc_counts() - before;
+    EXPECT_EQ(delta.allocations, 0u);
+
+    const auto global_before = yus::alloc_counts();
+    yus::AllocCounts worker_delta;
+    std::thread worker([&worker_delta] {
+        const auto start = yus::thread_alloc_counts();
+        // 经volatile指针访问，防止编译器省略成对的new/delete
+        int* volatile value = new int(7);
+        delete value;
+        worker_delta = yus::thread_alloc_counts() - start;
+    });
+    worker.join();
+    EXPECT_EQ(worker_delta.allocations, 1u);
+    EXPECT_GE((yus::alloc_counts() - global_before).allocations, 1u);
+}
@@ -14,6 +14,10 @@
 #include <gtest/gtest.h>
 #include <iostream>
 #include <chrono>
+#include <filesystem>
+#include <limits>
+#include <sstream>
+#include <utility>
 
 /**
  * @test FHEWrapperTest.InitBGV
@@ -87,7 +91,7 @@ TEST(FHEWrapperTest, InitBFV) {
         yus::FHEParams params;
         params.security_level = 80;                // 80位安全级别
         params.poly_modulus_degree = 4096;         // 多项式模数次数（增加到4096以支持密钥交换）
-        params.plain_modulus = yus::generate_prime(17);  // 17位素数作为明文模数
+        params.plain_modulus = yus::generate_batching_prime(17, 4096);  // 17位批处理素数作为明文模数
         params.cipher_modulus_bits = 200;          // 密文模数位数（增加到200）
         
         std::cout << "[PARAMS] Security: " << params.security_level 
@@ -165,7 +169,7 @@ TEST(FHEWrapperTest, EncryptDecryptBGV) {
         
         // 计时：加密时间
         start = std::chrono::high_resolution_clock::now();
-        std::vector<yus::FHEWrapper::CiphertextPtr> cipher;
+        std::vector<yus::Ciphertext> cipher;
         wrapper.encrypt(plain, cipher);
         end = std::chrono::high_resolution_clock::now();
         
@@ -184,12 +188,13 @@ TEST(FHEWrapperTest, EncryptDecryptBGV) {
                   << " ms" << std::endl;
         std::cout << "[DATA] Decrypted vector size: " << decrypted.size() << std::endl;
         
-        // ✅ BGV方案：解密向量大小应该等于明文向量大小
-        EXPECT_EQ(decrypted.size(), plain.size());
+        // BGV方案按槽打包：4个元素占用一个密文，解密返回该密文的全部槽
+        EXPECT_EQ(cipher.size(), 1ULL);
+        EXPECT_EQ(decrypted.size(), wrapper.slot_count());
         
-        // 验证每个解密元素与原始明文匹配
-        for (size_t i = 0; i < plain.size(); ++i) {
-            EXPECT_EQ(decrypted[i], plain[i]) << "Mismatch at index " << i;
+        // 验证前plain.size()个解密元素与原始明文匹配，其余槽为0
+        for (size_t i = 0; i < decrypted.size(); ++i) {
+            EXPECT_EQ(decrypted[i], i < plain.size() ? plain[i] : 0) << "Mismatch at index " << i;
         }
         
         std::cout << "[SUCCESS] BGV encryption/decryption test completed" << std::endl;
@@ -218,7 +223,7 @@ TEST(FHEWrapperTest, EncryptDecryptBFV) {
         yus::FHEParams params;
         params.security_level = 80;                // 80位安全级别
         params.poly_modulus_degree = 4096;         // 增加到4096以支持密钥交换
-        params.plain_modulus = yus::generate_prime(17);  // 17位素数作为明文模数
+        params.plain_modulus = yus::generate_batching_prime(17, 4096);  // 17位批处理素数作为明文模数
         params.cipher_modulus_bits = 200;          // 增加到200
         
         std::cout << "[PARAMS] Security: " << params.security_level 
@@ -242,7 +247,7 @@ TEST(FHEWrapperTest, EncryptDecryptBFV) {
         
         // 计时：加密时间
         start = std::chrono::high_resolution_clock::now();
-        std::vector<yus::FHEWrapper::CiphertextPtr> cipher;
+        std::vector<yus::Ciphertext> cipher;
         wrapper.encrypt(plain, cipher);
         end = std::chrono::high_resolution_clock::now();
         
@@ -295,7 +300,7 @@ TEST(FHEWrapperTest, MemoryTest) {
         yus::FHEParams params;
         params.security_level = 80;                // 80位安全级别
         params.poly_modulus_degree = 1024;         // 最小参数
-        params.plain_modulus = yus::generate_prime(8);  // 更小的素数（8位）
+        params.plain_modulus = yus::generate_batching_prime(17, 1024);  // p ≡ 1 mod 2048的最小可用素数位数
         params.cipher_modulus_bits = 50;           // 最小参数
         
         std::cout << "[MINIMAL PARAMS] Security: " << params.security_level 
@@ -307,16 +312,885 @@ TEST(FHEWrapperTest, MemoryTest) {
         
         // 使用最小数据量进行测试
         std::vector<mpz_class> plain(2, 1);  // 最小数据（2元素向量）
-        std::vector<yus::FHEWrapper::CiphertextPtr> cipher;
+        std::vector<yus::Ciphertext> cipher;
         wrapper.encrypt(plain, cipher);
         auto decrypted = wrapper.decrypt(cipher);
         
-        // 验证解密结果大小正确
-        EXPECT_EQ(decrypted.size(), 2ULL); 
+        // 验证解密结果为一个密文的全部槽
+        EXPECT_EQ(cipher.size(), 1ULL);
+        EXPECT_EQ(decrypted.size(), wrapper.slot_count());
         std::cout << "[SUCCESS] Memory test completed with minimal parameters" << std::endl;
         
     } catch (const std::exception& e) {
         std::cout << "[EXCEPTION] Memory test failed: " << e.what() << std::endl;
         FAIL() << "Exception in memory test: " << e.what();
     }
-}
\ No newline at end of file
+}
+
+/**
+ * @test FHEWrapperTest.ModSwitchScheduleBFV
+ * @brief 测试模数切换计划的校验
+ * 
+ * 验证同态评估在开始计算前拒绝无效的模数切换计划：
+ * - 阶段数超过轮数+1
+ * - 丢弃的模数总数超过模数链容量
+ */
+TEST(FHEWrapperTest, ModSwitchScheduleBFV) {
+    std::cout << "[TEST INFO] Testing modulus switching schedule validation..." << std::endl;
+    
+    try {
+        yus::FHEParams params;
+        params.security_level = 80;
+        params.poly_modulus_degree = 4096;
+        params.plain_modulus = yus::generate_batching_prime(17, 4096);
+        params.cipher_modulus_bits = 200;
+        
+        yus::FHEWrapper wrapper(yus::FHE_SCHEME::BFV, params);
+        std::cout << "[DATA] Modulus switching capacity: " << wrapper.mod_switch_capacity() << std::endl;
+        
+        std::vector<mpz_class> master_key(36, 1);
+        std::vector<yus::Ciphertext> cipher_key;
+        wrapper.encrypt_key(master_key, cipher_key);
+        
+        std::vector<yus::Ciphertext> cipher_ks;
+        yus::YuSEvalParams eval_params{{0x01, 0x02, 0x03, 0x04}, yus::SecurityLevel::SEC80, 12, 0, 1, {}};
+        
+        // 5轮只有6个切换阶段（白化后+每轮后）
+        eval_params.mod_switch_schedule = std::vector<uint32_t>(7, 0);
+        EXPECT_THROW(wrapper.evaluate_yus(cipher_key, eval_params, cipher_ks), std::invalid_argument);
+        
+        // 丢弃的模数超过模数链容量
+        eval_params.mod_switch_schedule = {static_cast<uint32_t>(wrapper.mod_switch_capacity() + 1)};
+        EXPECT_THROW(wrapper.evaluate_yus(cipher_key, eval_params, cipher_ks), std::invalid_argument);
+        
+        std::cout << "[SUCCESS] Modulus switching schedule validation completed" << std::endl;
+        
+    } catch (const std::exception& e) {
+        std::cout << "[EXCEPTION] Modulus switching test failed: " << e.what() << std::endl;
+        FAIL() << "Exception in modulus switching test: " << e.what();
+    }
+}
+
+/**
+ * @test FHEWrapperTest.KeyProductsBFV
+ * @brief 测试加密密钥乘积
+ * 
+ * 验证服务端预计算与客户端加密的密钥乘积一致：
+ * - 第2s个乘积为k_{3s}·k_{3s+2}，第2s+1个为k_{3s}·k_{3s+1}
+ * - 两种方式解密后的槽值相同
+ * - 乘积数量不正确时评估被拒绝
+ */
+TEST(FHEWrapperTest, KeyProductsBFV) {
+    std::cout << "[TEST INFO] Testing encrypted key products..." << std::endl;
+    
+    try {
+        yus::FHEParams params;
+        params.security_level = 80;
+        params.poly_modulus_degree = 4096;
+        params.plain_modulus = yus::generate_batching_prime(17, 4096);
+        params.cipher_modulus_bits = 200;
+        
+        yus::FHEWrapper wrapper(yus::FHE_SCHEME::BFV, params);
+        
+        // 使用小密钥元素，乘积不超过明文模数
+        std::vector<mpz_class> master_key(36);
+        for (size_t i = 0; i < 36; ++i) {
+            master_key[i] = static_cast<unsigned long>(i + 2);
+        }
+        std::vector<yus::Ciphertext> cipher_key;
+        wrapper.encrypt_key(master_key, cipher_key);
+        
+        std::vector<yus::Ciphertext> server_products;
+        wrapper.precompute_key_products(cipher_key, server_products);
+        std::vector<yus::Ciphertext> client_products;
+        wrapper.encrypt_key_products(master_key, client_products);
+        
+        ASSERT_EQ(server_products.size(), 24ULL);
+        ASSERT_EQ(client_products.size(), 24ULL);
+        
+        for (size_t idx = 0; idx < 24; ++idx) {
+            const size_t base = 3 * (idx / 2);
+            const size_t other = (idx % 2 == 0) ? base + 2 : base + 1;
+            mpz_class expected = master_key[base] * master_key[other];
+            
+            auto server_plain = wrapper.decrypt({server_products[idx]});
+            auto client_plain = wrapper.decrypt({client_products[idx]});
+            EXPECT_EQ(server_plain[0], expected) << "Server product mismatch at " << idx;
+            EXPECT_EQ(client_plain[0], expected) << "Client product mismatch at " << idx;
+        }
+        
+        // 乘积数量不正确
+        std::vector<yus::Ciphertext> cipher_ks;
+        std::vector<yus::Ciphertext> partial(server_products.begin(), server_products.begin() + 5);
+        yus::YuSEvalParams eval_params{{0x01, 0x02, 0x03, 0x04}, yus::SecurityLevel::SEC80, 12, 0, 1, {}};
+        EXPECT_THROW(wrapper.evaluate_yus(cipher_key, partial, eval_params, cipher_ks), std::invalid_argument);
+        
+        std::cout << "[SUCCESS] Encrypted key products test completed" << std::endl;
+        
+    } catch (const std::exception& e) {
+        std::cout << "[EXCEPTION] Key products test failed: " << e.what() << std::endl;
+        FAIL() << "Exception in key products test: " << e.what();
+    }
+}
+
+/**
+ * @test FHEWrapperTest.KeyProductsEvalBFV
+ * @brief 测试使用密钥乘积的同态评估与明文密钥流一致
+ *
+ * 验证第一轮以密钥乘积代替密文乘法后，评估结果解密等于YuSCipher的密钥流：
+ * - 服务端预计算的乘积和客户端上传的乘积
+ * - 白化后不切换模数，以及白化后丢弃一个模数（乘积随状态一起切换到同层）
+ * - 非零首块，覆盖计数器槽向量
+ */
+TEST(FHEWrapperTest, KeyProductsEvalBFV) {
+    std::cout << "[TEST INFO] Testing evaluation with encrypted key products..." << std::endl;
+
+    try {
+        const mpz_class p(65537);
+        const auto level = yus::SecurityLevel::SEC80;
+        auto params = yus::select_fhe_params(yus::FHE_SCHEME::BFV, p, 80, static_cast<uint32_t>(level));
+        yus::FHEWrapper wrapper(yus::FHE_SCHEME::BFV, params);
+        ASSERT_GE(wrapper.mod_switch_capacity(), 1u);
+
+        std::vector<mpz_class> master_key(36);
+        for (size_t i = 0; i < 36; ++i) {
+            master_key[i] = static_cast<unsigned long>((4099 * i + 17) % 65537);
+        }
+        std::vector<yus::Ciphertext> cipher_key;
+        wrapper.encrypt_key(master_key, cipher_key);
+        std::vector<yus::Ciphertext> server_products;
+        wrapper.precompute_key_products(cipher_key, server_products);
+        std::vector<yus::Ciphertext> client_products;
+        wrapper.encrypt_key_products(master_key, client_products);
+
+        const std::vector<uint8_t> nonce{0x05, 0x06, 0x07};
+        const uint32_t first_block = 2;
+        const uint32_t block_count = 4;
+        yus::YuSCipher cipher(p, level, 12);
+        cipher.init(master_key, nonce);
+        const auto expected = cipher.generate_keystream(first_block + block_count);
+        const size_t nslots = wrapper.slot_count();
+
+        const std::vector<std::pair<const char*, const std::vector<yus::Ciphertext>*>> sources{
+            {"server", &server_products}, {"client", &client_products}};
+        for (const auto& source : sources) {
+            for (uint32_t first_switch : {0u, 1u}) {
+                yus::YuSEvalParams eval_params{nonce, level, 12, first_block, block_count, {first_switch}};
+                std::vector<yus::Ciphertext> cipher_ks;
+                const double ms = wrapper.evaluate_yus(cipher_key, *source.second, eval_params, cipher_ks);
+                std::cout << "[RESULTS] " << source.first << " products, mod_switch_schedule[0]=" << first_switch
+                          << ": " << ms << " ms" << std::endl;
+
+                ASSERT_EQ(cipher_ks.size(), 24u);
+                auto decrypted = wrapper.decrypt(cipher_ks);
+                for (uint32_t b = 0; b < block_count; ++b) {
+                    for (size_t i = 0; i < 24; ++i) {
+                        EXPECT_EQ(decrypted[i * nslots + b], expected[(first_block + b) * 24 + i])
+                            << source.first << " products, mod_switch_schedule[0]=" << first_switch
+                            << ", block " << first_block + b << ", word " << i;
+                    }
+                }
+            }
+        }
+
+        std::cout << "[SUCCESS] Key products evaluation test completed" << std::endl;
+
+    } catch (const std::exception& e) {
+        std::cout << "[EXCEPTION] Key products evaluation test failed: " << e.what() << std::endl;
+        FAIL() << "Exception in key products evaluation test: " << e.what();
+    }
+}
+
+/**
+ * @test FHEWrapperTest.SelectParams
+ * @brief 测试FHE参数自动选择
+ * 
+ * 验证select_fhe_params：
+ * - 选出的环维数满足p ≡ 1 mod 2N，模数链总位数不超过安全上限
+ * - 模数链至少为每轮提供一个可丢弃的素数
+ * - 安全级别越高、轮数越多，选出的参数不会更小
+ * - 指定环维数时使用该N，该N容纳不下时抛出异常
+ * - p不支持任何环维数的批处理时抛出异常
+ * - BGV的p超出HElib的long范围时抛出异常
+ */
+TEST(FHEWrapperTest, SelectParams) {
+    const mpz_class p(65537);
+
+    auto bfv80 = yus::select_fhe_params(yus::FHE_SCHEME::BFV, p, 80, 5);
+    auto bfv128 = yus::select_fhe_params(yus::FHE_SCHEME::BFV, p, 128, 5);
+    auto bfv128_r6 = yus::select_fhe_params(yus::FHE_SCHEME::BFV, p, 128, 6);
+    auto bgv128 = yus::select_fhe_params(yus::FHE_SCHEME::BGV, p, 128, 5);
+
+    std::cout << "[PARAMS] BFV 80-bit: N=" << bfv80.poly_modulus_degree
+              << ", BFV 128-bit: N=" << bfv128.poly_modulus_degree
+              << ", BGV 128-bit: m=" << bgv128.cyclotomic_index << std::endl;
+
+    for (const auto* params : {&bfv80, &bfv128, &bfv128_r6, &bgv128}) {
+        EXPECT_EQ(params->plain_modulus % (2 * params->poly_modulus_degree), 1);
+        EXPECT_EQ(params->cyclotomic_index, 2 * params->poly_modulus_degree);
+
+        for (int bits : params->coeff_modulus_bits) {
+            EXPECT_LE(bits, 60);
+        }
+    }
+    auto total_bits = [](const yus::FHEParams& params) {
+        int total = 0;
+        for (int bits : params.coeff_modulus_bits) {
+            total += bits;
+        }
+        return total;
+    };
+
+    // 128位安全下N=8192最多218位，不足以容纳5轮；N=16384最多438位
+    EXPECT_EQ(bfv128.poly_modulus_degree, 16384U);
+    EXPECT_LE(total_bits(bfv128), 438);
+    EXPECT_LE(total_bits(bfv128_r6), 438);
+    EXPECT_LE(bfv80.poly_modulus_degree, bfv128.poly_modulus_degree);
+    EXPECT_GE(bfv128.coeff_modulus_bits.size(), 5U + 2U);      // 6个数据素数 + 特殊素数
+    EXPECT_GE(bfv128_r6.cipher_modulus_bits, bfv128.cipher_modulus_bits);
+
+    // 固定N=32768时模数链仍按电路深度划分，但位数上限更宽
+    auto bfv128_n32k = yus::select_fhe_params(yus::FHE_SCHEME::BFV, p, 128, 5, 10, yus::PackingMode::ROW, 32768);
+    EXPECT_EQ(bfv128_n32k.poly_modulus_degree, 32768U);
+    EXPECT_EQ(bfv128_n32k.coeff_modulus_bits.size(), bfv128.coeff_modulus_bits.size());
+    EXPECT_THROW(yus::select_fhe_params(yus::FHE_SCHEME::BFV, p, 128, 5, 10, yus::PackingMode::ROW, 4096),
+                 std::invalid_argument);
+
+    // 65543 ≡ 2 mod 3，但不满足任何N >= 1024的p ≡ 1 mod 2N
+    EXPECT_THROW(yus::select_fhe_params(yus::FHE_SCHEME::BFV, mpz_class(65543), 128, 5), std::invalid_argument);
+    EXPECT_THROW(yus::select_fhe_params(yus::FHE_SCHEME::BFV, p, 100, 5), std::invalid_argument);
+
+    // HElib以long保存p，long为32位时33位的p必须被拒绝而不是截断
+    const mpz_class p33("4298506241");
+    if (std::numeric_limits<long>::digits < 33) {
+        EXPECT_THROW(yus::select_fhe_params(yus::FHE_SCHEME::BGV, p33, 128, 5), std::invalid_argument);
+    } else {
+        EXPECT_EQ(yus::select_fhe_params(yus::FHE_SCHEME::BGV, p33, 128, 5).plain_modulus, p33);
+    }
+}
+
+/**
+ * @test FHEWrapperTest.NoiseTelemetryBFV
+ * @brief 测试同态评估的噪声遥测与正确性
+ * 
+ * 使用自动选择的参数评估4个块的YuS，验证：
+ * - 报告包含白化、每轮和最终层共rounds+2个阶段，噪声预算为正且不增加
+ * - 解密得到的密钥流与明文YuSCipher一致
+ * - 吞吐量按每字⌈log2 p⌉比特计算
+ * - 噪声预算低于阈值时评估中止，报告保留已记录的阶段
+ * - YUS_ALLOC_TRACKING构建时每个噪声阶段都有对应的分配计数
+ */
+TEST(FHEWrapperTest, NoiseTelemetryBFV) {
+    std::cout << "[TEST INFO] Testing noise budget telemetry..." << std::endl;
+    
+    try {
+        const mpz_class p(65537);
+        const auto level = yus::SecurityLevel::SEC80;
+        const uint32_t rounds = static_cast<uint32_t>(level);
+        auto params = yus::select_fhe_params(yus::FHE_SCHEME::BFV, p, 80, rounds);
+        yus::FHEWrapper wrapper(yus::FHE_SCHEME::BFV, params);
+        
+        std::vector<mpz_class> master_key(36);
+        for (size_t i = 0; i < 36; ++i) {
+            master_key[i] = static_cast<unsigned long>(1000 * i + 7);
+        }
+        std::vector<uint8_t> nonce = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08};
+        std::vector<yus::Ciphertext> cipher_key;
+        wrapper.encrypt_key(master_key, cipher_key);
+        
+        yus::YuSEvalParams eval_params{nonce, level, 12, 0, 4, {}};
+        eval_params.noise_telemetry = true;
+        std::vector<yus::Ciphertext> cipher_ks;
+        yus::YuSEvalReport report;
+        wrapper.evaluate_yus(cipher_key, {}, eval_params, cipher_ks, report);
+        
+        ASSERT_EQ(report.stages.size(), rounds + 2);
+        EXPECT_EQ(report.stages.front().stage, "whitening");
+        EXPECT_EQ(report.stages.back().stage, "final");
+        for (size_t s = 0; s < report.stages.size(); ++s) {
+            const auto& stage = report.stages[s];
+            std::cout << "[NOISE] " << stage.stage << ": " << stage.noise_budget_bits << " bits, modulus "
+                      << stage.modulus_bits << " bits, " << stage.elapsed_ms << " ms" << std::endl;
+            EXPECT_GT(stage.noise_budget_bits, 0.0) << "Stage " << stage.stage;
+            if (s > 0) {
+                EXPECT_LE(stage.noise_budget_bits, report.stages[s - 1].noise_budget_bits);
+            }
+        }
+        
+        // 分配计数与噪声遥测按相同的阶段边界记录
+        if (yus::alloc_tracking_enabled()) {
+            ASSERT_EQ(report.alloc_stages.size(), report.stages.size());
+            for (size_t s = 0; s < report.alloc_stages.size(); ++s) {
+                EXPECT_EQ(report.alloc_stages[s].stage, report.stages[s].stage);
+                std::cout << "[ALLOC] " << report.alloc_stages[s].stage << ": "
+                          << report.alloc_stages[s].allocs.allocations << " allocations, "
+                          << report.alloc_stages[s].allocs.bytes << " bytes" << std::endl;
+            }
+        } else {
+            EXPECT_TRUE(report.alloc_stages.empty());
+        }
+        
+        // 与明文实现逐元素比较：第i个密文的槽j为块j的第i个密钥流元素
+        yus::YuSCipher cipher(p, level, 12);
+        cipher.init(master_key, nonce);
+        auto expected = cipher.generate_keystream(4);
+        auto decrypted = wrapper.decrypt(cipher_ks);
+        const size_t nslots = wrapper.slot_count();
+        ASSERT_EQ(cipher_ks.size(), 24ULL);
+        for (size_t j = 0; j < 4; ++j) {
+            for (size_t i = 0; i < 24; ++i) {
+                EXPECT_EQ(decrypted[i * nslots + j], expected[j * 24 + i]) << "Block " << j << ", element " << i;
+            }
+        }
+        
+        // 吞吐量按每字17比特计：1024块·24字·17比特/8 = 51 KiB，用时1秒
+        EXPECT_DOUBLE_EQ(wrapper.get_throughput(1024, 12, 1000.0), 51.0);
+        
+        // 阈值高于新鲜密文的噪声预算：白化后即中止
+        eval_params.noise_telemetry = false;
+        eval_params.min_noise_budget = 10000;
+        EXPECT_THROW(wrapper.evaluate_yus(cipher_key, {}, eval_params, cipher_ks, report), std::runtime_error);
+        EXPECT_EQ(report.stages.size(), 1ULL);
+        
+        std::cout << "[SUCCESS] Noise telemetry test completed" << std::endl;
+        
+    } catch (const std::exception& e) {
+        std::cout << "[EXCEPTION] Noise telemetry test failed: " << e.what() << std::endl;
+        FAIL() << "Exception in noise telemetry test: " << e.what();
+    }
+}
+
+/**
+ * @test FHEWrapperTest.TraceBFV
+ * @brief 测试同态评估的时间线记录
+ * 
+ * 不使用密钥乘积评估YuS-80，验证：
+ * - 每轮一个round事件，另有白化和最终线性层事件
+ * - 每轮12个S盒事件和24次重线性化事件，均带有密文层级
+ * - 线性层分块事件被记录
+ * - 时间线可写成Chrome trace-event JSON
+ */
+TEST(FHEWrapperTest, TraceBFV) {
+    std::cout << "[TEST INFO] Testing evaluation trace..." << std::endl;
+    
+    try {
+        const mpz_class p(65537);
+        const auto level = yus::SecurityLevel::SEC80;
+        const uint32_t rounds = static_cast<uint32_t>(level);
+        auto params = yus::select_fhe_params(yus::FHE_SCHEME::BFV, p, 80, rounds);
+        yus::FHEWrapper wrapper(yus::FHE_SCHEME::BFV, params);
+        
+        std::vector<mpz_class> master_key(36);
+        for (size_t i = 0; i < 36; ++i) {
+            master_key[i] = static_cast<unsigned long>(1000 * i + 7);
+        }
+        std::vector<uint8_t> nonce = {0x01, 0x02, 0x03, 0x04};
+        std::vector<yus::Ciphertext> cipher_key;
+        wrapper.encrypt_key(master_key, cipher_key);
+        
+        yus::TraceRecorder recorder;
+        yus::YuSEvalParams eval_params{nonce, level, 12, 0, 1, {}};
+        eval_params.trace = &recorder;
+        std::vector<yus::Ciphertext> cipher_ks;
+        wrapper.evaluate_yus(cipher_key, {}, eval_params, cipher_ks);
+        
+        size_t round_spans = 0;
+        size_t sbox_spans = 0;
+        size_t relin_spans = 0;
+        size_t other_round_spans = 0;
+        for (const auto& event : recorder.events()) {
+            if (event.name == "round") {
+                ++round_spans;
+            } else if (event.name == "sbox") {
+                ++sbox_spans;
+                EXPECT_GE(event.level, 0);
+            } else if (event.name == "relinearize") {
+                ++relin_spans;
+                EXPECT_GE(event.level, 0);
+            } else if (event.category == "round") {
+                ++other_round_spans;
+            }
+        }
+        EXPECT_EQ(round_spans, rounds);
+        EXPECT_EQ(sbox_spans, 12ULL * rounds);
+        EXPECT_EQ(relin_spans, 24ULL * rounds);
+        EXPECT_EQ(other_round_spans, 2ULL);
+        
+        std::ostringstream json;
+        recorder.write_json(json);
+        EXPECT_NE(json.str().find("\"traceEvents\""), std::string::npos);
+        EXPECT_NE(json.str().find("\"cat\":\"linear_layer\""), std::string::npos);
+        
+        std::cout << "[SUCCESS] Trace test completed: " << recorder.size() << " events" << std::endl;
+        
+    } catch (const std::exception& e) {
+        std::cout << "[EXCEPTION] Trace test failed: " << e.what() << std::endl;
+        FAIL() << "Exception in trace test: " << e.what();
+    }
+}
+
+/**
+ * @test FHEWrapperTest.SlotPackingBGV
+ * @brief 测试BGV按槽打包加密解密
+ * 
+ * 验证跨越多个密文的输入：
+ * - 密文数量为ceil(n / slot_count())
+ * - 解密结果与pack_plaintext逐元素相等（含模p约简和末块补零）
+ */
+TEST(FHEWrapperTest, SlotPackingBGV) {
+    std::cout << "[TEST INFO] Testing BGV slot packing..." << std::endl;
+    
+    try {
+        yus::FHEParams params;
+        params.security_level = 80;
+        params.poly_modulus_degree = 2048;
+        params.plain_modulus = yus::generate_batching_prime(17, 2048);  // p ≡ 1 mod m，每个槽为F_p
+        params.cipher_modulus_bits = 100;
+        
+        yus::FHEWrapper wrapper(yus::FHE_SCHEME::BGV, params);
+        const size_t nslots = wrapper.slot_count();
+        std::cout << "[DATA] Slot count: " << nslots << std::endl;
+        EXPECT_EQ(nslots, 2048ULL);
+        
+        std::vector<mpz_class> plain(2 * nslots + 3);
+        for (size_t i = 0; i < plain.size(); ++i) {
+            plain[i] = params.plain_modulus - 1 - static_cast<unsigned long>(i);
+        }
+        plain[1] = params.plain_modulus + 5;   // 模p约简为5
+        
+        std::vector<yus::Ciphertext> cipher;
+        wrapper.encrypt(plain, cipher);
+        EXPECT_EQ(cipher.size(), 3ULL);
+        
+        auto decrypted = wrapper.decrypt(cipher);
+        auto packed = wrapper.pack_plaintext(plain);
+        ASSERT_EQ(decrypted.size(), 3 * nslots);
+        ASSERT_EQ(packed.size(), decrypted.size());
+        EXPECT_EQ(packed[1], 5);
+        for (size_t i = 0; i < decrypted.size(); ++i) {
+            EXPECT_EQ(decrypted[i], packed[i]) << "Mismatch at index " << i;
+        }
+        
+        std::cout << "[SUCCESS] BGV slot packing test completed" << std::endl;
+        
+    } catch (const std::exception& e) {
+        std::cout << "[EXCEPTION] BGV slot packing test failed: " << e.what() << std::endl;
+        FAIL() << "Exception in BGV slot packing test: " << e.what();
+    }
+}
+
+/**
+ * @test FHEWrapperTest.CiphertextPoolBFV
+ * @brief 测试密文对象池复用
+ * 
+ * 验证：
+ * - 预热后再次评估不再新建密文对象
+ * - 输出向量中与其他句柄共享的密文不会被原地覆盖
+ * - 句柄类型与方案不符时抛出异常
+ */
+TEST(FHEWrapperTest, CiphertextPoolBFV) {
+    std::cout << "[TEST INFO] Testing ciphertext pool reuse..." << std::endl;
+    
+    try {
+        const mpz_class p(65537);
+        const auto level = yus::SecurityLevel::SEC80;
+        auto params = yus::select_fhe_params(yus::FHE_SCHEME::BFV, p, 80, static_cast<uint32_t>(level));
+        yus::FHEWrapper wrapper(yus::FHE_SCHEME::BFV, params);
+        
+        std::vector<mpz_class> master_key(36);
+        for (size_t i = 0; i < 36; ++i) {
+            master_key[i] = static_cast<unsigned long>(31 * i + 5);
+        }
+        std::vector<yus::Ciphertext> cipher_key;
+        wrapper.encrypt_key(master_key, cipher_key);
+        
+        yus::YuSEvalParams eval_params{{0x01, 0x02, 0x03}, level, 12, 0, 4, {}};
+        std::vector<yus::Ciphertext> cipher_ks;
+        wrapper.evaluate_yus(cipher_key, eval_params, cipher_ks);
+        auto first = wrapper.decrypt(cipher_ks);
+        
+        // 保留第一次的输出句柄，第二次评估必须写入新的密文
+        std::vector<yus::Ciphertext> held = cipher_ks;
+        const auto warm = wrapper.ciphertext_pool_stats();
+        wrapper.evaluate_yus(cipher_key, eval_params, cipher_ks);
+        const auto after = wrapper.ciphertext_pool_stats();
+        std::cout << "[DATA] Acquires: " << after.acquires << ", allocations: " << after.allocations
+                  << ", idle: " << after.idle << std::endl;
+        
+        EXPECT_GT(after.acquires, warm.acquires);
+        EXPECT_EQ(after.allocations - warm.allocations, held.size());
+        EXPECT_EQ(wrapper.decrypt(held), first);
+        EXPECT_EQ(wrapper.decrypt(cipher_ks), first);
+        
+        // 释放所有输出后，第三次评估完全复用空闲对象
+        held.clear();
+        const auto before_third = wrapper.ciphertext_pool_stats();
+        wrapper.evaluate_yus(cipher_key, eval_params, cipher_ks);
+        EXPECT_EQ(wrapper.ciphertext_pool_stats().allocations, before_third.allocations);
+        
+        EXPECT_THROW(cipher_key[0].helib(), std::runtime_error);
+        EXPECT_THROW(yus::Ciphertext().seal(), std::runtime_error);
+        
+        std::cout << "[SUCCESS] Ciphertext pool test completed" << std::endl;
+        
+    } catch (const std::exception& e) {
+        std::cout << "[EXCEPTION] Ciphertext pool test failed: " << e.what() << std::endl;
+        FAIL() << "Exception in ciphertext pool test: " << e.what();
+    }
+}
+
+/**
+ * @test FHEWrapperTest.SaveLoadBFV
+ * @brief 测试BFV上下文、参数和密钥的保存与加载
+ * 
+ * 验证：
+ * - 完整加载的实例能解密原实例加密的密文
+ * - 评估模式只加载公钥和重线性化密钥，评估结果可由持有私钥的实例解密
+ * - 评估模式下解密抛出异常，且保存时不写出私钥
+ */
+TEST(FHEWrapperTest, SaveLoadBFV) {
+    std::cout << "[TEST INFO] Testing key persistence..." << std::endl;
+    
+    const auto dir = std::filesystem::temp_directory_path() / "yus_fhe_keys_test";
+    const auto eval_dir = std::filesystem::temp_directory_path() / "yus_fhe_keys_test_eval";
+    try {
+        const mpz_class p(65537);
+        const auto level = yus::SecurityLevel::SEC80;
+        auto params = yus::select_fhe_params(yus::FHE_SCHEME::BFV, p, 80, static_cast<uint32_t>(level));
+        yus::FHEWrapper client(yus::FHE_SCHEME::BFV, params);
+        client.save(dir.string());
+        
+        std::vector<mpz_class> master_key(36);
+        for (size_t i = 0; i < 36; ++i) {
+            master_key[i] = static_cast<unsigned long>(17 * i + 3);
+        }
+        std::vector<yus::Ciphertext> cipher_key;
+        client.encrypt_key(master_key, cipher_key);
+        
+        // 完整加载：同一私钥
+        auto start = std::chrono::high_resolution_clock::now();
+        yus::FHEWrapper restored(dir.string());
+        auto end = std::chrono::high_resolution_clock::now();
+        std::cout << "[TIME] Warm start: "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+                  << " ms" << std::endl;
+        EXPECT_TRUE(restored.has_secret_key());
+        EXPECT_EQ(restored.params().poly_modulus_degree, params.poly_modulus_degree);
+        EXPECT_EQ(restored.params().coeff_modulus_bits, params.coeff_modulus_bits);
+        EXPECT_EQ(restored.decrypt(cipher_key), client.decrypt(cipher_key));
+        
+        // 评估模式：服务端只有公钥和重线性化密钥
+        yus::FHEWrapper server(dir.string(), true);
+        EXPECT_FALSE(server.has_secret_key());
+        yus::YuSEvalParams eval_params{{0x01, 0x02, 0x03}, level, 12, 0, 4, {}};
+        std::vector<yus::Ciphertext> cipher_ks;
+        server.evaluate_yus(cipher_key, eval_params, cipher_ks);
+        EXPECT_THROW(server.decrypt(cipher_ks), std::runtime_error);
+        
+        yus::YuSCipher cipher(p, level, 12);
+        cipher.init(master_key, eval_params.nonce);
+        auto expected = cipher.generate_keystream(4);
+        auto decrypted = client.decrypt(cipher_ks);
+        const size_t nslots = client.slot_count();
+        for (size_t j = 0; j < 4; ++j) {
+            for (size_t i = 0; i < 24; ++i) {
+                EXPECT_EQ(decrypted[i * nslots + j], expected[j * 24 + i]) << "Block " << j << ", element " << i;
+            }
+        }
+        
+        server.save(eval_dir.string());
+        EXPECT_FALSE(std::filesystem::exists(eval_dir / "secret.key"));
+        EXPECT_THROW(yus::FHEWrapper(eval_dir.string()), std::runtime_error);
+        
+        std::cout << "[SUCCESS] Key persistence test completed" << std::endl;
+        
+    } catch (const std::exception& e) {
+        std::cout << "[EXCEPTION] Key persistence test failed: " << e.what() << std::endl;
+        ADD_FAILURE() << "Exception in key persistence test: " << e.what();
+    }
+    std::filesystem::remove_all(dir);
+    std::filesystem::remove_all(eval_dir);
+}
+
+/**
+ * @test FHEWrapperTest.SaveLoadBGV
+ * @brief 测试BGV上下文、参数和密钥的保存与加载
+ * 
+ * 验证加载的实例能解密原实例加密的密文，评估模式能加密但不能解密。
+ */
+TEST(FHEWrapperTest, SaveLoadBGV) {
+    std::cout << "[TEST INFO] Testing BGV key persistence..." << std::endl;
+    
+    const auto dir = std::filesystem::temp_directory_path() / "yus_fhe_keys_test_bgv";
+    try {
+        yus::FHEParams params;
+        params.security_level = 80;
+        params.poly_modulus_degree = 2048;
+        params.plain_modulus = yus::generate_batching_prime(17, 2048);
+        params.cipher_modulus_bits = 100;
+        yus::FHEWrapper client(yus::FHE_SCHEME::BGV, params);
+        client.save(dir.string());
+        
+        std::vector<mpz_class> plain = {1, 2, 3, 4};
+        std::vector<yus::Ciphertext> cipher;
+        client.encrypt(plain, cipher);
+        
+        yus::FHEWrapper restored(dir.string());
+        EXPECT_EQ(restored.slot_count(), client.slot_count());
+        EXPECT_EQ(restored.decrypt(cipher), client.pack_plaintext(plain));
+        
+        yus::FHEWrapper server(dir.string(), true);
+        std::vector<yus::Ciphertext> server_cipher;
+        server.encrypt(plain, server_cipher);
+        EXPECT_THROW(server.decrypt(server_cipher), std::runtime_error);
+        
+        std::cout << "[SUCCESS] BGV key persistence test completed" << std::endl;
+        
+    } catch (const std::exception& e) {
+        std::cout << "[EXCEPTION] BGV key persistence test failed: " << e.what() << std::endl;
+        ADD_FAILURE() << "Exception in BGV key persistence test: " << e.what();
+    }
+    std::filesystem::remove_all(dir);
+}
+
+/**
+ * @test FHEWrapperTest.SerializeBFV
+ * @brief 测试密文和密钥的压缩序列化
+ * 
+ * 验证：
+ * - 密文经流和内存缓冲区往返后解密结果不变
+ * - 压缩后的字节数小于未压缩字节数
+ * - 从序列化的公钥和重线性化密钥构造的评估实例可正确评估
+ * - 方案不匹配或数据损坏时抛出异常
+ * - 截断的数据、超长的帧和超出容器大小的密文数在分配之前被拒绝
+ */
+TEST(FHEWrapperTest, SerializeBFV) {
+    std::cout << "[TEST INFO] Testing compressed serialization..." << std::endl;
+    
+    const auto dir = std::filesystem::temp_directory_path() / "yus_fhe_serialize_test";
+    try {
+        const mpz_class p(65537);
+        const auto level = yus::SecurityLevel::SEC80;
+        auto params = yus::select_fhe_params(yus::FHE_SCHEME::BFV, p, 80, static_cast<uint32_t>(level));
+        yus::FHEWrapper client(yus::FHE_SCHEME::BFV, params);
+        client.save(dir.string());
+        
+        std::vector<mpz_class> master_key(36);
+        for (size_t i = 0; i < 36; ++i) {
+            master_key[i] = static_cast<unsigned long>(29 * i + 1);
+        }
+        std::vector<yus::Ciphertext> cipher_key;
+        client.encrypt_key(master_key, cipher_key);
+        
+        // 流往返
+        std::stringstream stream;
+        auto size = client.save_ciphertexts(cipher_key, stream);
+        std::cout << "[INFO] " << cipher_key.size() << " ciphertexts: " << size.raw_bytes
+                  << " bytes raw, " << size.stored_bytes << " bytes stored" << std::endl;
+        EXPECT_LT(size.stored_bytes, size.raw_bytes);
+        std::vector<yus::Ciphertext> loaded;
+        client.load_ciphertexts(stream, loaded);
+        ASSERT_EQ(loaded.size(), cipher_key.size());
+        EXPECT_EQ(client.decrypt(loaded), client.decrypt(cipher_key));
+        
+        // 缓冲区往返，不压缩
+        std::vector<uint8_t> buffer;
+        auto plain_size = client.save_ciphertexts(cipher_key, buffer, false);
+        EXPECT_EQ(plain_size.stored_bytes, buffer.size());
+        EXPECT_GT(plain_size.stored_bytes, size.stored_bytes);
+        client.load_ciphertexts(buffer.data(), buffer.size(), loaded);
+        EXPECT_EQ(client.decrypt(loaded), client.decrypt(cipher_key));
+        
+        // 密钥往返：评估实例换用序列化后的公钥和重线性化密钥
+        std::stringstream pk_stream, rk_stream;
+        client.save_public_key(pk_stream);
+        auto rk_size = client.save_relin_keys(rk_stream);
+        EXPECT_LT(rk_size.stored_bytes, rk_size.raw_bytes);
+        yus::FHEWrapper server(dir.string(), true);
+        server.load_public_key(pk_stream);
+        server.load_relin_keys(rk_stream);
+        
+        std::stringstream upload;
+        client.save_ciphertexts(cipher_key, upload);
+        server.load_ciphertexts(upload, loaded);
+        yus::YuSEvalParams eval_params{{0x04, 0x05, 0x06}, level, 12, 0, 2, {}};
+        std::vector<yus::Ciphertext> cipher_ks;
+        server.evaluate_yus(loaded, eval_params, cipher_ks);
+        
+        std::stringstream download;
+        server.save_ciphertexts(cipher_ks, download);
+        client.load_ciphertexts(download, loaded);
+        yus::YuSCipher cipher(p, level, 12);
+        cipher.init(master_key, eval_params.nonce);
+        auto expected = cipher.generate_keystream(2);
+        auto decrypted = client.decrypt(loaded);
+        const size_t nslots = client.slot_count();
+        for (size_t j = 0; j < 2; ++j) {
+            for (size_t i = 0; i < 24; ++i) {
+                EXPECT_EQ(decrypted[i * nslots + j], expected[j * 24 + i]) << "Block " << j << ", element " << i;
+            }
+        }
+        
+        // 损坏的数据
+        std::string corrupted = "XXXX" + std::string(buffer.begin() + 4, buffer.end());
+        std::istringstream bad_magic(corrupted);
+        EXPECT_THROW(client.load_ciphertexts(bad_magic, loaded), std::runtime_error);
+        EXPECT_THROW(client.load_ciphertexts(buffer.data(), buffer.size() / 2, loaded), std::runtime_error);
+        
+        // 帧头和容器头声明的长度超出实际数据或上下文上限时，在分配之前拒绝
+        auto set_u64 = [](std::vector<uint8_t> bytes, size_t offset, uint64_t value) {
+            for (int k = 0; k < 8; ++k) {
+                bytes[offset + k] = static_cast<uint8_t>(value >> (8 * k));
+            }
+            return bytes;
+        };
+        const size_t count_offset = 6;          // 魔数4字节、格式和方案各1字节
+        const size_t frame_size_offset = 14 + 8; // 容器头14字节，SEAL帧头第8字节起为帧长
+        auto oversized = set_u64(buffer, frame_size_offset, uint64_t(1) << 40);
+        EXPECT_THROW(client.load_ciphertexts(oversized.data(), oversized.size(), loaded), std::runtime_error);
+        auto overlong = set_u64(buffer, frame_size_offset, buffer.size());
+        EXPECT_THROW(client.load_ciphertexts(overlong.data(), overlong.size(), loaded), std::runtime_error);
+        auto too_many = set_u64(buffer, count_offset, uint64_t(1) << 32);
+        EXPECT_THROW(client.load_ciphertexts(too_many.data(), too_many.size(), loaded), std::runtime_error);
+        EXPECT_THROW(client.load_key(too_many.data(), too_many.size(), loaded), std::runtime_error);
+        
+        std::cout << "[SUCCESS] Compressed serialization test completed" << std::endl;
+        
+    } catch (const std::exception& e) {
+        std::cout << "[EXCEPTION] Compressed serialization test failed: " << e.what() << std::endl;
+        ADD_FAILURE() << "Exception in compressed serialization test: " << e.what();
+    }
+    std::filesystem::remove_all(dir);
+}
+
+/**
+ * @test FHEWrapperTest.SymmetricKeyUploadBFV
+ * @brief 测试带种子的对称加密主密钥上传
+ * 
+ * 验证：
+ * - 对称加密的上传数据约为公钥加密密文的一半
+ * - 评估实例加载后展开种子，评估结果可正确解密
+ * - 评估模式下无法对称加密，密文数不为36时加载失败
+ */
+TEST(FHEWrapperTest, SymmetricKeyUploadBFV) {
+    std::cout << "[TEST INFO] Testing seeded key upload..." << std::endl;
+    
+    const auto dir = std::filesystem::temp_directory_path() / "yus_fhe_upload_test";
+    try {
+        const mpz_class p(65537);
+        const auto level = yus::SecurityLevel::SEC80;
+        auto params = yus::select_fhe_params(yus::FHE_SCHEME::BFV, p, 80, static_cast<uint32_t>(level));
+        yus::FHEWrapper client(yus::FHE_SCHEME::BFV, params);
+        client.save(dir.string());
+        
+        std::vector<mpz_class> master_key(36);
+        for (size_t i = 0; i < 36; ++i) {
+            master_key[i] = static_cast<unsigned long>(41 * i + 7);
+        }
+        std::vector<yus::Ciphertext> cipher_key;
+        client.encrypt_key(master_key, cipher_key);
+        std::stringstream public_upload;
+        auto public_size = client.save_ciphertexts(cipher_key, public_upload);
+        
+        std::vector<uint8_t> upload;
+        auto seeded_size = client.encrypt_key_symmetric(master_key, upload);
+        std::cout << "[INFO] Key upload: " << public_size.stored_bytes << " bytes public-key, "
+                  << seeded_size.stored_bytes << " bytes seeded" << std::endl;
+        EXPECT_EQ(seeded_size.stored_bytes, upload.size());
+        EXPECT_LT(seeded_size.stored_bytes * 10, public_size.stored_bytes * 6);
+        
+        yus::FHEWrapper server(dir.string(), true);
+        std::vector<yus::Ciphertext> uploaded_key;
+        server.load_key(upload.data(), upload.size(), uploaded_key);
+        ASSERT_EQ(uploaded_key.size(), 36u);
+        EXPECT_EQ(client.decrypt(uploaded_key), client.decrypt(cipher_key));
+        
+        yus::YuSEvalParams eval_params{{0x07, 0x08, 0x09}, level, 12, 0, 2, {}};
+        std::vector<yus::Ciphertext> cipher_ks;
+        server.evaluate_yus(uploaded_key, eval_params, cipher_ks);
+        yus::YuSCipher cipher(p, level, 12);
+        cipher.init(master_key, eval_params.nonce);
+        auto expected = cipher.generate_keystream(2);
+        auto decrypted = client.decrypt(cipher_ks);
+        const size_t nslots = client.slot_count();
+        for (size_t j = 0; j < 2; ++j) {
+            for (size_t i = 0; i < 24; ++i) {
+                EXPECT_EQ(decrypted[i * nslots + j], expected[j * 24 + i]) << "Block " << j << ", element " << i;
+            }
+        }
+        
+        EXPECT_THROW(server.encrypt_key_symmetric(master_key, upload), std::runtime_error);
+        std::stringstream partial;
+        client.save_ciphertexts(std::vector<yus::Ciphertext>(cipher_key.begin(), cipher_key.begin() + 12), partial);
+        EXPECT_THROW(server.load_key(partial, uploaded_key), std::runtime_error);
+        
+        std::cout << "[SUCCESS] Seeded key upload test completed" << std::endl;
+        
+    } catch (const std::exception& e) {
+        std::cout << "[EXCEPTION] Seeded key upload test failed: " << e.what() << std::endl;
+        ADD_FAILURE() << "Exception in seeded key upload test: " << e.what();
+    }
+    std::filesystem::remove_all(dir);
+}
+
+/**
+ * @test FHEWrapperTest.ColumnwiseBFV
+ * @brief 测试列式打包评估并与行式打包比较单块延迟
+ * 
+ * 验证：
+ * - 列式打包按槽区间容纳块，SEC80每块84个槽
+ * - 非零首块的3个块解密后与明文YuSCipher一致
+ * - 未生成伽罗瓦密钥时评估失败
+ */
+TEST(FHEWrapperTest, ColumnwiseBFV) {
+    std::cout << "[TEST INFO] Testing column-wise packing..." << std::endl;
+    
+    try {
+        const mpz_class p(65537);
+        const auto level = yus::SecurityLevel::SEC80;
+        auto params = yus::select_fhe_params(yus::FHE_SCHEME::BFV, p, 80, static_cast<uint32_t>(level), 10,
+                                             yus::PackingMode::COLUMN);
+        yus::FHEWrapper wrapper(yus::FHE_SCHEME::BFV, params);
+        EXPECT_EQ(wrapper.column_block_capacity(level), 2 * (wrapper.slot_count() / 2 / 84));
+        
+        std::vector<mpz_class> master_key(36);
+        for (size_t i = 0; i < 36; ++i) {
+            master_key[i] = static_cast<unsigned long>(23 * i + 4);
+        }
+        std::vector<yus::Ciphertext> column_key;
+        wrapper.encrypt_key_columnwise(master_key, column_key);
+        ASSERT_EQ(column_key.size(), 3u);
+        
+        yus::YuSEvalParams eval_params{{0x0c, 0x0d}, level, 12, 2, 3, {}};
+        std::vector<yus::Ciphertext> column_ks;
+        yus::YuSEvalReport report;
+        EXPECT_THROW(wrapper.evaluate_yus_columnwise(column_key, eval_params, column_ks, report),
+                     std::runtime_error);
+        wrapper.generate_column_galois_keys();
+        wrapper.evaluate_yus_columnwise(column_key, eval_params, column_ks, report);
+        
+        yus::YuSCipher cipher(p, level, 12);
+        cipher.init(master_key, eval_params.nonce);
+        auto expected = cipher.generate_keystream(5);
+        auto decrypted = wrapper.decrypt_columnwise(column_ks, level, 12, 3);
+        ASSERT_EQ(decrypted.size(), 3u * 24);
+        for (size_t w = 0; w < decrypted.size(); ++w) {
+            EXPECT_EQ(decrypted[w], expected[2 * 24 + w]) << "Word " << w;
+        }
+        
+        // 单块延迟：列式每轮2次密文乘法，行式每轮24次
+        eval_params.block_count = 1;
+        const double column_ms = wrapper.evaluate_yus_columnwise(column_key, eval_params, column_ks, report);
+        std::vector<yus::Ciphertext> row_key, row_ks;
+        wrapper.encrypt_key(master_key, row_key);
+        const double row_ms = wrapper.evaluate_yus(row_key, eval_params, row_ks);
+        std::cout << "[RESULTS] One block: column-wise " << column_ms << " ms, row-wise " << row_ms << " ms"
+                  << std::endl;
+        
+        std::cout << "[SUCCESS] Column-wise packing test completed" << std::endl;
+        
+    } catch (const std::exception& e) {
+        std::cout << "[EXCEPTION] Column-wise packing test failed: " << e.what() << std::endl;
+        ADD_FAILURE() << "Exception in column-wise packing test: " << e.what();
+    }
+}
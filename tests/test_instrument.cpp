@@ -0,0 +1,70 @@
+/**
+ * @file test_instrument.cpp
+ * @brief YuS流密码热路径插桩测试
+ * @author Aurorp1g
+ * @date 2025-11-07
+ *
+ * 使用Google Test框架对按线程的阶段计数器进行单元测试。
+ */
+
+#include "yus/instrument.h"
+#include "yus/yus_core.h"
+#include <gtest/gtest.h>
+#include <sstream>
+#include <thread>
+
+/**
+ * @test InstrumentTest.KeystreamCounters
+ * @brief 测试明文密钥流的阶段计数
+ *
+ * 主线程和另一线程各生成1个YuS-80块，验证：
+ * - 未编译插桩时快照全为0
+ * - 已退出线程的计数并入汇总：白化2次、S盒层10次、线性层12次、轮密钥10次
+ * - 每次轮常数派生挤出288字节XOF输出
+ * - 重置后快照清零，JSON包含所有阶段
+ */
+TEST(InstrumentTest, KeystreamCounters) {
+    const mpz_class p(65537);
+    std::vector<mpz_class> master_key(36);
+    for (size_t i = 0; i < 36; ++i) {
+        master_key[i] = static_cast<unsigned long>(31 * i + 7);
+    }
+    const std::vector<uint8_t> nonce{0x01, 0x02, 0x03, 0x04};
+    auto generate_one = [&] {
+        yus::YuSCipher cipher(p, yus::SecurityLevel::SEC80, 12);
+        cipher.init(master_key, nonce);
+        cipher.generate_keystream(1);
+    };
+
+    yus::instrument_reset();
+    generate_one();
+    std::thread worker(generate_one);
+    worker.join();
+    const auto snapshot = yus::instrument_snapshot();
+
+    if (!yus::instrument_enabled()) {
+        for (const auto& stage : snapshot.stages) {
+            EXPECT_EQ(stage.calls, 0u);
+        }
+        return;
+    }
+    EXPECT_EQ(snapshot[yus::Stage::WHITENING].calls, 2u);
+    EXPECT_EQ(snapshot[yus::Stage::SBOX_LAYER].calls, 10u);
+    EXPECT_EQ(snapshot[yus::Stage::LINEAR_LAYER].calls, 12u);
+    EXPECT_EQ(snapshot[yus::Stage::ROUND_KEY].calls, 10u);
+    EXPECT_EQ(snapshot[yus::Stage::XOF].calls, 12u);
+    EXPECT_EQ(snapshot[yus::Stage::XOF].bytes, 12u * 288u);
+    EXPECT_GT(snapshot[yus::Stage::SBOX_LAYER].ns, 0u);
+    EXPECT_EQ(snapshot[yus::Stage::FHE_MULTIPLY].calls, 0u);
+
+    std::ostringstream table;
+    snapshot.print(table);
+    EXPECT_NE(table.str().find("sbox_layer"), std::string::npos);
+    EXPECT_EQ(table.str().find("fhe_rotate"), std::string::npos);
+
+    yus::instrument_reset();
+    const auto cleared = yus::instrument_snapshot();
+    EXPECT_EQ(cleared[yus::Stage::SBOX_LAYER].calls, 0u);
+    EXPECT_EQ(cleared[yus::Stage::XOF].bytes, 0u);
+    EXPECT_NE(cleared.to_json().find("\"fhe_mod_switch\":{\"calls\":0"), std::string::npos);
+}
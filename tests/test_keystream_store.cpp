@@ -0,0 +1,144 @@
+/**
+ * @file test_keystream_store.cpp
+ * @brief YuS流密码加密密钥流缓存测试
+ * @author Aurorp1g
+ * @date 2025-11-07
+ *
+ * 使用Google Test框架对离线/在线转密所用的加密密钥流缓存进行单元测试。
+ * 缓存只保存密文句柄，测试使用对象池中未加密的SEAL密文作占位，以scale字段作标记。
+ * 包含索引匹配、块范围覆盖、容量淘汰和随机数删除测试。
+ */
+
+#include "yus/keystream_store.h"
+#include <gtest/gtest.h>
+#include <memory>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief 构造占位密钥流，每个密文的scale字段设为标记值
+ */
+std::vector<yus::Ciphertext> fake_keystream(int tag) {
+    auto pool = yus::CiphertextPool::create(yus::FHE_SCHEME::BFV);
+    std::vector<yus::Ciphertext> ks;
+    for (int i = 0; i < 24; ++i) {
+        ks.push_back(pool->acquire());
+        ks.back().seal().scale() = tag;
+    }
+    return ks;
+}
+
+/**
+ * @brief 读取占位密文的标记值
+ */
+int tag_of(const yus::Ciphertext& ct) {
+    return static_cast<int>(ct.seal().scale());
+}
+
+yus::YuSEvalParams eval_params(uint8_t nonce, uint32_t first_block, uint32_t block_count) {
+    return yus::YuSEvalParams{{nonce, 0x01, 0x02}, yus::SecurityLevel::SEC80, 12,
+                              first_block, block_count, {}};
+}
+
+} // namespace
+
+/**
+ * @test KeystreamStoreTest.Lookup
+ * @brief 测试索引匹配和块范围覆盖
+ *
+ * 验证缓存查询：
+ * - 密钥标识、随机数、安全级别、截断和首块均需一致
+ * - 缓存条目可服务块数更少的请求
+ * - 填满所有槽的条目（block_count为0）可服务任意块数
+ */
+TEST(KeystreamStoreTest, Lookup) {
+    yus::KeystreamStore store(0, 0);
+    std::vector<yus::Ciphertext> ks;
+
+    ASSERT_TRUE(store.insert("alice", eval_params(1, 0, 100), fake_keystream(1), 1000));
+    ASSERT_TRUE(store.insert("alice", eval_params(2, 0, 0), fake_keystream(2), 1000));
+
+    ASSERT_TRUE(store.lookup("alice", eval_params(1, 0, 100), ks));
+    EXPECT_EQ(tag_of(ks[0]), 1);
+    EXPECT_TRUE(store.lookup("alice", eval_params(1, 0, 50), ks));
+    EXPECT_FALSE(store.lookup("alice", eval_params(1, 0, 101), ks));
+    EXPECT_FALSE(store.lookup("alice", eval_params(1, 0, 0), ks));
+    EXPECT_FALSE(store.lookup("alice", eval_params(1, 100, 50), ks));
+    EXPECT_FALSE(store.lookup("bob", eval_params(1, 0, 100), ks));
+
+    auto other_trunc = eval_params(1, 0, 100);
+    other_trunc.trunc_m = 6;
+    EXPECT_FALSE(store.lookup("alice", other_trunc, ks));
+
+    ASSERT_TRUE(store.lookup("alice", eval_params(2, 0, 4096), ks));
+    EXPECT_EQ(tag_of(ks[0]), 2);
+
+    auto stats = store.stats();
+    EXPECT_EQ(stats.hits, 3ULL);
+    EXPECT_EQ(stats.misses, 5ULL);
+}
+
+/**
+ * @test KeystreamStoreTest.Eviction
+ * @brief 测试容量限制和淘汰顺序
+ *
+ * 验证条目数和字节数限制按最近最少使用顺序淘汰，
+ * 替换同一索引不增加条目数，超过字节容量的单个条目被拒绝。
+ */
+TEST(KeystreamStoreTest, Eviction) {
+    yus::KeystreamStore store(2, 2500);
+    std::vector<yus::Ciphertext> ks;
+
+    EXPECT_FALSE(store.insert("alice", eval_params(0, 0, 0), fake_keystream(0), 3000));
+    EXPECT_EQ(store.size(), 0ULL);
+
+    store.insert("alice", eval_params(1, 0, 0), fake_keystream(1), 1000);
+    store.insert("alice", eval_params(2, 0, 0), fake_keystream(2), 1000);
+    EXPECT_EQ(store.bytes(), 2000ULL);
+
+    // 访问1后再插入3，条目数超限时淘汰最久未使用的2
+    ASSERT_TRUE(store.lookup("alice", eval_params(1, 0, 0), ks));
+    store.insert("alice", eval_params(3, 0, 0), fake_keystream(3), 1000);
+    EXPECT_EQ(store.size(), 2ULL);
+    EXPECT_TRUE(store.lookup("alice", eval_params(1, 0, 0), ks));
+    EXPECT_FALSE(store.lookup("alice", eval_params(2, 0, 0), ks));
+
+    // 替换同一索引，字节数超限时淘汰3
+    store.insert("alice", eval_params(1, 0, 0), fake_keystream(4), 2000);
+    EXPECT_EQ(store.size(), 1ULL);
+    EXPECT_EQ(store.bytes(), 2000ULL);
+    ASSERT_TRUE(store.lookup("alice", eval_params(1, 0, 0), ks));
+    EXPECT_EQ(tag_of(ks[0]), 4);
+    EXPECT_EQ(store.stats().evictions, 2ULL);
+}
+
+/**
+ * @test KeystreamStoreTest.Erase
+ * @brief 测试按随机数删除
+ *
+ * 验证删除某个随机数的全部块范围，其余随机数和密钥标识的条目不受影响，
+ * 且已取出的密钥流句柄在删除后仍然有效。
+ */
+TEST(KeystreamStoreTest, Erase) {
+    yus::KeystreamStore store(0, 0);
+    std::vector<yus::Ciphertext> ks;
+
+    store.insert("alice", eval_params(1, 0, 100), fake_keystream(1), 1000);
+    store.insert("alice", eval_params(1, 100, 100), fake_keystream(2), 1000);
+    store.insert("alice", eval_params(2, 0, 100), fake_keystream(3), 1000);
+    store.insert("bob", eval_params(1, 0, 100), fake_keystream(4), 1000);
+    ASSERT_TRUE(store.lookup("alice", eval_params(1, 100, 100), ks));
+
+    EXPECT_EQ(store.erase("alice", eval_params(1, 0, 0).nonce), 2ULL);
+    EXPECT_EQ(store.size(), 2ULL);
+    EXPECT_EQ(store.bytes(), 2000ULL);
+    EXPECT_FALSE(store.lookup("alice", eval_params(1, 0, 100), ks));
+    EXPECT_TRUE(store.lookup("alice", eval_params(2, 0, 100), ks));
+    EXPECT_TRUE(store.lookup("bob", eval_params(1, 0, 100), ks));
+
+    std::vector<yus::Ciphertext> held;
+    ASSERT_TRUE(store.lookup("bob", eval_params(1, 0, 100), held));
+    store.erase("bob", eval_params(1, 0, 0).nonce);
+    EXPECT_EQ(tag_of(held[0]), 4);
+}
@@ -63,4 +63,71 @@ TEST(LinearLayerTest, BranchNumber) {
     
     // 验证差分分支数为10
     EXPECT_EQ(ll.differential_branch_number(), 10ULL);
-}
\ No newline at end of file
+}
+
+/**
+ * @test LinearLayerTest.ApplyMatchesMatrix
+ * @brief 测试基于加法调度的线性层与矩阵乘法一致
+ * 
+ * 验证四俄罗斯人加法调度的计算结果与直接矩阵乘法相同：
+ * - 构造非平凡的36元素状态向量
+ * - 按矩阵定义逐行求和作为参考
+ * - 比较线性层输出与参考结果
+ */
+TEST(LinearLayerTest, ApplyMatchesMatrix) {
+    mpz_class p = yus::generate_prime(17);
+    yus::LinearLayer ll;
+
+    // 构造非平凡状态向量
+    std::vector<mpz_class> state(36);
+    for (size_t i = 0; i < 36; ++i) {
+        state[i] = yus::mod(mpz_class(static_cast<unsigned long>(i * i * 7919 + 13)), p);
+    }
+
+    auto output = ll.apply(state, p);
+    const auto& matrix = ll.matrix();
+
+    // 参考实现：output[row] = Σ M[row][col] * state[col] mod p
+    for (size_t row = 0; row < 36; ++row) {
+        mpz_class expected(0);
+        for (size_t col = 0; col < 36; ++col) {
+            if (matrix[row][col] == 1) {
+                expected += state[col];
+            }
+        }
+        EXPECT_EQ(output[row], yus::mod(expected, p)) << "Mismatch at row " << row;
+    }
+}
+
+/**
+ * @test LinearLayerTest.AdditionSchedule
+ * @brief 测试加法调度的规模与截断
+ * 
+ * 验证加法调度的以下性质：
+ * - 完整调度的加法次数少于逐行直接求和的876次
+ * - 截断调度只包含未被丢弃的行，且加法次数更少
+ * - 截断调度的各行与完整调度的对应行引用相同的输入组合
+ */
+TEST(LinearLayerTest, AdditionSchedule) {
+    yus::LinearLayer ll;
+
+    auto full = ll.addition_schedule();
+    EXPECT_EQ(full.first_row, 0U);
+    EXPECT_EQ(full.rows.size(), 36ULL);
+    EXPECT_LT(full.addition_count(), 876U);
+
+    // 截断12行后只计算剩余24行
+    auto truncated = ll.addition_schedule(12);
+    EXPECT_EQ(truncated.first_row, 12U);
+    EXPECT_EQ(truncated.rows.size(), 24ULL);
+    EXPECT_LT(truncated.addition_count(), full.addition_count());
+
+    // 每一步只引用已计算的寄存器
+    for (const auto& step : truncated.partial_sums) {
+        EXPECT_GE(step.dst, 36U);
+        EXPECT_LT(step.lhs, step.dst);
+        EXPECT_LT(step.rhs, step.dst);
+    }
+
+    EXPECT_THROW(ll.addition_schedule(37), std::invalid_argument);
+}
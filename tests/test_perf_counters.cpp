@@ -0,0 +1,74 @@
+/**
+ * @file test_perf_counters.cpp
+ * @brief YuS流密码硬件性能计数器测试
+ * @author Aurorp1g
+ * @date 2025-11-07
+ *
+ * 使用Google Test框架对PerfCounters进行单元测试。容器中计数器常不可用，
+ * 测试同时覆盖可用和退化两种情况。
+ */
+
+#include "yus/perf_counters.h"
+#include <gtest/gtest.h>
+#include <iostream>
+#include <thread>
+
+/**
+ * @test PerfCountersTest.CountOrDegrade
+ * @brief 测试计数器读数或不可用时的退化
+ *
+ * 验证：
+ * - 默认打开5个计数器
+ * - 不可用时error()给出原因，value()返回-1，start()/stop()可以照常调用
+ * - 可用时一段循环的周期数和指令数为正
+ * - 未知的计数器名返回-1
+ */
+TEST(PerfCountersTest, CountOrDegrade) {
+    yus::PerfCounters perf;
+    ASSERT_EQ(perf.counters().size(), 5u);
+
+    volatile uint64_t sink = 0;
+    perf.start();
+    for (uint64_t i = 0; i < 100000; ++i) {
+        sink = sink + i * i;
+    }
+    perf.stop();
+
+    if (!perf.available()) {
+        std::cout << "[TEST INFO] Hardware counters unavailable: " << perf.error() << std::endl;
+        EXPECT_FALSE(perf.error().empty());
+        EXPECT_EQ(perf.value("cycles"), -1.0);
+    } else {
+        if (perf.value("cycles") >= 0) {
+            EXPECT_GT(perf.value("cycles"), 0.0);
+        }
+        if (perf.value("instructions") >= 0) {
+            EXPECT_GT(perf.value("instructions"), 100000.0);
+        }
+    }
+    EXPECT_EQ(perf.value("no_such_counter"), -1.0);
+}
+
+/**
+ * @test PerfCountersTest.CountsChildThreads
+ * @brief 测试构造之后创建的线程计入计数
+ *
+ * 验证：主线程只等待时，子线程中的循环使指令数超过循环次数。
+ */
+TEST(PerfCountersTest, CountsChildThreads) {
+    yus::PerfCounters perf;
+    if (perf.value("instructions") < 0) {
+        GTEST_SKIP() << "Instruction counter unavailable: " << perf.error();
+    }
+
+    perf.start();
+    std::thread worker([] {
+        volatile uint64_t sink = 0;
+        for (uint64_t i = 0; i < 1000000; ++i) {
+            sink = sink + i * i;
+        }
+    });
+    worker.join();
+    perf.stop();
+    EXPECT_GT(perf.value("instructions"), 1000000.0);
+}
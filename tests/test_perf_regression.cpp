@@ -0,0 +1,317 @@
+/**
+ * @file test_perf_regression.cpp
+ * @brief YuS流密码性能回归测试
+ * @author Aurorp1g
+ * @date 2025-11-07
+ *
+ * 运行短小稳定的基准（明文密钥流生成、小参数同态评估），与按机器类别存放的基线JSON比较。
+ * 默认跳过，设置环境变量YUS_PERF_TESTS=1时运行（CMake选项YUS_PERF_TESTS打开后
+ * 由ctest -L perf运行）。
+ *
+ * 基线文件为tests/perf_baselines/<机器类别>.json，机器类别默认由CPU型号和硬件线程数生成，
+ * 可用YUS_PERF_MACHINE覆盖。所有指标都是越小越好，测量值超过基线·(1+容差)即失败；
+ * 容差取YUS_PERF_TOLERANCE，其次取基线文件中的tolerance，默认0.25。
+ * 设置YUS_PERF_UPDATE=1时把测量值写回基线文件（cmake --build <dir> --target update_perf_baseline）。
+ * 没有基线的机器类别跳过比较；基线应在空闲的专用机器上用Release构建录制，
+ * 型号名不唯一的虚拟机类别（如"Intel(R) Xeon(R) Processor"）噪声超过容差，不提交基线。
+ */
+
+#include "yus/yus_core.h"
+#include "yus/timing.h"
+#ifdef ENABLE_FHE
+#include "yus/fhe_wrapper.h"
+#endif
+#include <gtest/gtest.h>
+#include <cctype>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifndef YUS_PERF_BASELINE_DIR
+#define YUS_PERF_BASELINE_DIR "tests/perf_baselines"
+#endif
+
+namespace {
+
+/// 基线文件未给出容差时的默认值
+constexpr double kDefaultTolerance = 0.25;
+
+/**
+ * @struct PerfBaseline
+ * @brief 一个机器类别的性能基线
+ */
+struct PerfBaseline {
+    std::string machine;                    ///< 机器类别
+    double tolerance = kDefaultTolerance;   ///< 允许的相对变慢比例
+    std::map<std::string, double> metrics;  ///< 指标名到基线值
+};
+
+/**
+ * @brief 读取环境变量
+ * @return 未设置时返回空串
+ */
+std::string env(const char* name) {
+    const char* value = std::getenv(name);
+    return value ? value : "";
+}
+
+bool perf_tests_enabled() {
+    const std::string value = env("YUS_PERF_TESTS");
+    return !value.empty() && value != "0";
+}
+
+bool update_mode() {
+    const std::string value = env("YUS_PERF_UPDATE");
+    return !value.empty() && value != "0";
+}
+
+/**
+ * @brief 机器类别：CPU型号和硬件线程数，只保留小写字母、数字和下划线
+ */
+std::string machine_class() {
+    std::string name = env("YUS_PERF_MACHINE");
+    if (name.empty()) {
+        std::ifstream cpuinfo("/proc/cpuinfo");
+        std::string line;
+        while (std::getline(cpuinfo, line)) {
+            if (line.rfind("model name", 0) == 0) {
+                name = line.substr(line.find(':') + 1);
+                break;
+            }
+        }
+        if (name.empty()) {
+            name = "unknown_cpu";
+        }
+        name += "_" + std::to_string(std::thread::hardware_concurrency()) + "t";
+    }
+    std::string out;
+    for (char c : name) {
+        const unsigned char u = static_cast<unsigned char>(c);
+        if (std::isalnum(u)) {
+            out += static_cast<char>(std::tolower(u));
+        } else if (!out.empty() && out.back() != '_') {
+            out += '_';
+        }
+    }
+    while (!out.empty() && out.back() == '_') {
+        out.pop_back();
+    }
+    return out;
+}
+
+std::string baseline_path() {
+    std::string dir = env("YUS_PERF_BASELINE_DIR");
+    if (dir.empty()) {
+        dir = YUS_PERF_BASELINE_DIR;
+    }
+    return dir + "/" + machine_class() + ".json";
+}
+
+/**
+ * @brief 读取基线文件
+ *
+ * 只解析本文件写出的格式：顶层的"tolerance"和"metrics"对象中的"名称": 数值对。
+ * 文件不存在时返回空基线。
+ */
+PerfBaseline load_baseline(const std::string& path) {
+    PerfBaseline baseline;
+    baseline.machine = machine_class();
+    std::ifstream in(path);
+    if (!in) {
+        return baseline;
+    }
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    const std::string text = buffer.str();
+
+    const size_t tol = text.find("\"tolerance\"");
+    if (tol != std::string::npos) {
+        baseline.tolerance = std::strtod(text.c_str() + text.find(':', tol) + 1, nullptr);
+    }
+    const size_t metrics = text.find("\"metrics\"");
+    if (metrics == std::string::npos) {
+        return baseline;
+    }
+    const size_t end = text.find('}', metrics);
+    size_t pos = text.find('{', metrics);
+    while (pos != std::string::npos && pos < end) {
+        const size_t key_start = text.find('"', pos + 1);
+        if (key_start == std::string::npos || key_start > end) {
+            break;
+        }
+        const size_t key_end = text.find('"', key_start + 1);
+        const size_t colon = text.find(':', key_end);
+        char* value_end = nullptr;
+        const double value = std::strtod(text.c_str() + colon + 1, &value_end);
+        baseline.metrics[text.substr(key_start + 1, key_end - key_start - 1)] = value;
+        pos = static_cast<size_t>(value_end - text.c_str());
+    }
+    return baseline;
+}
+
+/**
+ * @brief 写回基线文件，基线目录不存在时先创建
+ */
+void save_baseline(const std::string& path, const PerfBaseline& baseline) {
+    const std::filesystem::path dir = std::filesystem::path(path).parent_path();
+    if (!dir.empty()) {
+        std::filesystem::create_directories(dir);
+    }
+    std::ofstream out(path);
+    if (!out) {
+        throw std::runtime_error("Cannot write perf baseline: " + path);
+    }
+    out << "{\n  \"machine\": \"" << baseline.machine << "\",\n  \"tolerance\": " << baseline.tolerance
+        << ",\n  \"metrics\": {";
+    size_t k = 0;
+    for (const auto& metric : baseline.metrics) {
+        out << (k++ ? ",\n" : "\n") << "    \"" << metric.first << "\": " << std::fixed << std::setprecision(1)
+            << metric.second;
+    }
+    out << "\n  }\n}\n";
+}
+
+/**
+ * @brief 与基线比较一个指标，更新模式下写回基线
+ * @param name 指标名
+ * @param measured 测量值（越小越好）
+ * @param unit 单位，只用于输出
+ */
+void check_metric(const std::string& name, double measured, const char* unit) {
+    const std::string path = baseline_path();
+    PerfBaseline baseline = load_baseline(path);
+    if (update_mode()) {
+#ifndef NDEBUG
+        FAIL() << "Refusing to record perf baselines from a build without NDEBUG; use a Release build";
+#endif
+        baseline.metrics[name] = measured;
+        save_baseline(path, baseline);
+        std::cout << "[PERF] updated " << name << " = " << measured << " " << unit << " in " << path << std::endl;
+        return;
+    }
+
+    const auto it = baseline.metrics.find(name);
+    if (it == baseline.metrics.end()) {
+        GTEST_SKIP() << "No baseline for " << name << " in " << path
+                     << "; record one with: cmake --build <build-dir> --target update_perf_baseline";
+    }
+    const std::string tol_env = env("YUS_PERF_TOLERANCE");
+    const double tolerance = tol_env.empty() ? baseline.tolerance : std::stod(tol_env);
+    const double limit = it->second * (1.0 + tolerance);
+    const double change = 100.0 * (measured / it->second - 1.0);
+
+    std::ostringstream diff;
+    diff << std::fixed << std::setprecision(1) << name << ": baseline " << it->second << " " << unit
+         << ", measured " << measured << " " << unit << " (" << std::showpos << change << std::noshowpos
+         << "%), limit " << limit << " " << unit << " (" << std::showpos << 100.0 * tolerance << std::noshowpos
+         << "%)";
+    std::cout << "[PERF] " << diff.str() << (measured <= limit ? "  OK" : "  REGRESSION") << std::endl;
+    EXPECT_LE(measured, limit) << "Performance regression on machine class " << baseline.machine << "\n  "
+                               << diff.str();
+}
+
+/**
+ * @brief 单线程生成密钥流的每块耗时中位数（纳秒）
+ *
+ * 明文S盒层和线性层的OpenMP并行区固定为1个线程，避免调度抖动；
+ * 线程扩展性由yus_scaling单独跟踪。
+ */
+double keystream_ns_per_block(const mpz_class& p, yus::SecurityLevel level) {
+#ifdef _OPENMP
+    const int threads = omp_get_max_threads();
+    omp_set_num_threads(1);
+#endif
+    std::vector<mpz_class> master_key(36);
+    for (size_t i = 0; i < 36; ++i) {
+        master_key[i] = mpz_class(static_cast<unsigned long>(7919 * i + 13)) % p;
+    }
+    yus::YuSCipher cipher(p, level, 12);
+    cipher.init(master_key, {0x00, 0x01, 0x02, 0x03});
+    constexpr uint32_t kBlocks = 128;
+    cipher.generate_keystream(16);
+
+    yus::SampleStats ns;
+    yus::Timer timer;
+    for (int trial = 0; trial < 7; ++trial) {
+        timer.start();
+        cipher.generate_keystream(kBlocks);
+        timer.stop();
+        ns.add(timer.elapsed_ns() / kBlocks);
+    }
+#ifdef _OPENMP
+    omp_set_num_threads(threads);
+#endif
+    return ns.median();
+}
+
+} // namespace
+
+/**
+ * @test PerfRegression.KeystreamYuS80
+ * @brief YuS-80（p=65537）明文密钥流每块耗时不超过基线
+ */
+TEST(PerfRegression, KeystreamYuS80) {
+    if (!perf_tests_enabled()) {
+        GTEST_SKIP() << "Set YUS_PERF_TESTS=1 to run performance regression tests";
+    }
+    check_metric("keystream_yus80_p65537_ns_per_block",
+                 keystream_ns_per_block(mpz_class(65537), yus::SecurityLevel::SEC80), "ns");
+}
+
+/**
+ * @test PerfRegression.KeystreamYuS128
+ * @brief YuS-128（p=4298506241）明文密钥流每块耗时不超过基线
+ */
+TEST(PerfRegression, KeystreamYuS128) {
+    if (!perf_tests_enabled()) {
+        GTEST_SKIP() << "Set YUS_PERF_TESTS=1 to run performance regression tests";
+    }
+    check_metric("keystream_yus128_p4298506241_ns_per_block",
+                 keystream_ns_per_block(mpz_class("4298506241"), yus::SecurityLevel::SEC128), "ns");
+}
+
+#ifdef ENABLE_FHE
+/**
+ * @test PerfRegression.FheEvalBFV
+ * @brief BFV、p=65537、YuS-80自动选择参数时一次同态评估的耗时不超过基线
+ *
+ * 取两次评估的较小值；参数选择变得更保守（N变大）同样表现为变慢。
+ */
+TEST(PerfRegression, FheEvalBFV) {
+    if (!perf_tests_enabled()) {
+        GTEST_SKIP() << "Set YUS_PERF_TESTS=1 to run performance regression tests";
+    }
+    const mpz_class p(65537);
+    const auto level = yus::SecurityLevel::SEC80;
+    auto params = yus::select_fhe_params(yus::FHE_SCHEME::BFV, p, 80, static_cast<uint32_t>(level));
+    yus::FHEWrapper wrapper(yus::FHE_SCHEME::BFV, params);
+    std::vector<mpz_class> master_key(36);
+    for (size_t i = 0; i < 36; ++i) {
+        master_key[i] = static_cast<unsigned long>(1000 * i + 7);
+    }
+    std::vector<yus::Ciphertext> cipher_key;
+    std::vector<yus::Ciphertext> cipher_ks;
+    wrapper.encrypt_key(master_key, cipher_key);
+    const yus::YuSEvalParams eval_params{{0x01, 0x02, 0x03, 0x04}, level, 12, 0, 0, {}};
+
+    yus::SampleStats ms;
+    for (int trial = 0; trial < 2; ++trial) {
+        ms.add(wrapper.evaluate_yus(cipher_key, eval_params, cipher_ks));
+    }
+    std::cout << "[PERF] BFV N=" << params.poly_modulus_degree << ", " << wrapper.slot_count() << " blocks"
+              << std::endl;
+    check_metric("fhe_bfv_yus80_p65537_eval_ms", ms.min(), "ms");
+}
+#endif
@@ -0,0 +1,122 @@
+/**
+ * @file test_thread_pool.cpp
+ * @brief YuS流密码持久线程池测试
+ * @author Aurorp1g
+ * @date 2025-11-07
+ *
+ * 使用Google Test框架对同态评估使用的持久线程池进行单元测试。
+ * 包含任务覆盖、工作者编号、异常传播和嵌套调用测试。
+ */
+
+#include "yus/thread_pool.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+/**
+ * @test ThreadPoolTest.ParallelFor
+ * @brief 测试parallel_for的任务覆盖
+ *
+ * 验证线程池在多次复用时：
+ * - 每个任务索引恰好执行一次
+ * - 回调收到的工作者编号小于线程池大小
+ */
+TEST(ThreadPoolTest, ParallelFor) {
+    yus::ThreadPool pool(4);
+    EXPECT_EQ(pool.size(), 4ULL);
+
+    // 多次提交以验证常驻线程可复用
+    for (int round = 0; round < 10; ++round) {
+        std::vector<std::atomic<int>> hits(1000);
+        std::atomic<bool> worker_in_range(true);
+
+        pool.parallel_for(hits.size(), [&](size_t i, size_t worker) {
+            hits[i].fetch_add(1);
+            if (worker >= pool.size()) {
+                worker_in_range = false;
+            }
+        });
+
+        for (size_t i = 0; i < hits.size(); ++i) {
+            EXPECT_EQ(hits[i].load(), 1) << "Task " << i << " in round " << round;
+        }
+        EXPECT_TRUE(worker_in_range.load());
+    }
+}
+
+/**
+ * @test ThreadPoolTest.Exception
+ * @brief 测试任务异常传播
+ *
+ * 验证任务中抛出的异常在调用线程中重新抛出，且线程池随后仍可正常使用。
+ */
+TEST(ThreadPoolTest, Exception) {
+    yus::ThreadPool pool(3);
+
+    EXPECT_THROW(pool.parallel_for(100, [](size_t i, size_t) {
+        if (i == 42) {
+            throw std::runtime_error("task failed");
+        }
+    }), std::runtime_error);
+
+    std::atomic<size_t> count(0);
+    pool.parallel_for(100, [&](size_t, size_t) { count.fetch_add(1); });
+    EXPECT_EQ(count.load(), 100ULL);
+}
+
+/**
+ * @test ThreadPoolTest.Nested
+ * @brief 测试嵌套parallel_for
+ *
+ * 验证在任务内部再次调用parallel_for时在当前线程串行执行，不会死锁，
+ * 且内层任务沿用外层的工作者编号。
+ */
+TEST(ThreadPoolTest, Nested) {
+    yus::ThreadPool pool(4);
+    std::atomic<size_t> count(0);
+    std::atomic<bool> same_worker(true);
+
+    pool.parallel_for(8, [&](size_t, size_t outer_worker) {
+        pool.parallel_for(8, [&](size_t, size_t inner_worker) {
+            count.fetch_add(1);
+            if (inner_worker != outer_worker) {
+                same_worker = false;
+            }
+        });
+    });
+
+    EXPECT_EQ(count.load(), 64ULL);
+    EXPECT_TRUE(same_worker.load());
+}
+
+/**
+ * @test ThreadPoolTest.NestedAcrossPools
+ * @brief 测试在一个线程池的任务中调用另一个线程池的parallel_for
+ *
+ * 验证内层任务的工作者编号小于内层线程池的size()（不沿用外层编号），
+ * 内层返回后当前线程在外层线程池中的编号不变。
+ */
+TEST(ThreadPoolTest, NestedAcrossPools) {
+    yus::ThreadPool outer(4);
+    yus::ThreadPool inner(1);
+    std::atomic<size_t> count(0);
+    std::atomic<bool> in_range(true);
+    std::atomic<bool> restored(true);
+
+    outer.parallel_for(16, [&](size_t, size_t outer_worker) {
+        inner.parallel_for(4, [&](size_t, size_t inner_worker) {
+            count.fetch_add(1);
+            if (inner_worker >= inner.size()) {
+                in_range = false;
+            }
+        });
+        if (yus::ThreadPool::current_worker() != outer_worker) {
+            restored = false;
+        }
+    });
+
+    EXPECT_EQ(count.load(), 64ULL);
+    EXPECT_TRUE(in_range.load());
+    EXPECT_TRUE(restored.load());
+}
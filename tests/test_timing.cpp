@@ -0,0 +1,83 @@
+/**
+ * @file test_timing.cpp
+ * @brief YuS流密码计时组件测试
+ * @author Aurorp1g
+ * @date 2025-11-07
+ *
+ * 使用Google Test框架对计时器和样本统计累加器进行单元测试。
+ */
+
+#include "yus/timing.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <thread>
+
+/**
+ * @test TimingTest.SampleStats
+ * @brief 测试样本统计
+ *
+ * 验证乱序加入的样本：
+ * - 最小值、最大值、平均值和中位数正确
+ * - p99按最近秩取值，标准差按n-1计算
+ * - merge和clear后结果正确
+ */
+TEST(TimingTest, SampleStats) {
+    yus::SampleStats stats;
+    EXPECT_EQ(stats.median(), 0.0);
+    EXPECT_EQ(stats.stddev(), 0.0);
+
+    for (int v : {5, 1, 4, 2, 3}) {
+        stats.add(v);
+    }
+    EXPECT_EQ(stats.count(), 5u);
+    EXPECT_DOUBLE_EQ(stats.min(), 1.0);
+    EXPECT_DOUBLE_EQ(stats.max(), 5.0);
+    EXPECT_DOUBLE_EQ(stats.mean(), 3.0);
+    EXPECT_DOUBLE_EQ(stats.median(), 3.0);
+    EXPECT_DOUBLE_EQ(stats.percentile(0.99), 5.0);
+    EXPECT_DOUBLE_EQ(stats.percentile(0.2), 1.0);
+    EXPECT_NEAR(stats.stddev(), 1.5811388, 1e-6);
+
+    yus::SampleStats more;
+    more.add(0);
+    stats.merge(more);
+    EXPECT_DOUBLE_EQ(stats.min(), 0.0);
+    EXPECT_DOUBLE_EQ(stats.median(), 2.5);
+
+    stats.clear();
+    EXPECT_EQ(stats.count(), 0u);
+}
+
+/**
+ * @test TimingTest.Timer
+ * @brief 测试稳定时钟和TSC计时
+ *
+ * 验证：
+ * - 稳定时钟计时的毫秒数与休眠时间相符，纳秒精度不被截断
+ * - TSC可用时频率已校准，TSC计时换算的时间与稳定时钟一致；不可用时退化为稳定时钟
+ */
+TEST(TimingTest, Timer) {
+    yus::Timer timer;
+    EXPECT_EQ(timer.clock(), yus::TimerClock::STEADY);
+    timer.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    timer.stop();
+    EXPECT_GE(timer.elapsed_ms(), 19.0);
+    EXPECT_LT(timer.elapsed_ms(), 1000.0);
+    EXPECT_DOUBLE_EQ(timer.elapsed_ns(), static_cast<double>(timer.elapsed_ticks()));
+
+    yus::Timer tsc_timer(yus::TimerClock::TSC);
+    if (!yus::tsc_available()) {
+        EXPECT_EQ(tsc_timer.clock(), yus::TimerClock::STEADY);
+        EXPECT_EQ(yus::tsc_ghz(), 0.0);
+        return;
+    }
+    EXPECT_EQ(tsc_timer.clock(), yus::TimerClock::TSC);
+    EXPECT_GT(yus::tsc_ghz(), 0.1);
+    tsc_timer.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    tsc_timer.stop();
+    EXPECT_GE(tsc_timer.elapsed_ms(), 18.0);
+    EXPECT_LT(tsc_timer.elapsed_ms(), 1000.0);
+    EXPECT_DOUBLE_EQ(tsc_timer.elapsed_cycles(), static_cast<double>(tsc_timer.elapsed_ticks()));
+}
@@ -0,0 +1,71 @@
+/**
+ * @file test_trace.cpp
+ * @brief YuS流密码评估时间线记录测试
+ * @author Aurorp1g
+ * @date 2025-11-07
+ *
+ * 使用Google Test框架对TraceRecorder和TraceSpan进行单元测试。
+ */
+
+#include "yus/trace.h"
+#include "yus/thread_pool.h"
+#include <gtest/gtest.h>
+#include <sstream>
+
+/**
+ * @test TraceTest.SpansAndJson
+ * @brief 测试时间跨度记录和Chrome trace-event JSON输出
+ *
+ * 验证：
+ * - 空记录器指针的TraceSpan不记录任何事件
+ * - 线程池各工作者的时间跨度都被记录，线程编号与工作者编号一致
+ * - JSON包含traceEvents、线程名元数据、以微秒为单位的ts/dur和args
+ * - clear()清空事件
+ */
+TEST(TraceTest, SpansAndJson) {
+    yus::TraceRecorder recorder;
+    {
+        yus::TraceSpan ignored(nullptr, "ignored", "test", 0);
+    }
+    EXPECT_EQ(recorder.size(), 0u);
+
+    yus::ThreadPool pool(2);
+    pool.parallel_for(8, [&](size_t i, size_t worker) {
+        yus::TraceSpan span(&recorder, "task", "test", static_cast<uint32_t>(worker), static_cast<int64_t>(i), 3);
+    });
+    {
+        yus::TraceSpan span(&recorder, "outer", "round", 0, 1);
+    }
+    recorder.record("manual", "fhe", 1, 5000, 7500);
+
+    const auto events = recorder.events();
+    ASSERT_EQ(events.size(), 10u);
+    std::vector<bool> seen(8, false);
+    for (const auto& event : events) {
+        EXPECT_LT(event.tid, pool.size());
+        if (event.name == "task") {
+            ASSERT_GE(event.index, 0);
+            ASSERT_LT(event.index, 8);
+            seen[static_cast<size_t>(event.index)] = true;
+            EXPECT_EQ(event.level, 3);
+        }
+    }
+    for (bool s : seen) {
+        EXPECT_TRUE(s);
+    }
+    EXPECT_EQ(events.back().duration_ns, 2500u);
+
+    std::ostringstream json;
+    recorder.write_json(json);
+    const std::string text = json.str();
+    EXPECT_EQ(text.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["), 0u);
+    EXPECT_NE(text.find("\"args\":{\"name\":\"caller\"}"), std::string::npos);
+    EXPECT_NE(text.find("\"name\":\"outer\",\"cat\":\"round\",\"ph\":\"X\""), std::string::npos);
+    EXPECT_NE(text.find("\"dur\":2.500,\"args\":{}"), std::string::npos);
+    EXPECT_NE(text.find("\"args\":{\"index\":1}"), std::string::npos);
+    EXPECT_NE(text.find("\"level\":3"), std::string::npos);
+    EXPECT_EQ(text.substr(text.size() - 4), "\n]}\n");
+
+    recorder.clear();
+    EXPECT_EQ(recorder.size(), 0u);
+}
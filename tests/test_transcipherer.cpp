@@ -0,0 +1,211 @@
+/**
+ * @file test_transcipherer.cpp
+ * @brief YuS流密码转密接口测试
+ * @author Aurorp1g
+ * @date 2025-11-07
+ *
+ * 使用Google Test框架对端到端转密接口进行单元测试。
+ * 客户端以明文YuSCipher加密数据，服务端转密后解密，结果应等于原始数据。
+ */
+
+#include "yus/transcipherer.h"
+#include "yus/transcipher_batcher.h"
+#include "yus/yus_core.h"
+#include <gtest/gtest.h>
+#include <iostream>
+#include <chrono>
+#include <future>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief 客户端加密：c = m + z mod p，跳过前first_block块的密钥流
+ */
+std::vector<uint64_t> client_encrypt(const mpz_class& p, yus::SecurityLevel level,
+                                     const std::vector<mpz_class>& master_key,
+                                     const std::vector<uint8_t>& nonce, uint32_t first_block,
+                                     const std::vector<uint64_t>& data) {
+    yus::YuSCipher cipher(p, level, 12);
+    cipher.init(master_key, nonce);
+    const uint32_t blocks = static_cast<uint32_t>((data.size() + 23) / 24);
+    auto keystream = cipher.generate_keystream(first_block + blocks);
+
+    std::vector<uint64_t> sym_ct(data.size());
+    for (size_t w = 0; w < data.size(); ++w) {
+        mpz_class c = (data[w] + keystream[first_block * 24 + w]) % p;
+        sym_ct[w] = c.get_ui();
+    }
+    return sym_ct;
+}
+
+} // namespace
+
+/**
+ * @test TranscipherTest.RoundTripBFV
+ * @brief 测试端到端转密
+ *
+ * 验证：
+ * - 非零首块、末块不足的对称密文转密后解密等于原始数据
+ * - 设置加密密钥乘积后转密结果不变
+ * - 离线预计算的密钥流命中缓存，在线评估时间为0
+ * - 吞吐量按⌈log2 p⌉比特每字计算
+ */
+TEST(TranscipherTest, RoundTripBFV) {
+    std::cout << "[TEST INFO] Testing end-to-end transciphering..." << std::endl;
+
+    try {
+        const mpz_class p(65537);
+        const auto level = yus::SecurityLevel::SEC80;
+        auto params = yus::select_fhe_params(yus::FHE_SCHEME::BFV, p, 80, static_cast<uint32_t>(level));
+        yus::FHEWrapper fhe(yus::FHE_SCHEME::BFV, params);
+
+        std::vector<mpz_class> master_key(36);
+        for (size_t i = 0; i < 36; ++i) {
+            master_key[i] = static_cast<unsigned long>(13 * i + 5);
+        }
+        std::vector<yus::Ciphertext> cipher_key;
+        fhe.encrypt_key(master_key, cipher_key);
+        yus::Transcipherer transcipherer(fhe, cipher_key, level, 12);
+        EXPECT_EQ(transcipherer.words_per_block(), 24u);
+        EXPECT_DOUBLE_EQ(transcipherer.data_bytes(1024 * 8), 17.0 * 1024);
+
+        // 5块减7个字，从第3块开始
+        const std::vector<uint8_t> nonce{0x0a, 0x0b, 0x0c};
+        const uint32_t first_block = 3;
+        std::vector<uint64_t> data(5 * 24 - 7);
+        for (size_t w = 0; w < data.size(); ++w) {
+            data[w] = (w * 7919 + 11) % 65537;
+        }
+        auto sym_ct = client_encrypt(p, level, master_key, nonce, first_block, data);
+
+        auto result = transcipherer.transcipher(nonce, first_block, sym_ct.data(), sym_ct.size());
+        std::cout << "[RESULTS] Transcipher: " << result.total_ms << " ms, "
+                  << result.throughput_kibps << " KiB/s" << std::endl;
+        EXPECT_EQ(result.blocks, 5u);
+        EXPECT_EQ(result.batches, 1u);
+        EXPECT_EQ(result.keystream_hits, 0u);
+        ASSERT_EQ(result.cipher_data.size(), 24u);
+        EXPECT_GT(result.throughput_kibps, 0.0);
+
+        auto decrypted = fhe.decrypt(result.cipher_data);
+        const size_t nslots = fhe.slot_count();
+        for (size_t w = 0; w < data.size(); ++w) {
+            EXPECT_EQ(decrypted[(w % 24) * nslots + w / 24], data[w]) << "Word " << w;
+        }
+
+        // 第一轮使用加密密钥乘积
+        std::vector<yus::Ciphertext> key_products;
+        fhe.precompute_key_products(cipher_key, key_products);
+        yus::Transcipherer product_transcipherer(fhe, cipher_key, level, 12);
+        product_transcipherer.set_key_products(key_products);
+        auto product_result = product_transcipherer.transcipher(nonce, first_block, sym_ct.data(), sym_ct.size());
+        auto product_decrypted = fhe.decrypt(product_result.cipher_data);
+        for (size_t w = 0; w < data.size(); ++w) {
+            EXPECT_EQ(product_decrypted[(w % 24) * nslots + w / 24], data[w]) << "Key products, word " << w;
+        }
+
+        // 离线预计算后命中缓存
+        yus::KeystreamStore store(0, 0);
+        yus::YuSEvalParams eval_params{nonce, level, 12, first_block, 0, {}};
+        store.precompute(fhe, "client", cipher_key, {}, eval_params);
+        transcipherer.set_keystream_store(&store, "client");
+        auto cached = transcipherer.transcipher(nonce, first_block, sym_ct.data(), sym_ct.size());
+        EXPECT_EQ(cached.keystream_hits, 1u);
+        EXPECT_EQ(cached.keystream_ms, 0.0);
+        auto cached_decrypted = fhe.decrypt(cached.cipher_data);
+        for (size_t w = 0; w < data.size(); ++w) {
+            EXPECT_EQ(cached_decrypted[(w % 24) * nslots + w / 24], data[w]) << "Word " << w;
+        }
+
+        EXPECT_THROW(transcipherer.transcipher(nonce, 0, sym_ct.data(), 0), std::invalid_argument);
+
+        std::cout << "[SUCCESS] Transciphering test completed" << std::endl;
+
+    } catch (const std::exception& e) {
+        std::cout << "[EXCEPTION] Transciphering test failed: " << e.what() << std::endl;
+        ADD_FAILURE() << "Exception in transciphering test: " << e.what();
+    }
+}
+
+/**
+ * @test TranscipherTest.BatcherBFV
+ * @brief 测试跨随机数合批和背压
+ *
+ * 验证：
+ * - 两个不同随机数的请求在截止时间后合并为一批，各自的槽解密为原始数据
+ * - 待处理块数超过上限时拒绝请求
+ * - 统计信息记录批次、槽占用和延迟
+ */
+TEST(TranscipherTest, BatcherBFV) {
+    std::cout << "[TEST INFO] Testing request batching..." << std::endl;
+
+    try {
+        const mpz_class p(65537);
+        const auto level = yus::SecurityLevel::SEC80;
+        auto params = yus::select_fhe_params(yus::FHE_SCHEME::BFV, p, 80, static_cast<uint32_t>(level));
+        yus::FHEWrapper fhe(yus::FHE_SCHEME::BFV, params);
+
+        std::vector<mpz_class> master_key(36);
+        for (size_t i = 0; i < 36; ++i) {
+            master_key[i] = static_cast<unsigned long>(19 * i + 2);
+        }
+        std::vector<yus::Ciphertext> cipher_key;
+        fhe.encrypt_key(master_key, cipher_key);
+
+        yus::TranscipherBatcher::Options options;
+        options.deadline = std::chrono::milliseconds(200);
+        options.max_queued_blocks = 5;
+        yus::TranscipherBatcher batcher(fhe, level, 12, options);
+        batcher.add_key("client", cipher_key);
+
+        const std::vector<uint8_t> nonce_a{0x01}, nonce_b{0x02, 0x03};
+        std::vector<uint64_t> data_a(2 * 24), data_b(3 * 24 - 5);
+        for (size_t w = 0; w < data_a.size(); ++w) {
+            data_a[w] = (w * 31 + 1) % 65537;
+        }
+        for (size_t w = 0; w < data_b.size(); ++w) {
+            data_b[w] = (w * 97 + 3) % 65537;
+        }
+
+        std::future<yus::TranscipherReply> reply_a, reply_b, reply_c;
+        ASSERT_TRUE(batcher.submit({"client", nonce_a, 0, client_encrypt(p, level, master_key, nonce_a, 0, data_a)},
+                                   reply_a));
+        ASSERT_TRUE(batcher.submit({"client", nonce_b, 7, client_encrypt(p, level, master_key, nonce_b, 7, data_b)},
+                                   reply_b));
+        EXPECT_FALSE(batcher.submit({"client", nonce_a, 2, std::vector<uint64_t>(24, 0)}, reply_c));
+        EXPECT_THROW(batcher.submit({"nobody", nonce_a, 0, std::vector<uint64_t>(24, 0)}, reply_c),
+                     std::invalid_argument);
+
+        const size_t nslots = fhe.slot_count();
+        auto a = reply_a.get();
+        auto b = reply_b.get();
+        std::cout << "[RESULTS] Batch latency: " << a.latency_ms << " ms (queue " << a.queue_ms
+                  << " ms, service " << a.service_ms << " ms)" << std::endl;
+        EXPECT_EQ(a.batch_blocks, 5u);
+        EXPECT_EQ(a.first_slot, 0u);
+        EXPECT_EQ(b.first_slot, 2u);
+        EXPECT_GE(a.queue_ms, 150.0);
+
+        auto decrypted = fhe.decrypt(b.cipher_data);
+        for (size_t w = 0; w < data_a.size(); ++w) {
+            EXPECT_EQ(decrypted[(w % 24) * nslots + a.first_slot + w / 24], data_a[w]) << "Request A word " << w;
+        }
+        for (size_t w = 0; w < data_b.size(); ++w) {
+            EXPECT_EQ(decrypted[(w % 24) * nslots + b.first_slot + w / 24], data_b[w]) << "Request B word " << w;
+        }
+
+        auto stats = batcher.stats();
+        EXPECT_EQ(stats.requests, 2u);
+        EXPECT_EQ(stats.rejected, 1u);
+        EXPECT_EQ(stats.batches, 1u);
+        EXPECT_EQ(stats.filled_slots, 5u);
+        EXPECT_EQ(stats.queued_blocks, 0u);
+
+        std::cout << "[SUCCESS] Request batching test completed" << std::endl;
+
+    } catch (const std::exception& e) {
+        std::cout << "[EXCEPTION] Request batching test failed: " << e.what() << std::endl;
+        ADD_FAILURE() << "Exception in request batching test: " << e.what();
+    }
+}
@@ -0,0 +1,65 @@
+/**
+ * @file cli_utils.h
+ * @brief 命令行工具共用的辅助函数
+ * @author Aurorp1g
+ * @date 2025-11-07
+ *
+ * 供tools/下的基准、守护进程和examples/下的演示程序共用：
+ * 数值选项解析和JSON字符串转义。仅头文件，不进入yus库。
+ */
+
+#ifndef YUS_CLI_UTILS_H
+#define YUS_CLI_UTILS_H
+
+#include <stdexcept>
+#include <string>
+
+namespace yus {
+namespace cli {
+
+/**
+ * @brief 解析命令行数值选项
+ * @param name 选项名，用于错误信息
+ * @param value 选项值
+ * @return 解析得到的无符号整数
+ * @throws std::invalid_argument 选项值不是数字或为负数
+ *
+ * std::stoul接受负号并按模2^64回绕（"-1"得到ULONG_MAX），因此先拒绝前导'-'。
+ */
+inline unsigned long parse_number(const char* name, const char* value) {
+    const std::string text(value);
+    const std::string error = std::string("Invalid value for ") + name + ": " + text;
+    const size_t first = text.find_first_not_of(" \t\n\v\f\r");
+    if (first != std::string::npos && text[first] == '-') {
+        throw std::invalid_argument(error);
+    }
+    try {
+        return std::stoul(text);
+    } catch (const std::exception&) {
+        throw std::invalid_argument(error);
+    }
+}
+
+/**
+ * @brief 转义JSON字符串
+ * @return 带引号的JSON字符串；控制字符替换为空格
+ */
+inline std::string json_string(const std::string& s) {
+    std::string out = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            out += ' ';
+        } else {
+            out += c;
+        }
+    }
+    return out + "\"";
+}
+
+} // namespace cli
+} // namespace yus
+
+#endif // YUS_CLI_UTILS_H
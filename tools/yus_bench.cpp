@@ -0,0 +1,457 @@
+/**
+ * @file yus_bench.cpp
+ * @brief YuS流密码明文组件微基准
+ * @author Aurorp1g
+ * @date 2025-11-07
+ *
+ * 对S盒、S盒层、线性层、轮常数、轮密钥和完整密钥流生成分别计时，
+ * 每项先预热，再重复多次取中位数和p99，输出表格或JSON。
+ *
+ * 用法：yus_bench [选项]
+ *   --p P              素数模数（默认65537）
+ *   --level 80|128     安全级别（默认80）
+ *   --trunc M          截断位数（默认12）
+ *   --blocks B         密钥流块数（默认16384，与技术文档表7.2一致）
+ *   --trials T         每项的计时次数（默认11）
+ *   --warmup W         每项的预热次数（默认1）
+ *   --clock tsc|steady 计时时钟（默认tsc，不可用时退化为steady）
+ *   --cpu-ghz F        按该频率把时间换算为周期，替代TSC周期
+ *   --no-perf          不读取硬件计数器
+ *   --perf-raw NAME=CFG 追加原始硬件事件（CFG为十六进制编码，可重复），例如Skylake-SP的
+ *                      AVX频率许可：core_power.lvl1=0x1828、core_power.lvl2=0x2028
+ *   --zero-alloc K     断言组件K（例如keystream）的计时区间不分配堆内存，可重复；
+ *                      需要YUS_ALLOC_TRACKING构建，违反时以状态3退出
+ *   --json             输出单个JSON对象
+ *
+ * CPB（每字节周期数）的字节数经yus::field_word_bytes（utils.h）换算，
+ * 即块数·(36-trunc_m)个字。周期默认为TSC周期（标称频率），
+ * 组件的CPB按其在一个块中的调用次数折算，便于与完整密钥流的CPB对照。
+ * 以YUS_INSTRUMENT构建时，另外输出完整密钥流各阶段的插桩计数。
+ *
+ * Linux上每次计时区间同时读取硬件计数器（仅用户态），输出每块的IPC、L1数据缓存未命中、
+ * 末级缓存未命中和分支预测失败。计数器在任何并行区之前打开并继承给OpenMP线程组，
+ * 因此S盒层和线性层的计数包含所有工作线程；计数器不可用（容器、虚拟机）时只输出计时结果并提示原因。
+ *
+ * 以YUS_ALLOC_TRACKING构建时，另外输出每块的堆分配次数和字节数（operator new与GMP分配之和），
+ * 统计计时区间内所有线程的分配，包括OpenMP线程组。
+ */
+
+#include "yus/yus_core.h"
+#include "yus/sbox.h"
+#include "yus/linear_layer.h"
+#include "yus/round_key.h"
+#include "yus/timing.h"
+#include "yus/instrument.h"
+#include "yus/perf_counters.h"
+#include "yus/alloc_tracker.h"
+#include "yus/utils.h"
+#include "cli_utils.h"
+#include <algorithm>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+using yus::cli::json_string;
+using yus::cli::parse_number;
+
+/// 硬件计数器的统计范围：主线程及其之后创建的线程（OpenMP线程组）
+const char* const kPerfScope = "main thread and the OpenMP team it spawns";
+
+/**
+ * @struct KernelResult
+ * @brief 单个组件的计时结果
+ */
+struct KernelResult {
+    std::string name;          ///< 组件名
+    uint64_t ops_per_sample;   ///< 每次计时包含的调用次数
+    double ops_per_block;      ///< 生成一个密钥流块的调用次数
+    yus::SampleStats ns;       ///< 每次调用的耗时（纳秒）
+    yus::SampleStats cycles;   ///< 每次调用的周期数
+    std::vector<double> perf;  ///< 各硬件计数器在所有计时区间内的累计值
+    uint64_t perf_ops = 0;     ///< 累计值对应的调用次数
+    yus::AllocCounts alloc;    ///< 所有计时区间内所有线程（含OpenMP线程组）的堆分配
+};
+
+/**
+ * @brief 预热后重复计时
+ * @param clock 计时时钟
+ * @param cpu_ghz 大于0时按该频率换算周期
+ * @param warmup 预热次数
+ * @param trials 计时次数
+ * @param body 被测代码，每次执行ops次调用
+ * @param perf 硬件计数器，为空时不读取；计数区间包住计时区间，系统调用不计入耗时
+ * @param result 输出每次调用的耗时和周期样本，以及硬件计数器和堆分配的累计值
+ */
+void measure(yus::TimerClock clock, double cpu_ghz, uint32_t warmup, uint32_t trials,
+             const std::function<void()>& body, yus::PerfCounters* perf, KernelResult& result) {
+    for (uint32_t i = 0; i < warmup; ++i) {
+        body();
+    }
+    const double ops = static_cast<double>(result.ops_per_sample);
+    if (perf) {
+        result.perf.assign(perf->counters().size(), 0.0);
+    }
+    yus::Timer timer(clock);
+    for (uint32_t i = 0; i < trials; ++i) {
+        if (perf) {
+            perf->start();
+        }
+        // S盒层和线性层在OpenMP线程组上运行，分配按全局计数统计
+        const auto alloc_before = yus::alloc_counts();
+        timer.start();
+        body();
+        timer.stop();
+        const auto alloc_delta = yus::alloc_counts() - alloc_before;
+        result.alloc.allocations += alloc_delta.allocations;
+        result.alloc.bytes += alloc_delta.bytes;
+        result.alloc.frees += alloc_delta.frees;
+        if (perf) {
+            perf->stop();
+            for (size_t c = 0; c < result.perf.size(); ++c) {
+                result.perf[c] += perf->counters()[c].value;
+            }
+            result.perf_ops += result.ops_per_sample;
+        }
+        result.ns.add(timer.elapsed_ns() / ops);
+        result.cycles.add((cpu_ghz > 0 ? timer.elapsed_ns() * cpu_ghz : timer.elapsed_cycles()) / ops);
+    }
+}
+
+/**
+ * @brief 某个硬件计数器折算到每个密钥流块的值
+ * @return 计数器不可用时返回-1
+ */
+double perf_per_block(const yus::PerfCounters& perf, const KernelResult& r, size_t c) {
+    if (c >= r.perf.size() || perf.counters()[c].fd < 0 || r.perf_ops == 0) {
+        return -1;
+    }
+    return r.perf[c] / static_cast<double>(r.perf_ops) * r.ops_per_block;
+}
+
+/**
+ * @brief 堆分配折算到每个密钥流块
+ * @param r 计时结果
+ * @param trials 计时次数
+ * @param bytes 为true时返回字节数，否则返回次数
+ */
+double alloc_per_block(const KernelResult& r, uint32_t trials, bool bytes) {
+    const double total = static_cast<double>(bytes ? r.alloc.bytes : r.alloc.allocations);
+    return total / (static_cast<double>(trials) * static_cast<double>(r.ops_per_sample)) * r.ops_per_block;
+}
+
+/**
+ * @brief 指令数与周期数之比
+ * @return 任一计数器不可用时返回-1
+ */
+double perf_ipc(const yus::PerfCounters& perf, const KernelResult& r) {
+    const double cycles = perf_per_block(perf, r, 0);
+    const double instructions = perf_per_block(perf, r, 1);
+    return cycles > 0 && instructions >= 0 ? instructions / cycles : -1;
+}
+
+void usage() {
+    std::cerr << "Usage: yus_bench [--p P] [--level 80|128] [--trunc M] [--blocks B] [--trials T]\n"
+                 "                 [--warmup W] [--clock tsc|steady] [--cpu-ghz F] [--no-perf]\n"
+                 "                 [--perf-raw NAME=CFG]... [--zero-alloc KERNEL]... [--json]"
+              << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    mpz_class p(65537);
+    yus::SecurityLevel level = yus::SecurityLevel::SEC80;
+    uint32_t trunc_m = 12;
+    uint32_t blocks = 16384;
+    uint32_t trials = 11;
+    uint32_t warmup = 1;
+    double cpu_ghz = 0;
+    yus::TimerClock clock = yus::TimerClock::TSC;
+    bool json = false;
+    bool use_perf = true;
+    std::vector<std::pair<std::string, uint64_t>> raw_events;
+    std::vector<std::string> zero_alloc;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            if (arg == "--json") {
+                json = true;
+                continue;
+            }
+            if (arg == "--no-perf") {
+                use_perf = false;
+                continue;
+            }
+            if (i + 1 >= argc) {
+                usage();
+                return 2;
+            }
+            const char* value = argv[++i];
+            if (arg == "--p") {
+                p = mpz_class(value);
+            } else if (arg == "--level") {
+                const unsigned long bits = parse_number("--level", value);
+                if (bits != 80 && bits != 128) {
+                    throw std::invalid_argument("--level must be 80 or 128");
+                }
+                level = bits == 80 ? yus::SecurityLevel::SEC80 : yus::SecurityLevel::SEC128;
+            } else if (arg == "--trunc") {
+                trunc_m = static_cast<uint32_t>(parse_number("--trunc", value));
+            } else if (arg == "--blocks") {
+                blocks = static_cast<uint32_t>(parse_number("--blocks", value));
+            } else if (arg == "--trials") {
+                trials = static_cast<uint32_t>(parse_number("--trials", value));
+            } else if (arg == "--warmup") {
+                warmup = static_cast<uint32_t>(parse_number("--warmup", value));
+            } else if (arg == "--clock") {
+                const std::string name = value;
+                if (name != "tsc" && name != "steady") {
+                    throw std::invalid_argument("--clock must be tsc or steady");
+                }
+                clock = name == "tsc" ? yus::TimerClock::TSC : yus::TimerClock::STEADY;
+            } else if (arg == "--cpu-ghz") {
+                cpu_ghz = std::stod(value);
+            } else if (arg == "--zero-alloc") {
+                zero_alloc.push_back(value);
+            } else if (arg == "--perf-raw") {
+                const std::string spec = value;
+                const size_t eq = spec.find('=');
+                if (eq == 0 || eq == std::string::npos) {
+                    throw std::invalid_argument("--perf-raw expects NAME=CONFIG");
+                }
+                try {
+                    raw_events.emplace_back(spec.substr(0, eq), std::stoull(spec.substr(eq + 1), nullptr, 16));
+                } catch (const std::exception&) {
+                    throw std::invalid_argument("Invalid value for --perf-raw: " + spec);
+                }
+            } else {
+                usage();
+                return 2;
+            }
+        }
+        if (trunc_m >= 36 || blocks == 0 || trials == 0) {
+            throw std::invalid_argument("Need trunc < 36, blocks > 0 and trials > 0");
+        }
+        if (!zero_alloc.empty() && !yus::alloc_tracking_enabled()) {
+            throw std::invalid_argument("--zero-alloc requires a build with -DYUS_ALLOC_TRACKING=ON");
+        }
+        const bool has_cycles = cpu_ghz > 0 || yus::tsc_available();
+        const double cycle_ghz = cpu_ghz > 0 ? cpu_ghz : yus::tsc_ghz();
+        const char* clock_name = yus::Timer(clock).clock() == yus::TimerClock::TSC ? "tsc" : "steady";
+
+        // 计数器继承给之后创建的线程，必须在第一个OpenMP并行区创建线程组之前打开
+        yus::PerfCounters perf;
+        for (const auto& raw : raw_events) {
+            perf.add_raw(raw.first, raw.second);
+        }
+        const bool has_perf = use_perf && perf.available();
+
+        const uint32_t rounds = static_cast<uint32_t>(level);
+        const size_t word_bits = mpz_sizeinbase(p.get_mpz_t(), 2);
+        const double block_bytes = yus::field_word_bytes(p, 36 - trunc_m);
+
+        std::vector<mpz_class> master_key(36);
+        std::vector<mpz_class> state(36);
+        for (size_t i = 0; i < 36; ++i) {
+            master_key[i] = mpz_class(static_cast<unsigned long>(7919 * i + 1)) % p;
+            state[i] = mpz_class(static_cast<unsigned long>(104729 * i + 3)) % p;
+        }
+        const std::vector<uint8_t> nonce{0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07};
+
+        yus::SBox sbox(p);
+        yus::LinearLayer linear_layer;
+        yus::RoundKeyGenerator rk_gen(nonce, rounds);
+        yus::YuSCipher cipher(p, level, trunc_m);
+        cipher.init(master_key, nonce);
+        const auto rc = rk_gen.generate_round_constant(1, 0, p);
+
+        // 结果累加到sink，防止编译器删除被测调用
+        size_t sink = 0;
+        const std::vector<mpz_class> triple(state.begin(), state.begin() + 3);
+
+        struct Kernel {
+            std::string name;
+            uint64_t ops;
+            double ops_per_block;
+            std::function<void()> body;
+        };
+        // 单次调用远短于时钟分辨率的组件每次计时包含kInnerOps次调用
+        constexpr uint32_t kInnerOps = 512;
+        std::vector<Kernel> kernels = {
+            {"sbox", kInnerOps, 12.0 * rounds, [&] {
+                for (uint32_t k = 0; k < kInnerOps; ++k) {
+                    sink += sbox.apply(triple).size();
+                }
+            }},
+            {"sbox_layer", kInnerOps, static_cast<double>(rounds), [&] {
+                for (uint32_t k = 0; k < kInnerOps; ++k) {
+                    sink += yus::apply_sbox_layer(state, p).size();
+                }
+            }},
+            {"linear_layer", kInnerOps, rounds + 1.0, [&] {
+                for (uint32_t k = 0; k < kInnerOps; ++k) {
+                    sink += linear_layer.apply(state, p).size();
+                }
+            }},
+            {"round_constant", kInnerOps, rounds + 1.0, [&] {
+                for (uint32_t k = 0; k < kInnerOps; ++k) {
+                    sink += rk_gen.generate_round_constant(1, k, p).size();
+                }
+            }},
+            {"round_key", kInnerOps, rounds + 1.0, [&] {
+                for (uint32_t k = 0; k < kInnerOps; ++k) {
+                    sink += rk_gen.generate_round_key(master_key, rc, p).size();
+                }
+            }},
+            {"keystream", blocks, 1.0, [&] {
+                sink += cipher.generate_keystream(blocks).size();
+            }},
+        };
+
+        std::vector<KernelResult> results;
+        for (const auto& kernel : kernels) {
+            // 插桩计数只统计最后的完整密钥流，按阶段拆分其耗时
+            if (kernel.name == "keystream") {
+                yus::instrument_reset();
+            }
+            results.push_back(KernelResult{kernel.name, kernel.ops, kernel.ops_per_block, {}, {}, {}, 0, {}});
+            measure(clock, cpu_ghz, warmup, trials, kernel.body, has_perf ? &perf : nullptr, results.back());
+        }
+        const auto counters = yus::instrument_snapshot();
+        auto cpb = [&](const KernelResult& r) {
+            return r.cycles.median() * r.ops_per_block / block_bytes;
+        };
+
+        if (json) {
+            std::cout << "{\"p\":\"" << p.get_str() << "\",\"level\":" << (rounds == 5 ? 80 : 128)
+                      << ",\"rounds\":" << rounds << ",\"trunc_m\":" << trunc_m << ",\"blocks\":" << blocks
+                      << ",\"trials\":" << trials << ",\"warmup\":" << warmup
+                      << ",\"word_bits\":" << word_bits << ",\"clock\":\"" << clock_name
+                      << "\",\"cycle_ghz\":" << cycle_ghz << ",\"kernels\":[";
+            for (size_t k = 0; k < results.size(); ++k) {
+                const auto& r = results[k];
+                std::cout << (k ? "," : "") << "{\"name\":\"" << r.name << "\",\"ops_per_sample\":"
+                          << r.ops_per_sample << ",\"ops_per_block\":" << r.ops_per_block
+                          << ",\"min_ns\":" << r.ns.min() << ",\"median_ns\":" << r.ns.median()
+                          << ",\"p99_ns\":" << r.ns.percentile(0.99) << ",\"stddev_ns\":" << r.ns.stddev()
+                          << ",\"median_cycles\":" << r.cycles.median() << ",\"cpb\":" << cpb(r);
+                if (has_perf) {
+                    // 不可用的计数器输出null
+                    std::cout << ",\"perf_per_block\":{";
+                    for (size_t c = 0; c < perf.counters().size(); ++c) {
+                        const double v = perf_per_block(perf, r, c);
+                        std::cout << (c ? "," : "") << json_string(perf.counters()[c].name) << ":";
+                        if (v >= 0) {
+                            std::cout << v;
+                        } else {
+                            std::cout << "null";
+                        }
+                    }
+                    const double ipc = perf_ipc(perf, r);
+                    std::cout << "},\"ipc\":";
+                    if (ipc >= 0) {
+                        std::cout << ipc;
+                    } else {
+                        std::cout << "null";
+                    }
+                }
+                if (yus::alloc_tracking_enabled()) {
+                    std::cout << ",\"allocs_per_block\":" << alloc_per_block(r, trials, false)
+                              << ",\"alloc_bytes_per_block\":" << alloc_per_block(r, trials, true);
+                }
+                std::cout << "}";
+            }
+            std::cout << "],\"perf_available\":" << (has_perf ? "true" : "false");
+            if (has_perf) {
+                std::cout << ",\"perf_scope\":\"" << kPerfScope << "\"";
+            }
+            if (use_perf && !perf.error().empty()) {
+                std::cout << ",\"perf_error\":" << json_string(perf.error());
+            }
+            if (yus::instrument_enabled()) {
+                std::cout << ",\"keystream_counters\":" << counters.to_json();
+            }
+            std::cout << ",\"sink\":" << sink << "}" << std::endl;
+        } else {
+            std::cout << "YuS-" << (rounds == 5 ? 80 : 128) << " p=" << p.get_str() << " (" << word_bits
+                      << " bits/word), trunc=" << trunc_m << ", blocks=" << blocks << ", trials=" << trials
+                      << ", clock=" << clock_name << ", cycles at " << cycle_ghz << " GHz" << std::endl;
+            std::cout << std::left << std::setw(16) << "kernel" << std::right << std::setw(14) << "median ns/op"
+                      << std::setw(14) << "p99 ns/op" << std::setw(12) << "stddev %" << std::setw(12)
+                      << "ops/block" << std::setw(12) << "CPB" << std::endl;
+            for (const auto& r : results) {
+                const double spread = r.ns.mean() > 0 ? 100.0 * r.ns.stddev() / r.ns.mean() : 0.0;
+                std::cout << std::left << std::setw(16) << r.name << std::right << std::fixed
+                          << std::setprecision(1) << std::setw(14) << r.ns.median() << std::setw(14)
+                          << r.ns.percentile(0.99) << std::setw(12) << spread << std::setw(12) << r.ops_per_block
+                          << std::setw(12) << cpb(r) << std::endl;
+            }
+            std::cout << "keystream CPB is comparable to tech doc table 7.2 (439 for YuS-80, 479 for YuS-128)"
+                      << std::endl;
+            if (has_perf) {
+                // 每块的硬件计数，-1表示该计数器不可用
+                std::cout << "hardware counters per block (user space, " << kPerfScope << "):" << std::endl;
+                std::cout << std::left << std::setw(16) << "kernel" << std::right << std::setw(8) << "IPC";
+                for (size_t c = 2; c < perf.counters().size(); ++c) {
+                    std::cout << std::setw(16) << perf.counters()[c].name;
+                }
+                std::cout << std::endl;
+                for (const auto& r : results) {
+                    std::cout << std::left << std::setw(16) << r.name << std::right << std::setprecision(2)
+                              << std::setw(8) << perf_ipc(perf, r) << std::setprecision(1);
+                    for (size_t c = 2; c < perf.counters().size(); ++c) {
+                        std::cout << std::setw(16) << perf_per_block(perf, r, c);
+                    }
+                    std::cout << std::endl;
+                }
+            }
+            if (yus::alloc_tracking_enabled()) {
+                std::cout << "heap allocations per block (operator new + GMP):" << std::endl;
+                std::cout << std::left << std::setw(16) << "kernel" << std::right << std::setw(16) << "allocs"
+                          << std::setw(16) << "bytes" << std::endl;
+                for (const auto& r : results) {
+                    std::cout << std::left << std::setw(16) << r.name << std::right << std::setprecision(1)
+                              << std::setw(16) << alloc_per_block(r, trials, false) << std::setw(16)
+                              << alloc_per_block(r, trials, true) << std::endl;
+                }
+            }
+            if (yus::instrument_enabled()) {
+                std::cout << "keystream stages (" << warmup + trials << " runs):" << std::endl;
+                counters.print(std::cout);
+            }
+        }
+        if (use_perf && !perf.error().empty()) {
+            std::cerr << "[yus_bench] Hardware counter unavailable (" << perf.error() << ")"
+                      << (has_perf ? "" : ", reporting timing only") << std::endl;
+        }
+        if (!has_cycles) {
+            std::cerr << "[yus_bench] No invariant TSC, pass --cpu-ghz to report CPB" << std::endl;
+        }
+
+        // 零分配断言：指定组件的任一计时区间分配了堆内存即失败
+        bool zero_alloc_ok = true;
+        for (const auto& name : zero_alloc) {
+            auto it = std::find_if(results.begin(), results.end(),
+                                   [&](const KernelResult& r) { return r.name == name; });
+            if (it == results.end()) {
+                throw std::invalid_argument("Unknown kernel for --zero-alloc: " + name);
+            }
+            if (it->alloc.allocations != 0) {
+                std::cerr << "[yus_bench] Zero-allocation assertion failed: " << name << " made "
+                          << it->alloc.allocations << " allocations (" << it->alloc.bytes << " bytes) in "
+                          << trials << " trials" << std::endl;
+                zero_alloc_ok = false;
+            }
+        }
+        return zero_alloc_ok ? 0 : 3;
+    } catch (const std::exception& e) {
+        std::cerr << "[yus_bench] " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,429 @@
+/**
+ * @file yus_fhe_bench.cpp
+ * @brief YuS流密码服务端同态基准
+ * @author Aurorp1g
+ * @date 2025-11-07
+ *
+ * 按技术文档表7.3/7.4的配置运行完整的同态YuS评估：BGV和BFV，
+ * p ∈ {65537, 4298506241}，80/128位安全，N ∈ {16384, 32768}。
+ * 每个配置报告总时间、各阶段时间、吞吐量、最终噪声预算、常驻内存峰值和密文大小，
+ * 输出单个JSON对象；某个配置的参数不可行或评估失败时记录错误并继续。
+ * 任一配置评估失败或密钥流与明文实现不一致时以非零状态退出；
+ * 只有select_fhe_params找不到参数的配置和BGV的列式打包记为skipped，不算失败。
+ *
+ * 用法：yus_fhe_bench [选项]
+ *   --scheme bgv|bfv|all   同态方案（默认all）
+ *   --p P|all              素数模数（默认all）
+ *   --level 80|128|all     安全级别（默认all）
+ *   --n N|all              环维数（默认all）
+ *   --trunc M              截断位数（默认12）
+ *   --trials T             计时评估次数（默认3），另有一次带噪声遥测的预热评估
+ *   --threads T            同态评估工作线程数（默认0，即硬件并发数）
+ *   --packing row|column|both  槽打包方式（默认row）；column仅BFV，BGV的列式配置记为skipped
+ *   --mod-switch           每轮后丢弃一个模数（不超过模数链容量）
+ *   --trace-dir DIR        计时评估之后再做一次记录时间线的评估，写入
+ *                          DIR/yus_<scheme>_<p>_<level>_<N>[_column].json（Chrome trace-event格式）
+ *
+ * 以YUS_INSTRUMENT构建时，每个配置另外输出计时评估期间的插桩计数（同态乘法、重线性化、
+ * 模数切换次数和各阶段耗时）。以YUS_ALLOC_TRACKING构建时另外输出计时评估期间所有线程的
+ * 堆分配次数和字节数：每次评估的总数，以及stages中每个阶段（白化、各轮、最终层）的值。
+ *
+ * 吞吐量取FHEWrapper::get_throughput：行式打包一次评估生成slot_count()个块，
+ * 列式打包生成column_block_capacity()个块，每块36-trunc_m个字。
+ * --packing both时同一配置按两种打包各输出一条记录（packing字段），
+ * 按负载的块数比较两者的延迟、吞吐量和噪声预算后选择打包方式。
+ */
+
+#include "yus/fhe_wrapper.h"
+#include "yus/yus_core.h"
+#include "yus/timing.h"
+#include "yus/instrument.h"
+#include "yus/alloc_tracker.h"
+#include "yus/utils.h"
+#include "cli_utils.h"
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+using yus::cli::json_string;
+using yus::cli::parse_number;
+
+/// 技术文档表7.3/7.4使用的素数
+const char* const kTablePrimes[] = {"65537", "4298506241"};
+/// 技术文档表7.3/7.4使用的环维数
+const uint32_t kTableDegrees[] = {16384, 32768};
+/// 与明文实现逐元素比较的块数
+constexpr uint32_t kVerifyBlocks = 8;
+
+/**
+ * @struct BenchConfig
+ * @brief 单个基准配置
+ */
+struct BenchConfig {
+    yus::FHE_SCHEME scheme;         ///< 同态方案
+    mpz_class p;                    ///< 素数模数
+    uint32_t security_level;        ///< 安全级别（80或128位）
+    uint32_t poly_modulus_degree;   ///< 环维数N
+    yus::PackingMode packing;       ///< 槽打包方式
+};
+
+/**
+ * @struct BenchOptions
+ * @brief 所有配置共用的选项
+ */
+struct BenchOptions {
+    uint32_t trunc_m = 12;          ///< 截断位数
+    uint32_t trials = 3;            ///< 计时评估次数
+    uint32_t threads = 0;           ///< 工作线程数
+    bool mod_switch = false;        ///< 是否逐轮模数切换
+    std::string trace_dir;          ///< 时间线输出目录，为空时不记录
+};
+
+/**
+ * @class InfeasibleConfig
+ * @brief select_fhe_params找不到满足该配置的参数
+ *
+ * 只有这一种情况记为跳过；评估中抛出的std::invalid_argument（如模数切换计划不合法）记为错误。
+ */
+class InfeasibleConfig : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+/**
+ * @brief 按模数链容量生成逐轮模数切换计划
+ * @param rounds 轮数
+ * @param capacity 新鲜密文可丢弃的模数个数
+ * @return 白化后不切换，第1轮起每轮后丢弃一个模数，直到容量用完
+ */
+std::vector<uint32_t> per_round_schedule(uint32_t rounds, size_t capacity) {
+    std::vector<uint32_t> schedule(rounds + 1, 0);
+    for (uint32_t r = 1; r <= rounds && r <= capacity; ++r) {
+        schedule[r] = 1;
+    }
+    return schedule;
+}
+
+/**
+ * @brief 运行单个配置
+ * @param config 基准配置
+ * @param options 共用选项
+ * @param json 追加该配置的测量字段
+ * @return 前kVerifyBlocks个块的解密结果与明文实现一致时返回true
+ * @throws InfeasibleConfig 该配置的参数不可行时抛出异常
+ * @throws std::exception 评估失败时抛出异常
+ */
+bool run_config(const BenchConfig& config, const BenchOptions& options, std::ostringstream& json) {
+    const bool peak_reset = yus::reset_peak_rss();
+    const auto level = config.security_level == 80 ? yus::SecurityLevel::SEC80 : yus::SecurityLevel::SEC128;
+    const uint32_t rounds = static_cast<uint32_t>(level);
+    const bool column = config.packing == yus::PackingMode::COLUMN;
+    if (column && config.scheme == yus::FHE_SCHEME::BGV) {
+        throw InfeasibleConfig("Column-wise packing is only supported for BFV");
+    }
+
+    yus::FHEParams params;
+    try {
+        params = yus::select_fhe_params(config.scheme, config.p, config.security_level, rounds, 10,
+                                        config.packing, config.poly_modulus_degree);
+    } catch (const std::invalid_argument& e) {
+        throw InfeasibleConfig(e.what());
+    }
+    params.num_threads = options.threads;
+
+    yus::Timer timer;
+    timer.start();
+    yus::FHEWrapper fhe(config.scheme, params);
+    if (column) {
+        fhe.generate_column_galois_keys();
+    }
+    timer.stop();
+    const double setup_ms = timer.elapsed_ms();
+    const uint64_t setup_rss = yus::current_rss_bytes();
+
+    std::vector<mpz_class> master_key(36);
+    for (size_t i = 0; i < 36; ++i) {
+        master_key[i] = mpz_class(static_cast<unsigned long>(7919 * i + 13)) % config.p;
+    }
+    const std::vector<uint8_t> nonce{0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07};
+
+    std::vector<yus::Ciphertext> cipher_key;
+    timer.start();
+    if (column) {
+        fhe.encrypt_key_columnwise(master_key, cipher_key);
+    } else {
+        fhe.encrypt_key(master_key, cipher_key);
+    }
+    timer.stop();
+    const double encrypt_key_ms = timer.elapsed_ms();
+
+    std::vector<uint8_t> buffer;
+    const yus::SerializedSize key_size = fhe.save_ciphertexts(cipher_key, buffer);
+
+    yus::YuSEvalParams eval_params{nonce, level, options.trunc_m, 0, 0, {}};
+    if (options.mod_switch) {
+        eval_params.mod_switch_schedule = per_round_schedule(rounds, fhe.mod_switch_capacity());
+    }
+
+    // 按打包方式评估一次，列式打包填满column_block_capacity()个块
+    std::vector<yus::Ciphertext> cipher_ks;
+    auto evaluate = [&](yus::YuSEvalReport& eval_report) {
+        return column ? fhe.evaluate_yus_columnwise(cipher_key, eval_params, cipher_ks, eval_report)
+                      : fhe.evaluate_yus(cipher_key, {}, eval_params, cipher_ks, eval_report);
+    };
+
+    // 预热评估同时记录各阶段噪声；测量噪声需要解密，不计入计时评估
+    yus::YuSEvalReport report;
+    eval_params.noise_telemetry = true;
+    evaluate(report);
+    eval_params.noise_telemetry = false;
+
+    yus::SampleStats eval_ms;
+    yus::instrument_reset();
+    const auto alloc_before = yus::alloc_counts();
+    std::vector<yus::AllocCounts> stage_allocs;
+    for (uint32_t t = 0; t < options.trials; ++t) {
+        yus::YuSEvalReport trial_report;
+        eval_ms.add(evaluate(trial_report));
+        stage_allocs.resize(trial_report.alloc_stages.size());
+        for (size_t s = 0; s < stage_allocs.size(); ++s) {
+            stage_allocs[s] += trial_report.alloc_stages[s].allocs;
+        }
+    }
+    const auto allocs = yus::alloc_counts() - alloc_before;
+    const auto counters = yus::instrument_snapshot();
+
+    // 时间线单独评估一次，记录开销不计入计时评估
+    std::string trace_path;
+    if (!options.trace_dir.empty()) {
+        yus::TraceRecorder recorder;
+        yus::YuSEvalReport trace_report;
+        eval_params.trace = &recorder;
+        evaluate(trace_report);
+        eval_params.trace = nullptr;
+        trace_path = options.trace_dir + "/yus_" + (config.scheme == yus::FHE_SCHEME::BGV ? "bgv" : "bfv") + "_" +
+                     config.p.get_str() + "_" + std::to_string(config.security_level) + "_" +
+                     std::to_string(params.poly_modulus_degree) + (column ? "_column" : "") + ".json";
+        recorder.save(trace_path);
+    }
+
+    double final_noise = 0;
+    for (size_t i = 0; i < cipher_ks.size(); ++i) {
+        const double budget = fhe.noise_budget(cipher_ks[i]);
+        final_noise = i == 0 ? budget : std::min(final_noise, budget);
+    }
+    const yus::SerializedSize keystream_size = fhe.save_ciphertexts(cipher_ks, buffer);
+
+    const size_t nslots = fhe.slot_count();
+    const uint32_t blocks = static_cast<uint32_t>(column ? fhe.column_block_capacity(level) : nslots);
+    timer.start();
+    const auto decrypted = column ? fhe.decrypt_columnwise(cipher_ks, level, options.trunc_m, blocks)
+                                  : fhe.decrypt(cipher_ks);
+    timer.stop();
+    const double decrypt_ms = timer.elapsed_ms();
+
+    // 前kVerifyBlocks个块与明文实现逐元素比较：行式第i个密文的槽b为块b的第i个字，
+    // 列式的解密结果已按块顺序排列
+    const uint32_t words = 36 - options.trunc_m;
+    const uint32_t verify_blocks = std::min(kVerifyBlocks, blocks);
+    yus::YuSCipher cipher(config.p, level, options.trunc_m);
+    cipher.init(master_key, nonce);
+    const auto expected = cipher.generate_keystream(verify_blocks);
+    bool verified = decrypted.size() == static_cast<size_t>(words) * (column ? blocks : nslots);
+    for (uint32_t b = 0; verified && b < verify_blocks; ++b) {
+        for (uint32_t i = 0; i < words; ++i) {
+            const auto& word = column ? decrypted[b * words + i] : decrypted[i * nslots + b];
+            if (word != expected[b * words + i]) {
+                verified = false;
+                break;
+            }
+        }
+    }
+
+    json << ",\"n\":" << params.poly_modulus_degree << ",\"rounds\":" << rounds << ",\"trunc_m\":" << options.trunc_m
+         << ",\"threads\":" << options.threads << ",\"slots\":" << nslots << ",\"blocks\":" << blocks
+         << ",\"cipher_modulus_bits\":" << params.cipher_modulus_bits << ",\"coeff_modulus_bits\":[";
+    for (size_t i = 0; i < params.coeff_modulus_bits.size(); ++i) {
+        json << (i ? "," : "") << params.coeff_modulus_bits[i];
+    }
+    json << "],\"mod_switch_schedule\":[";
+    for (size_t i = 0; i < eval_params.mod_switch_schedule.size(); ++i) {
+        json << (i ? "," : "") << eval_params.mod_switch_schedule[i];
+    }
+    json << "],\"setup_ms\":" << setup_ms << ",\"encrypt_key_ms\":" << encrypt_key_ms
+         << ",\"eval_ms\":{\"min\":" << eval_ms.min() << ",\"median\":" << eval_ms.median()
+         << ",\"max\":" << eval_ms.max() << ",\"trials\":" << eval_ms.count() << "}"
+         << ",\"decrypt_ms\":" << decrypt_ms << ",\"stages\":[";
+    // 各阶段时间取自遥测评估，包含该阶段末尾的噪声测量；分配取自计时评估的平均值
+    double previous_ms = 0;
+    for (size_t s = 0; s < report.stages.size(); ++s) {
+        const auto& stage = report.stages[s];
+        json << (s ? "," : "") << "{\"stage\":" << json_string(stage.stage)
+             << ",\"ms\":" << stage.elapsed_ms - previous_ms << ",\"noise_budget_bits\":" << stage.noise_budget_bits
+             << ",\"modulus_bits\":" << stage.modulus_bits;
+        if (s < stage_allocs.size()) {
+            json << ",\"allocations\":" << static_cast<double>(stage_allocs[s].allocations) / options.trials
+                 << ",\"alloc_bytes\":" << static_cast<double>(stage_allocs[s].bytes) / options.trials;
+        }
+        json << "}";
+        previous_ms = stage.elapsed_ms;
+    }
+    json << "],\"throughput_kibps\":" << fhe.get_throughput(blocks, options.trunc_m, eval_ms.median())
+         << ",\"final_noise_budget_bits\":" << final_noise << ",\"setup_rss_bytes\":" << setup_rss
+         << ",\"peak_rss_bytes\":" << yus::peak_rss_bytes() << ",\"peak_rss_per_config\":"
+         << (peak_reset ? "true" : "false") << ",\"sizes\":{\"key_ciphertext_bytes\":"
+         << fhe.ciphertext_bytes(cipher_key.front()) << ",\"keystream_ciphertext_bytes\":"
+         << fhe.ciphertext_bytes(cipher_ks.front()) << ",\"key_upload_raw_bytes\":" << key_size.raw_bytes
+         << ",\"key_upload_stored_bytes\":" << key_size.stored_bytes << ",\"keystream_raw_bytes\":"
+         << keystream_size.raw_bytes << ",\"keystream_stored_bytes\":" << keystream_size.stored_bytes
+         << "},\"verified\":" << (verified ? "true" : "false");
+    if (yus::instrument_enabled()) {
+        json << ",\"counters\":" << counters.to_json();
+    }
+    if (yus::alloc_tracking_enabled()) {
+        const double per_eval = static_cast<double>(allocs.allocations) / options.trials;
+        const double bytes_per_eval = static_cast<double>(allocs.bytes) / options.trials;
+        json << ",\"allocations\":{\"per_eval\":" << per_eval << ",\"bytes_per_eval\":" << bytes_per_eval << "}";
+    }
+    if (!trace_path.empty()) {
+        json << ",\"trace\":" << json_string(trace_path);
+    }
+    return verified;
+}
+
+void usage() {
+    std::cerr << "Usage: yus_fhe_bench [--scheme bgv|bfv|all] [--p P|all] [--level 80|128|all] [--n N|all]\n"
+                 "                     [--packing row|column|both] [--trunc M] [--trials T] [--threads T]\n"
+                 "                     [--mod-switch] [--trace-dir DIR]"
+              << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::vector<yus::FHE_SCHEME> schemes{yus::FHE_SCHEME::BGV, yus::FHE_SCHEME::BFV};
+    std::vector<mpz_class> primes(std::begin(kTablePrimes), std::end(kTablePrimes));
+    std::vector<uint32_t> levels{80, 128};
+    std::vector<uint32_t> degrees(std::begin(kTableDegrees), std::end(kTableDegrees));
+    std::vector<yus::PackingMode> packings{yus::PackingMode::ROW};
+    BenchOptions options;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            if (arg == "--mod-switch") {
+                options.mod_switch = true;
+                continue;
+            }
+            if (i + 1 >= argc) {
+                usage();
+                return 2;
+            }
+            const std::string value = argv[++i];
+            if (arg == "--scheme") {
+                if (value == "bgv") {
+                    schemes = {yus::FHE_SCHEME::BGV};
+                } else if (value == "bfv") {
+                    schemes = {yus::FHE_SCHEME::BFV};
+                } else if (value != "all") {
+                    throw std::invalid_argument("--scheme must be bgv, bfv or all");
+                }
+            } else if (arg == "--p") {
+                if (value != "all") {
+                    primes = {mpz_class(value)};
+                }
+            } else if (arg == "--level") {
+                if (value != "all") {
+                    const unsigned long bits = parse_number("--level", value.c_str());
+                    if (bits != 80 && bits != 128) {
+                        throw std::invalid_argument("--level must be 80, 128 or all");
+                    }
+                    levels = {static_cast<uint32_t>(bits)};
+                }
+            } else if (arg == "--n") {
+                if (value != "all") {
+                    degrees = {static_cast<uint32_t>(parse_number("--n", value.c_str()))};
+                }
+            } else if (arg == "--packing") {
+                if (value == "row") {
+                    packings = {yus::PackingMode::ROW};
+                } else if (value == "column") {
+                    packings = {yus::PackingMode::COLUMN};
+                } else if (value == "both") {
+                    packings = {yus::PackingMode::ROW, yus::PackingMode::COLUMN};
+                } else {
+                    throw std::invalid_argument("--packing must be row, column or both");
+                }
+            } else if (arg == "--trunc") {
+                options.trunc_m = static_cast<uint32_t>(parse_number("--trunc", value.c_str()));
+            } else if (arg == "--trials") {
+                options.trials = static_cast<uint32_t>(parse_number("--trials", value.c_str()));
+            } else if (arg == "--threads") {
+                options.threads = static_cast<uint32_t>(parse_number("--threads", value.c_str()));
+            } else if (arg == "--trace-dir") {
+                options.trace_dir = value;
+            } else {
+                usage();
+                return 2;
+            }
+        }
+        if (options.trunc_m >= 36 || options.trials == 0) {
+            throw std::invalid_argument("Need trunc < 36 and trials > 0");
+        }
+        if (!options.trace_dir.empty()) {
+            std::filesystem::create_directories(options.trace_dir);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[yus_fhe_bench] " << e.what() << std::endl;
+        usage();
+        return 2;
+    }
+
+    // 逐个配置运行，完成一个就打印进度到stderr，JSON最后一次性输出到stdout
+    std::vector<std::string> records;
+    bool failed = false;
+    for (auto scheme : schemes) {
+        for (const auto& p : primes) {
+            for (uint32_t level : levels) {
+                for (uint32_t n : degrees) {
+                    for (auto packing : packings) {
+                        const char* scheme_name = scheme == yus::FHE_SCHEME::BGV ? "BGV" : "BFV";
+                        const char* packing_name = packing == yus::PackingMode::COLUMN ? "column" : "row";
+                        std::ostringstream json;
+                        json << "{\"scheme\":\"" << scheme_name << "\",\"packing\":\"" << packing_name
+                             << "\",\"p\":\"" << p.get_str() << "\",\"level\":" << level << ",\"requested_n\":" << n;
+                        std::cerr << "[yus_fhe_bench] " << scheme_name << " " << packing_name << " p=" << p.get_str()
+                                  << " level=" << level << " N=" << n << " ..." << std::flush;
+                        try {
+                            const bool verified = run_config({scheme, p, level, n, packing}, options, json);
+                            failed = failed || !verified;
+                            std::cerr << (verified ? " done" : " keystream mismatch") << std::endl;
+                        } catch (const InfeasibleConfig& e) {
+                            json << ",\"skipped\":" << json_string(e.what());
+                            std::cerr << " skipped: " << e.what() << std::endl;
+                        } catch (const std::exception& e) {
+                            failed = true;
+                            json << ",\"error\":" << json_string(e.what());
+                            std::cerr << " " << e.what() << std::endl;
+                        }
+                        json << "}";
+                        records.push_back(json.str());
+                    }
+                }
+            }
+        }
+    }
+
+    std::cout << "{\"mod_switch\":" << (options.mod_switch ? "true" : "false") << ",\"configs\":[";
+    for (size_t i = 0; i < records.size(); ++i) {
+        std::cout << (i ? ",\n" : "\n") << records[i];
+    }
+    std::cout << "\n]}" << std::endl;
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,302 @@
+/**
+ * @file yus_scaling.cpp
+ * @brief YuS流密码线程数与数据规模扫描基准
+ * @author Aurorp1g
+ * @date 2025-11-07
+ *
+ * 明文密钥流生成按线程数（1, 2, 4, ..., nproc）和块数（1, 4, 16, ..., max-blocks）扫描，
+ * 线程数通过omp_set_num_threads控制S盒层和线性层中的OpenMP并行区；
+ * 同态评估（--fhe）按线程数扫描线程池大小，密钥只生成一次，保存后按线程数重新加载。
+ *
+ * 每个组合输出一行CSV（stdout）：吞吐量、相对单线程的加速比和并行效率（加速比/线程数）。
+ * 扫描结束后在stderr给出交叉点：多线程开始快于单线程的最小块数和线程数；
+ * 细粒度并行区开销超过收益时报告"never"，用于发现线程越多越慢的回归。
+ *
+ * 用法：yus_scaling [选项] > scaling.csv
+ *   --p P              素数模数（默认65537）
+ *   --level 80|128     安全级别（默认80）
+ *   --trunc M          截断位数（默认12）
+ *   --max-threads T    最大线程数（默认硬件并发数）
+ *   --max-blocks B     最大块数（默认65536，完整扫描用1048576）
+ *   --block-step K     块数的公比（默认4）
+ *   --min-time-ms MS   每个组合至少重复运行的总时间（默认200）
+ *   --fhe              另外扫描同态评估的线程数（需要FHE支持）
+ *   --scheme bgv|bfv   同态方案（默认bfv）
+ *   --n N              同态评估的环维数（默认0，自动选择）
+ *   --fhe-trials T     每个线程数的同态评估次数（默认1）
+ *
+ * 吞吐量经yus::throughput_kibps（utils.h）换算，与FHEWrapper::get_throughput口径一致。
+ */
+
+#include "yus/yus_core.h"
+#include "yus/timing.h"
+#include "yus/utils.h"
+#ifdef ENABLE_FHE
+#include "yus/fhe_wrapper.h"
+#endif
+#include "cli_utils.h"
+#include <algorithm>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace {
+
+using yus::cli::parse_number;
+
+/**
+ * @struct ScalingPoint
+ * @brief 单个（线程数，块数）组合的测量结果
+ */
+struct ScalingPoint {
+    std::string workload;   ///< 负载名，例如"keystream"、"fhe_bfv"
+    uint32_t threads;       ///< 线程数
+    uint32_t blocks;        ///< 块数
+    size_t runs;            ///< 运行次数
+    double median_ms;       ///< 单次运行时间的中位数（毫秒）
+    double kibps;           ///< 吞吐量（KiB/s）
+    double speedup;         ///< 相对同块数单线程的加速比
+};
+
+/**
+ * @brief 扫描的线程数：1、2、4……以及max_threads本身
+ */
+std::vector<uint32_t> thread_counts(uint32_t max_threads) {
+    std::vector<uint32_t> counts;
+    for (uint32_t t = 1; t < max_threads; t *= 2) {
+        counts.push_back(t);
+    }
+    counts.push_back(max_threads);
+    return counts;
+}
+
+/**
+ * @brief 输出一行CSV
+ */
+void print_row(const ScalingPoint& point) {
+    std::cout << point.workload << "," << point.threads << "," << point.blocks << "," << point.runs << ","
+              << std::fixed << std::setprecision(3) << point.median_ms << "," << point.kibps << ","
+              << point.speedup << "," << point.speedup / point.threads << std::endl;
+}
+
+/**
+ * @brief 在stderr报告交叉点
+ * @param points 同一负载的测量结果，按块数分组，组内第一项为单线程
+ */
+void report_crossover(const std::vector<ScalingPoint>& points) {
+    if (points.empty()) {
+        return;
+    }
+    if (points.back().threads == 1) {
+        std::cerr << "[yus_scaling] " << points.front().workload << ": only one thread swept, no crossover"
+                  << std::endl;
+        return;
+    }
+    for (const auto& point : points) {
+        if (point.threads > 1 && point.speedup > 1.0) {
+            std::cerr << "[yus_scaling] " << point.workload << ": parallelism pays off from " << point.blocks
+                      << " blocks at " << point.threads << " threads (speed-up " << std::setprecision(2)
+                      << point.speedup << ")" << std::endl;
+            return;
+        }
+    }
+    std::cerr << "[yus_scaling] " << points.front().workload
+              << ": parallelism never pays off, more threads are never faster than one" << std::endl;
+}
+
+/**
+ * @brief 设置明文路径OpenMP并行区的线程数
+ */
+void set_plaintext_threads(uint32_t threads) {
+#ifdef _OPENMP
+    omp_set_num_threads(static_cast<int>(threads));
+#else
+    (void)threads;
+#endif
+}
+
+void usage() {
+    std::cerr << "Usage: yus_scaling [--p P] [--level 80|128] [--trunc M] [--max-threads T] [--max-blocks B]\n"
+                 "                   [--block-step K] [--min-time-ms MS] [--fhe] [--scheme bgv|bfv] [--n N]\n"
+                 "                   [--fhe-trials T]"
+              << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    mpz_class p(65537);
+    yus::SecurityLevel level = yus::SecurityLevel::SEC80;
+    uint32_t trunc_m = 12;
+    uint32_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+    uint32_t max_blocks = 65536;
+    uint32_t block_step = 4;
+    double min_time_ms = 200;
+    bool fhe = false;
+    std::string scheme_name = "bfv";
+    uint32_t ring_dim = 0;
+    uint32_t fhe_trials = 1;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            if (arg == "--fhe") {
+                fhe = true;
+                continue;
+            }
+            if (i + 1 >= argc) {
+                usage();
+                return 2;
+            }
+            const char* value = argv[++i];
+            if (arg == "--p") {
+                p = mpz_class(value);
+            } else if (arg == "--level") {
+                const unsigned long bits = parse_number("--level", value);
+                if (bits != 80 && bits != 128) {
+                    throw std::invalid_argument("--level must be 80 or 128");
+                }
+                level = bits == 80 ? yus::SecurityLevel::SEC80 : yus::SecurityLevel::SEC128;
+            } else if (arg == "--trunc") {
+                trunc_m = static_cast<uint32_t>(parse_number("--trunc", value));
+            } else if (arg == "--max-threads") {
+                max_threads = static_cast<uint32_t>(parse_number("--max-threads", value));
+            } else if (arg == "--max-blocks") {
+                max_blocks = static_cast<uint32_t>(parse_number("--max-blocks", value));
+            } else if (arg == "--block-step") {
+                block_step = static_cast<uint32_t>(parse_number("--block-step", value));
+            } else if (arg == "--min-time-ms") {
+                min_time_ms = std::stod(value);
+            } else if (arg == "--scheme") {
+                scheme_name = value;
+                if (scheme_name != "bgv" && scheme_name != "bfv") {
+                    throw std::invalid_argument("--scheme must be bgv or bfv");
+                }
+            } else if (arg == "--n") {
+                ring_dim = static_cast<uint32_t>(parse_number("--n", value));
+            } else if (arg == "--fhe-trials") {
+                fhe_trials = static_cast<uint32_t>(parse_number("--fhe-trials", value));
+            } else {
+                usage();
+                return 2;
+            }
+        }
+        if (trunc_m >= 36 || max_threads == 0 || max_blocks == 0 || block_step < 2 || fhe_trials == 0) {
+            throw std::invalid_argument("Need trunc < 36, max-threads > 0, max-blocks > 0, block-step >= 2 "
+                                        "and fhe-trials > 0");
+        }
+#ifndef ENABLE_FHE
+        if (fhe) {
+            throw std::invalid_argument("--fhe requires a build with FHE support");
+        }
+        (void)ring_dim;
+#endif
+    } catch (const std::exception& e) {
+        std::cerr << "[yus_scaling] " << e.what() << std::endl;
+        usage();
+        return 2;
+    }
+
+    try {
+        const auto threads = thread_counts(max_threads);
+        std::vector<mpz_class> master_key(36);
+        for (size_t i = 0; i < 36; ++i) {
+            master_key[i] = mpz_class(static_cast<unsigned long>(7919 * i + 13)) % p;
+        }
+        const std::vector<uint8_t> nonce{0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07};
+
+        std::cout << "workload,threads,blocks,runs,median_ms,throughput_kibps,speedup,efficiency" << std::endl;
+
+        // 明文密钥流：块数从小到大，同一块数下先测单线程作为加速比基准
+        std::vector<ScalingPoint> keystream_points;
+        yus::YuSCipher cipher(p, level, trunc_m);
+        cipher.init(master_key, nonce);
+        for (uint64_t blocks = 1; blocks <= max_blocks; blocks *= block_step) {
+            double single_ms = 0;
+            for (uint32_t t : threads) {
+                set_plaintext_threads(t);
+                cipher.generate_keystream(1);
+                yus::SampleStats ms;
+                yus::Timer timer;
+                double total_ms = 0;
+                do {
+                    timer.start();
+                    cipher.generate_keystream(static_cast<uint32_t>(blocks));
+                    timer.stop();
+                    ms.add(timer.elapsed_ms());
+                    total_ms += timer.elapsed_ms();
+                } while (total_ms < min_time_ms);
+                const double median = ms.median();
+                if (t == 1) {
+                    single_ms = median;
+                }
+                keystream_points.push_back({"keystream", t, static_cast<uint32_t>(blocks), ms.count(), median,
+                                            yus::throughput_kibps(p, static_cast<double>(blocks) * (36 - trunc_m),
+                                                                  median),
+                                            median > 0 ? single_ms / median : 0.0});
+                print_row(keystream_points.back());
+            }
+        }
+        set_plaintext_threads(max_threads);
+        report_crossover(keystream_points);
+
+#ifdef ENABLE_FHE
+        if (fhe) {
+            // 密钥只生成一次；按线程数重新加载，线程池大小在加载时确定
+            const auto scheme = scheme_name == "bgv" ? yus::FHE_SCHEME::BGV : yus::FHE_SCHEME::BFV;
+            const uint32_t rounds = static_cast<uint32_t>(level);
+            auto params = yus::select_fhe_params(scheme, p, rounds == 5 ? 80 : 128, rounds, 10,
+                                                 yus::PackingMode::ROW, ring_dim);
+            params.num_threads = max_threads;
+            const auto key_dir = std::filesystem::temp_directory_path() /
+                                 ("yus_scaling_keys_" + std::to_string(yus::steady_ns()));
+            {
+                yus::FHEWrapper keygen(scheme, params);
+                keygen.save(key_dir.string());
+            }
+
+            std::vector<ScalingPoint> fhe_points;
+            double single_ms = 0;
+            try {
+                for (uint32_t t : threads) {
+                    yus::FHEWrapper wrapper(key_dir.string(), false, t);
+                    std::vector<yus::Ciphertext> cipher_key;
+                    std::vector<yus::Ciphertext> cipher_ks;
+                    wrapper.encrypt_key(master_key, cipher_key);
+                    const yus::YuSEvalParams eval_params{nonce, level, trunc_m, 0, 0, {}};
+                    yus::SampleStats ms;
+                    for (uint32_t k = 0; k < fhe_trials; ++k) {
+                        ms.add(wrapper.evaluate_yus(cipher_key, eval_params, cipher_ks));
+                    }
+                    const double median = ms.median();
+                    if (t == 1) {
+                        single_ms = median;
+                    }
+                    const uint32_t blocks = static_cast<uint32_t>(wrapper.slot_count());
+                    fhe_points.push_back({"fhe_" + scheme_name, t, blocks, ms.count(), median,
+                                          wrapper.get_throughput(blocks, trunc_m, median),
+                                          median > 0 ? single_ms / median : 0.0});
+                    print_row(fhe_points.back());
+                }
+            } catch (...) {
+                std::filesystem::remove_all(key_dir);
+                throw;
+            }
+            std::filesystem::remove_all(key_dir);
+            report_crossover(fhe_points);
+        }
+#endif
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "[yus_scaling] " << e.what() << std::endl;
+        return 1;
+    }
+}
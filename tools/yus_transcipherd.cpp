@@ -0,0 +1,431 @@
+/**
+ * @file yus_transcipherd.cpp
+ * @brief YuS流密码本地转密守护进程
+ * @author Aurorp1g
+ * @date 2025-11-07
+ *
+ * 在Unix域套接字上接收客户端的加密主密钥和YuS对称密文，
+ * 经TranscipherBatcher合批后评估，返回数据的FHE密文。
+ *
+ * 用法：yus_transcipherd <key_dir> <socket_path> [选项]
+ *   --level 80|128         安全级别（默认80）
+ *   --trunc M              截断位数（默认12）
+ *   --deadline-ms T        请求最长排队时间（默认50）
+ *   --max-queued-blocks B  待处理块数上限，超过时应答BUSY（默认4·slot_count()）
+ *   --threads N            评估线程数（默认硬件并发数）
+ *
+ * 协议（整数均为小端）：每个请求以1字节操作码开头，同一连接可连续发送多个请求。
+ *   'K' 注册密钥：u32 id长度, id, u64 长度, encrypt_key_symmetric/save_ciphertexts的输出
+ *       应答：u8 状态
+ *   'T' 转密：u32 id长度, id, u32 随机数长度, 随机数, u32 首块, u64 字数n, n个u64
+ *       应答：u8 状态；成功时再跟u64 first_slot, u64 blocks, u64 batch_blocks,
+ *             f64 queue_ms, f64 service_ms, f64 latency_ms, u64 长度, save_ciphertexts的输出
+ *   'S' 统计：应答u8 状态, u32 长度, 单行JSON
+ * 状态：0成功；1 BUSY（背压，稍后重试）；2错误，后跟u32长度和错误信息。
+ */
+
+#include "yus/fhe_wrapper.h"
+#include "yus/transcipher_batcher.h"
+#include "cli_utils.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+using yus::cli::parse_number;
+
+constexpr uint8_t kStatusOk = 0;
+constexpr uint8_t kStatusBusy = 1;
+constexpr uint8_t kStatusError = 2;
+
+std::atomic<bool> g_stop{false};
+
+void handle_signal(int) {
+    g_stop = true;
+}
+
+/**
+ * @brief 读满len字节
+ * @return 对端关闭连接时返回false
+ * @throws std::runtime_error 当读取出错时抛出异常
+ */
+bool read_exact(int fd, void* buf, size_t len) {
+    auto* p = static_cast<char*>(buf);
+    while (len > 0) {
+        ssize_t r = ::read(fd, p, len);
+        if (r == 0) {
+            return false;
+        }
+        if (r < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error(std::string("read: ") + std::strerror(errno));
+        }
+        p += r;
+        len -= static_cast<size_t>(r);
+    }
+    return true;
+}
+
+/**
+ * @brief 写满len字节
+ * @throws std::runtime_error 当写入出错时抛出异常
+ */
+void write_exact(int fd, const void* buf, size_t len) {
+    const auto* p = static_cast<const char*>(buf);
+    while (len > 0) {
+        ssize_t w = ::send(fd, p, len, MSG_NOSIGNAL);
+        if (w < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error(std::string("write: ") + std::strerror(errno));
+        }
+        p += w;
+        len -= static_cast<size_t>(w);
+    }
+}
+
+/**
+ * @brief 读取小端整数
+ * @throws std::runtime_error 当连接中途关闭时抛出异常
+ */
+template <typename T>
+T read_le(int fd) {
+    unsigned char bytes[sizeof(T)];
+    if (!read_exact(fd, bytes, sizeof(T))) {
+        throw std::runtime_error("Connection closed mid-request");
+    }
+    T v = 0;
+    for (size_t k = 0; k < sizeof(T); ++k) {
+        v |= static_cast<T>(bytes[k]) << (8 * k);
+    }
+    return v;
+}
+
+/**
+ * @brief 一次读入n个小端uint64_t
+ * @param words 输出，大小为n
+ * @throws std::runtime_error 当连接中途关闭时抛出异常
+ *
+ * 整段载荷用一次read_exact读入words的存储，再原地按小端解码（小端主机上解码不改变数值）。
+ */
+void read_le_words(int fd, std::vector<uint64_t>& words) {
+    if (words.empty()) {
+        return;
+    }
+    if (!read_exact(fd, words.data(), words.size() * sizeof(uint64_t))) {
+        throw std::runtime_error("Connection closed mid-request");
+    }
+    const auto* bytes = reinterpret_cast<const unsigned char*>(words.data());
+    for (size_t i = 0; i < words.size(); ++i) {
+        uint64_t v = 0;
+        for (size_t k = 0; k < sizeof(uint64_t); ++k) {
+            v |= static_cast<uint64_t>(bytes[i * sizeof(uint64_t) + k]) << (8 * k);
+        }
+        words[i] = v;
+    }
+}
+
+/**
+ * @brief 追加小端整数到应答缓冲区
+ */
+template <typename T>
+void put_le(std::string& out, T v) {
+    for (size_t k = 0; k < sizeof(T); ++k) {
+        out.push_back(static_cast<char>(static_cast<uint64_t>(v) >> (8 * k)));
+    }
+}
+
+/**
+ * @brief 追加双精度浮点数到应答缓冲区
+ */
+void put_f64(std::string& out, double v) {
+    uint64_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    put_le<uint64_t>(out, bits);
+}
+
+/**
+ * @brief 读取带u32长度前缀的字节串
+ * @param limit 允许的最大长度
+ */
+std::string read_string(int fd, size_t limit) {
+    const uint32_t len = read_le<uint32_t>(fd);
+    if (len > limit) {
+        throw std::runtime_error("Field exceeds " + std::to_string(limit) + " bytes");
+    }
+    std::string s(len, '\0');
+    if (len > 0 && !read_exact(fd, &s[0], len)) {
+        throw std::runtime_error("Connection closed mid-request");
+    }
+    return s;
+}
+
+/**
+ * @brief 构造错误应答
+ */
+std::string error_reply(const std::string& message) {
+    std::string out(1, static_cast<char>(kStatusError));
+    put_le<uint32_t>(out, static_cast<uint32_t>(message.size()));
+    out += message;
+    return out;
+}
+
+/**
+ * @struct Daemon
+ * @brief 守护进程共享状态
+ */
+struct Daemon {
+    yus::FHEWrapper& fhe;
+    yus::TranscipherBatcher& batcher;
+    size_t max_words;                 ///< 单个请求的最大字数（一批）
+    std::mutex mutex;                 ///< 保护连接集合
+    std::condition_variable idle;     ///< 最后一个连接关闭时通知
+    std::set<int> connections;        ///< 打开的连接
+};
+
+/**
+ * @brief 处理注册密钥请求
+ */
+std::string handle_key(Daemon& d, int fd) {
+    const std::string key_id = read_string(fd, 256);
+    const uint64_t len = read_le<uint64_t>(fd);
+    if (len > (uint64_t(1) << 32)) {
+        throw std::runtime_error("Key upload too large");
+    }
+    // 按块读入，缓冲区只随实际收到的字节增长，不按客户端声明的长度一次分配
+    constexpr size_t kChunkBytes = size_t(1) << 20;
+    std::vector<uint8_t> blob;
+    while (blob.size() < len) {
+        const size_t offset = blob.size();
+        blob.resize(offset + static_cast<size_t>(std::min<uint64_t>(kChunkBytes, len - offset)));
+        if (!read_exact(fd, blob.data() + offset, blob.size() - offset)) {
+            throw std::runtime_error("Connection closed mid-request");
+        }
+    }
+    std::vector<yus::Ciphertext> cipher_key;
+    d.fhe.load_key(blob.data(), blob.size(), cipher_key);
+    d.batcher.add_key(key_id, std::move(cipher_key));
+    return std::string(1, static_cast<char>(kStatusOk));
+}
+
+/**
+ * @brief 处理转密请求，阻塞到所在批次评估完成
+ */
+std::string handle_transcipher(Daemon& d, int fd) {
+    yus::TranscipherRequest request;
+    request.key_id = read_string(fd, 256);
+    const std::string nonce = read_string(fd, 256);
+    request.nonce.assign(nonce.begin(), nonce.end());
+    request.first_block = read_le<uint32_t>(fd);
+    const uint64_t n = read_le<uint64_t>(fd);
+    if (n > d.max_words) {
+        throw std::runtime_error("Request exceeds one batch (" + std::to_string(d.max_words) + " words)");
+    }
+    request.sym_ct.resize(static_cast<size_t>(n));
+    read_le_words(fd, request.sym_ct);
+
+    std::future<yus::TranscipherReply> future;
+    if (!d.batcher.submit(std::move(request), future)) {
+        return std::string(1, static_cast<char>(kStatusBusy));
+    }
+    yus::TranscipherReply reply = future.get();
+
+    std::ostringstream blob(std::ios::binary);
+    d.fhe.save_ciphertexts(reply.cipher_data, blob);
+    const std::string bytes = blob.str();
+
+    std::string out(1, static_cast<char>(kStatusOk));
+    put_le<uint64_t>(out, reply.first_slot);
+    put_le<uint64_t>(out, reply.blocks);
+    put_le<uint64_t>(out, reply.batch_blocks);
+    put_f64(out, reply.queue_ms);
+    put_f64(out, reply.service_ms);
+    put_f64(out, reply.latency_ms);
+    put_le<uint64_t>(out, bytes.size());
+    out += bytes;
+    return out;
+}
+
+/**
+ * @brief 统计信息的单行JSON
+ */
+std::string stats_json(const yus::TranscipherBatcher::Stats& s) {
+    std::ostringstream json;
+    json << "{\"requests\":" << s.requests << ",\"rejected\":" << s.rejected << ",\"failed\":" << s.failed
+         << ",\"batches\":" << s.batches << ",\"full_batches\":" << s.full_batches
+         << ",\"slot_fill\":" << (s.total_slots ? double(s.filled_slots) / double(s.total_slots) : 0.0)
+         << ",\"mean_latency_ms\":" << (s.requests ? s.latency_sum_ms / double(s.requests) : 0.0)
+         << ",\"max_latency_ms\":" << s.latency_max_ms << ",\"queued_blocks\":" << s.queued_blocks << "}";
+    return json.str();
+}
+
+/**
+ * @brief 连接处理循环
+ */
+void serve_connection(Daemon& d, int fd) {
+    try {
+        uint8_t op;
+        while (read_exact(fd, &op, 1)) {
+            std::string reply;
+            try {
+                if (op == 'K') {
+                    reply = handle_key(d, fd);
+                } else if (op == 'T') {
+                    reply = handle_transcipher(d, fd);
+                } else if (op == 'S') {
+                    const std::string json = stats_json(d.batcher.stats());
+                    reply.assign(1, static_cast<char>(kStatusOk));
+                    put_le<uint32_t>(reply, static_cast<uint32_t>(json.size()));
+                    reply += json;
+                } else {
+                    reply = error_reply("Unknown operation");
+                    write_exact(fd, reply.data(), reply.size());
+                    break;
+                }
+            } catch (const std::invalid_argument& e) {
+                // 请求已完整读取但不合法，连接可继续使用
+                reply = error_reply(e.what());
+            } catch (const std::runtime_error& e) {
+                // 超长字段或数据错误时请求体可能未读完：应答后关闭连接，避免协议失步
+                reply = error_reply(e.what());
+                write_exact(fd, reply.data(), reply.size());
+                break;
+            }
+            write_exact(fd, reply.data(), reply.size());
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[transcipherd] connection error: " << e.what() << std::endl;
+    }
+    std::lock_guard<std::mutex> lock(d.mutex);
+    ::close(fd);
+    d.connections.erase(fd);
+    if (d.connections.empty()) {
+        d.idle.notify_all();
+    }
+}
+
+void usage() {
+    std::cerr << "Usage: yus_transcipherd <key_dir> <socket_path> [--level 80|128] [--trunc M]\n"
+                 "                        [--deadline-ms T] [--max-queued-blocks B] [--threads N]"
+              << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        usage();
+        return 2;
+    }
+    const std::string key_dir = argv[1];
+    const std::string socket_path = argv[2];
+    yus::SecurityLevel level = yus::SecurityLevel::SEC80;
+    uint32_t trunc_m = 12;
+    uint32_t threads = 0;
+    yus::TranscipherBatcher::Options options;
+
+    try {
+        for (int i = 3; i < argc; ++i) {
+            const std::string arg = argv[i];
+            if (i + 1 >= argc) {
+                usage();
+                return 2;
+            }
+            const char* value = argv[++i];
+            if (arg == "--level") {
+                const unsigned long bits = parse_number("--level", value);
+                if (bits != 80 && bits != 128) {
+                    throw std::invalid_argument("--level must be 80 or 128");
+                }
+                level = bits == 80 ? yus::SecurityLevel::SEC80 : yus::SecurityLevel::SEC128;
+            } else if (arg == "--trunc") {
+                trunc_m = static_cast<uint32_t>(parse_number("--trunc", value));
+            } else if (arg == "--deadline-ms") {
+                options.deadline = std::chrono::milliseconds(parse_number("--deadline-ms", value));
+            } else if (arg == "--max-queued-blocks") {
+                options.max_queued_blocks = parse_number("--max-queued-blocks", value);
+            } else if (arg == "--threads") {
+                threads = static_cast<uint32_t>(parse_number("--threads", value));
+            } else {
+                usage();
+                return 2;
+            }
+        }
+
+        // 服务端只持有公钥和重线性化密钥
+        yus::FHEWrapper fhe(key_dir, true, threads);
+        yus::TranscipherBatcher batcher(fhe, level, trunc_m, options);
+        Daemon daemon{fhe, batcher, fhe.slot_count() * batcher.words_per_block(), {}, {}, {}};
+
+        int listen_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listen_fd < 0) {
+            throw std::runtime_error(std::string("socket: ") + std::strerror(errno));
+        }
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (socket_path.size() >= sizeof(addr.sun_path)) {
+            throw std::invalid_argument("Socket path too long");
+        }
+        std::strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+        ::unlink(socket_path.c_str());
+        if (::bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+            ::listen(listen_fd, 64) < 0) {
+            throw std::runtime_error(std::string("bind/listen: ") + std::strerror(errno));
+        }
+
+        std::signal(SIGINT, handle_signal);
+        std::signal(SIGTERM, handle_signal);
+        std::cout << "[transcipherd] listening on " << socket_path << ", " << fhe.slot_count()
+                  << " blocks per batch, deadline " << options.deadline.count() << " ms" << std::endl;
+
+        while (!g_stop) {
+            pollfd pfd{listen_fd, POLLIN, 0};
+            if (::poll(&pfd, 1, 200) <= 0) {
+                continue;
+            }
+            int fd = ::accept(listen_fd, nullptr, nullptr);
+            if (fd < 0) {
+                continue;
+            }
+            std::lock_guard<std::mutex> lock(daemon.mutex);
+            daemon.connections.insert(fd);
+            std::thread(serve_connection, std::ref(daemon), fd).detach();
+        }
+
+        // 停止接收，评估剩余请求，再断开仍在等待新请求的连接
+        ::close(listen_fd);
+        ::unlink(socket_path.c_str());
+        batcher.stop();
+        {
+            std::unique_lock<std::mutex> lock(daemon.mutex);
+            for (int fd : daemon.connections) {
+                ::shutdown(fd, SHUT_RDWR);
+            }
+            daemon.idle.wait(lock, [&] { return daemon.connections.empty(); });
+        }
+        std::cout << "[transcipherd] " << stats_json(batcher.stats()) << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "[transcipherd] " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}